@@ -0,0 +1,227 @@
+/**
+ * Account Store for Fraud Detection System
+ * Growable account table with an open-addressing index keyed on accNo
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "account_store.h"
+
+#define INITIAL_ACCOUNT_CAPACITY 16
+#define EMPTY_SLOT -1
+#define SECONDS_PER_DAY 86400
+
+AccountStore accountStore;
+
+// Account types are few, so a short array beats any hash
+static const char *accountTypes[MAX_ACCOUNT_TYPES] = {""};
+static int accountTypesUsed = 1;
+static pthread_mutex_t accountTypeLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Fibonacci hashing, folded so the masked low bits see the high-bit mix
+ */
+static inline uint32_t hashAccNo(int accNo) {
+    uint32_t h = (uint32_t)accNo * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+static int allocateSlots(AccountStore *store, int slotCount) {
+    AccountSlot *slots = malloc((size_t)slotCount * sizeof(AccountSlot));
+    if (!slots) return 0;
+
+    for (int i = 0; i < slotCount; i++) {
+        slots[i].index = EMPTY_SLOT;
+    }
+
+    free(store->slots);
+    store->slots = slots;
+    store->slotMask = slotCount - 1;
+
+    // Re-index every account into the new table
+    for (int i = 0; i < store->count; i++) {
+        uint32_t pos = hashAccNo(store->accounts[i].accNo) & store->slotMask;
+        while (slots[pos].index != EMPTY_SLOT) {
+            pos = (pos + 1) & store->slotMask;
+        }
+        slots[pos].accNo = store->accounts[i].accNo;
+        slots[pos].index = i;
+    }
+    return 1;
+}
+
+/**
+ * Prepare an empty store sized for the expected number of accounts
+ */
+void initAccountStore(AccountStore *store, int expectedAccounts) {
+    memset(store, 0, sizeof(*store));
+
+    int capacity = INITIAL_ACCOUNT_CAPACITY;
+    while (capacity < expectedAccounts) capacity *= 2;
+
+    store->accounts = malloc((size_t)capacity * sizeof(Account));
+    store->capacity = store->accounts ? capacity : 0;
+
+    // Keep the load factor at or below one half
+    allocateSlots(store, capacity * 2);
+}
+
+void freeAccountStore(AccountStore *store) {
+    free(store->accounts);
+    free(store->slots);
+    memset(store, 0, sizeof(*store));
+}
+
+Account *findAccount(const AccountStore *store, int accNo) {
+    if (!store->slots) return NULL;
+
+    uint32_t pos = hashAccNo(accNo) & store->slotMask;
+    while (store->slots[pos].index != EMPTY_SLOT) {
+        if (store->slots[pos].accNo == accNo) {
+            return &store->accounts[store->slots[pos].index];
+        }
+        pos = (pos + 1) & store->slotMask;
+    }
+    return NULL;
+}
+
+int internAccountType(const char *name) {
+    if (!name || !name[0]) return 0;
+
+    pthread_mutex_lock(&accountTypeLock);
+    int typeId = 0;
+    for (int i = 1; i < accountTypesUsed; i++) {
+        if (strcmp(accountTypes[i], name) == 0) {
+            typeId = i;
+            break;
+        }
+    }
+    if (typeId == 0 && accountTypesUsed < MAX_ACCOUNT_TYPES) {
+        // Names are interned in stringArena (or literals) and outlive the store
+        typeId = accountTypesUsed;
+        accountTypes[accountTypesUsed++] = name;
+    }
+    pthread_mutex_unlock(&accountTypeLock);
+    return typeId;
+}
+
+const char *accountTypeName(int typeId) {
+    return (typeId > 0 && typeId < accountTypesUsed) ? accountTypes[typeId] : "unknown";
+}
+
+int accountTypeCount() {
+    return accountTypesUsed;
+}
+
+Account *addAccount(AccountStore *store, const Account *account) {
+    if (!store->slots) initAccountStore(store, 0);
+
+    // Only the fields accounts.json carries are replaced; the velocity
+    // ring, spend counters and profile built from history are kept
+    Account *existing = findAccount(store, account->accNo);
+    if (existing) {
+        store->activeCount += (account->isActive != 0) - (existing->isActive != 0);
+        existing->name = account->name;
+        existing->balance = account->balance;
+        existing->lastLocation = account->lastLocation;
+        existing->lastTxnTime = account->lastTxnTime;
+        existing->isActive = account->isActive;
+        existing->accountType = account->accountType;
+        existing->accountTypeId = (uint8_t)internAccountType(account->accountType);
+        existing->dailyLimit = account->dailyLimit;
+        existing->monthlyLimit = account->monthlyLimit;
+        return existing;
+    }
+
+    if (store->count >= store->capacity) {
+        int newCapacity = (store->capacity > 0) ? store->capacity * 2 : INITIAL_ACCOUNT_CAPACITY;
+        Account *grown = realloc(store->accounts, (size_t)newCapacity * sizeof(Account));
+        if (!grown) return NULL;
+        store->accounts = grown;
+        store->capacity = newCapacity;
+    }
+
+    if ((store->count + 1) * 2 > store->slotMask + 1) {
+        if (!allocateSlots(store, (store->slotMask + 1) * 2)) return NULL;
+    }
+
+    int index = store->count++;
+    store->accounts[index] = *account;
+    store->accounts[index].accountTypeId = (uint8_t)internAccountType(account->accountType);
+    if (account->isActive) store->activeCount++;
+
+    uint32_t pos = hashAccNo(account->accNo) & store->slotMask;
+    while (store->slots[pos].index != EMPTY_SLOT) {
+        pos = (pos + 1) & store->slotMask;
+    }
+    store->slots[pos].accNo = account->accNo;
+    store->slots[pos].index = index;
+
+    return &store->accounts[index];
+}
+
+void recordRecentActivity(Account *account, time_t timestamp, double amount) {
+    RecentActivity *recent = &account->recent;
+
+    recent->timestamps[recent->head] = timestamp;
+    recent->amounts[recent->head] = amount;
+    recent->head = (recent->head + 1) % RECENT_TXN_CAPACITY;
+    if (recent->count < RECENT_TXN_CAPACITY) recent->count++;
+}
+
+// Year and month as one comparable number
+static int32_t monthOf(time_t timestamp) {
+    struct tm date;
+    gmtime_r(&timestamp, &date);
+    return (int32_t)date.tm_year * 12 + date.tm_mon;
+}
+
+int recordSpending(Account *account, time_t timestamp, double amount) {
+    time_t day = timestamp / SECONDS_PER_DAY;
+    if (timestamp % SECONDS_PER_DAY < 0) day--;
+
+    int inDay = 1;
+    int inMonth = 1;
+
+    // Same day means same month; the calendar is only consulted on a new day
+    if (day != account->spendDay) {
+        int32_t month = monthOf(timestamp);
+        if (day > account->spendDay) {
+            account->spendDay = (int32_t)day;
+            account->dailySpent = 0;
+            if (month != account->spendMonth) {
+                account->spendMonth = month;
+                account->monthlySpent = 0;
+            }
+        } else {
+            // History loaded from disk is not necessarily in time order
+            inDay = 0;
+            inMonth = (month == account->spendMonth);
+        }
+    }
+
+    int exceeded = 0;
+    if (inDay) {
+        account->dailySpent += amount;
+        exceeded |= account->dailyLimit > 0 && account->dailySpent > account->dailyLimit;
+    }
+    if (inMonth) {
+        account->monthlySpent += amount;
+        exceeded |= account->monthlyLimit > 0 && account->monthlySpent > account->monthlyLimit;
+    }
+    return exceeded;
+}
+
+int countRecentActivity(const Account *account, time_t since) {
+    const RecentActivity *recent = &account->recent;
+    int matches = 0;
+
+    // History loaded from disk is not necessarily in time order, so
+    // check every live slot instead of stopping at the first old one
+    for (int i = 0; i < recent->count; i++) {
+        if (recent->timestamps[i] >= since) matches++;
+    }
+    return matches;
+}
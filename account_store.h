@@ -0,0 +1,109 @@
+/**
+ * Account Store for Fraud Detection System
+ * Growable account table with an open-addressing index keyed on accNo
+ */
+
+#ifndef ACCOUNT_STORE_H
+#define ACCOUNT_STORE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "location_table.h"
+#include "behavior_profile.h"
+
+#define RECENT_TXN_CAPACITY 16
+#define MAX_ACCOUNT_TYPES 16
+
+// Fixed-capacity ring of an account's latest transactions; the velocity
+// check reads only this, never the global history.
+typedef struct {
+    time_t timestamps[RECENT_TXN_CAPACITY];
+    double amounts[RECENT_TXN_CAPACITY];
+    int head;
+    int count;
+} RecentActivity;
+
+typedef struct {
+    int accNo;
+    const char *name;           // interned in stringArena
+    double balance;
+    LocationId lastLocation;    // interned in locationTable
+    time_t lastTxnTime;
+    int transactionCount;
+    int isActive;
+    const char *accountType;    // interned in stringArena
+    uint8_t accountTypeId;      // set by addAccount(), see accountTypeName()
+    double dailyLimit;
+    double monthlyLimit;
+    double dailySpent;          // within spendDay
+    double monthlySpent;        // within spendMonth
+    int32_t spendDay;           // UTC days since the epoch
+    int32_t spendMonth;         // UTC year * 12 + month - 1
+    RecentActivity recent;
+    BehaviorProfile profile;    // see updateBehaviorProfile()
+} Account;
+
+// Index slot: the key sits next to the record index so probing never
+// touches the (much wider) account records themselves.
+typedef struct {
+    int accNo;
+    int index;
+} AccountSlot;
+
+typedef struct {
+    Account *accounts;      // dense, in insertion order
+    int count;
+    int capacity;
+    AccountSlot *slots;     // power-of-two sized, linear probing
+    int slotMask;
+    int activeCount;        // accounts with isActive set
+} AccountStore;
+
+extern AccountStore accountStore;
+
+void initAccountStore(AccountStore *store, int expectedAccounts);
+void freeAccountStore(AccountStore *store);
+
+/**
+ * Look up an account in O(1). Returned pointers stay valid until the
+ * next addAccount() on the same store.
+ */
+Account *findAccount(const AccountStore *store, int accNo);
+
+/**
+ * Insert an account. For an accNo already present, only the static fields
+ * (name, balance, last location and time, status, type, limits) are
+ * updated. Also assigns accountTypeId. Returns NULL if the store could
+ * not grow.
+ */
+Account *addAccount(AccountStore *store, const Account *account);
+
+/**
+ * Small dense ID for an account type name, shared by every store. ID 0 is
+ * the empty type; names past MAX_ACCOUNT_TYPES also map to 0.
+ */
+int internAccountType(const char *name);
+const char *accountTypeName(int typeId);
+int accountTypeCount();
+
+/**
+ * Remember a transaction in the account's ring, evicting the oldest entry
+ */
+void recordRecentActivity(Account *account, time_t timestamp, double amount);
+
+/**
+ * Count ring entries at or after `since`. Costs O(RECENT_TXN_CAPACITY)
+ * regardless of how much history is stored.
+ */
+int countRecentActivity(const Account *account, time_t since);
+
+/**
+ * Add a transaction to the account's daily and monthly spend. A counter
+ * is reset the first time a transaction falls in a later UTC day or
+ * month, so there is never a sweep over all accounts. Transactions older
+ * than the current period are not counted. Returns nonzero if either
+ * counter is now over its limit (a limit of 0 means none).
+ */
+int recordSpending(Account *account, time_t timestamp, double amount);
+
+#endif
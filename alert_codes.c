@@ -0,0 +1,45 @@
+/**
+ * Alert Codes for Fraud Detection System
+ * Alerts are bits in a mask; message text is produced only on output
+ */
+
+#include <string.h>
+#include "alert_codes.h"
+
+const AlertInfo alertTable[ALERT_CODE_COUNT] = {
+    [ALERT_HIGH_VALUE]          = {"highValue", "High-value transaction", 25},
+    [ALERT_VERY_HIGH_VALUE]     = {"veryHighValue", "Very high-value transaction", 50},
+    [ALERT_RAPID_TRANSACTIONS]  = {"rapidTransactions", "Multiple rapid transactions detected", 30},
+    [ALERT_IMPOSSIBLE_TRAVEL]   = {"impossibleTravel", "Impossible travel detected", 40},
+    [ALERT_LOCATION_CHANGE]     = {"locationChange", "Location change detected", 10},
+    [ALERT_ROUND_AMOUNT]        = {"roundAmount", "Round amount transaction", 5},
+    [ALERT_SUSPICIOUS_LOCATION] = {"suspiciousLocation", "Transaction from suspicious location", 30},
+    [ALERT_UNUSUAL_HOURS]       = {"unusualHours", "Transaction at unusual hour", 10},
+    [ALERT_MICRO_AMOUNT]        = {"microAmount", "Micro amount transaction", 10},
+    [ALERT_BLACKLISTED_ACCOUNT] = {"blacklistedAccount", "Blacklisted account", 100},
+    [ALERT_BLACKLISTED_LOCATION] = {"blacklistedLocation", "Blacklisted location", 100},
+    [ALERT_SPENDING_LIMIT]      = {"spendingLimit", "Spending limit exceeded", 40},
+    [ALERT_AMOUNT_ANOMALY]      = {"amountAnomaly", "Amount unusual for this account", 25},
+    [ALERT_RATE_SPIKE]          = {"rateSpike", "Transaction rate unusual for this account", 20},
+    [ALERT_UNUSUAL_ACCOUNT_HOUR] = {"unusualAccountHour", "Unusual hour for this account", 10},
+    [ALERT_NEW_LOCATION]        = {"newLocation", "New location for this account", 10}
+};
+
+int alertCodeFromMessage(const char *message) {
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        if (strcmp(alertTable[code].message, message) == 0) return code;
+    }
+    return -1;
+}
+
+void writeAlertList(JsonWriter *out, uint32_t alertMask) {
+    int first = 1;
+
+    while (alertMask) {
+        int code = __builtin_ctz(alertMask);
+        if (!first) jsonWriteLiteral(out, ", ");
+        jsonWriteString(out, alertTable[code].message);
+        first = 0;
+        alertMask &= alertMask - 1;
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * Alert Codes for Fraud Detection System
+ * Alerts are bits in a mask; message text is produced only on output
+ */
+
+#ifndef ALERT_CODES_H
+#define ALERT_CODES_H
+
+#include <stdint.h>
+#include "json_writer.h"
+
+typedef enum {
+    ALERT_HIGH_VALUE = 0,
+    ALERT_VERY_HIGH_VALUE,
+    ALERT_RAPID_TRANSACTIONS,
+    ALERT_IMPOSSIBLE_TRAVEL,
+    ALERT_LOCATION_CHANGE,
+    ALERT_ROUND_AMOUNT,
+    ALERT_SUSPICIOUS_LOCATION,
+    ALERT_UNUSUAL_HOURS,
+    ALERT_MICRO_AMOUNT,
+    ALERT_BLACKLISTED_ACCOUNT,
+    ALERT_BLACKLISTED_LOCATION,
+    ALERT_SPENDING_LIMIT,
+    ALERT_AMOUNT_ANOMALY,
+    ALERT_RATE_SPIKE,
+    ALERT_UNUSUAL_ACCOUNT_HOUR,
+    ALERT_NEW_LOCATION,
+    ALERT_CODE_COUNT
+} AlertCode;
+
+#define ALERT_BIT(code) (1u << (code))
+#define NO_FRAUD_MESSAGE "No fraud detected"
+
+// `key` names the alert in fraud_patterns.json; `weight` is the default
+// base weight used when the rules file does not override it
+typedef struct {
+    const char *key;
+    const char *message;
+    int weight;
+} AlertInfo;
+
+extern const AlertInfo alertTable[ALERT_CODE_COUNT];
+
+/**
+ * Map stored alert text back to its code. Returns -1 for unknown text.
+ */
+int alertCodeFromMessage(const char *message);
+
+/**
+ * Write the mask as comma-separated JSON strings (no surrounding brackets)
+ */
+void writeAlertList(JsonWriter *out, uint32_t alertMask);
+
+#endif
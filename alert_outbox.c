@@ -0,0 +1,256 @@
+/**
+ * Alert Outbox for Fraud Detection System
+ * Structured alert events handed off through a bounded lock-free queue
+ * and appended in batches to a durable outbox file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include "alert_outbox.h"
+#include "alert_codes.h"
+#include "json_writer.h"
+#include "location_table.h"
+
+#define ALERT_QUEUE_CAPACITY 4096           // power of two
+#define ALERT_COALESCE_SLOTS 1024           // power of two, twice the batch size
+#define ALERT_BATCH_MAX (ALERT_COALESCE_SLOTS / 2)
+#define ALERT_DRAIN_INTERVAL_NS (20 * 1000 * 1000)
+
+typedef struct {
+    int txnId;
+    int accNo;
+    double amount;
+    int64_t timestamp;
+    uint32_t alertMask;
+    uint8_t riskScore;
+    LocationId location;
+    int count;                  // events merged into this one
+} AlertEvent;
+
+// Bounded MPSC ring: the slot for position p is free for the producer that
+// claims p while its sequence is p, and holds that producer's event once
+// the sequence is p + 1. The drain thread hands it back as p + capacity.
+typedef struct {
+    uint64_t sequence;
+    AlertEvent event;
+} AlertSlot;
+
+static AlertSlot *queue = NULL;
+static uint64_t enqueuePosition = 0;        // claimed by producers
+static uint64_t dequeuePosition = 0;        // advanced by the drain thread only
+
+static int outboxFd = -1;
+static int outboxOpen = 0;
+static int stopping = 0;
+static pthread_t drainThread;
+static AlertOutboxStats stats;              // every field updated atomically
+
+int publishAlert(const Transaction *txn) {
+    if (txn->riskScore < ALERT_MIN_RISK_SCORE || !__atomic_load_n(&outboxOpen, __ATOMIC_ACQUIRE)) return 0;
+
+    uint64_t position = __atomic_load_n(&enqueuePosition, __ATOMIC_RELAXED);
+    AlertSlot *slot;
+    for (;;) {
+        slot = &queue[position & (ALERT_QUEUE_CAPACITY - 1)];
+        int64_t lag = (int64_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - position);
+        if (lag == 0) {
+            if (__atomic_compare_exchange_n(&enqueuePosition, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (lag < 0) {
+            // Full: the transaction must never wait on notification delivery
+            __atomic_fetch_add(&stats.dropped, 1, __ATOMIC_RELAXED);
+            return 0;
+        } else {
+            position = __atomic_load_n(&enqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+
+    AlertEvent *event = &slot->event;
+    event->txnId = txn->txnId;
+    event->accNo = txn->accNo;
+    event->amount = txn->amount;
+    event->timestamp = (int64_t)txn->timestamp;
+    event->alertMask = txn->alertMask;
+    event->riskScore = txn->riskScore;
+    event->location = txn->location;
+    event->count = 1;
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&stats.published, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+static int takeEvent(AlertEvent *event) {
+    AlertSlot *slot = &queue[dequeuePosition & (ALERT_QUEUE_CAPACITY - 1)];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != dequeuePosition + 1) return 0;
+
+    *event = slot->event;
+    __atomic_store_n(&slot->sequence, dequeuePosition + ALERT_QUEUE_CAPACITY, __ATOMIC_RELEASE);
+    __atomic_store_n(&dequeuePosition, dequeuePosition + 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+// The record describes the account's latest transaction, with the highest
+// risk score and every alert raised since the earlier event
+static void mergeEvent(AlertEvent *into, const AlertEvent *event) {
+    into->txnId = event->txnId;
+    into->amount = event->amount;
+    into->timestamp = event->timestamp;
+    into->location = event->location;
+    into->alertMask |= event->alertMask;
+    if (event->riskScore > into->riskScore) into->riskScore = event->riskScore;
+    into->count += event->count;
+}
+
+static void writeAlertRecord(JsonWriter *out, const AlertEvent *event) {
+    jsonWriteLiteral(out, "{\"txnId\": ");
+    jsonWriteInt(out, event->txnId);
+    jsonWriteLiteral(out, ", \"accNo\": ");
+    jsonWriteInt(out, event->accNo);
+    jsonWriteLiteral(out, ", \"amount\": ");
+    jsonWriteFixed2(out, event->amount);
+    jsonWriteLiteral(out, ", \"location\": ");
+    jsonWriteString(out, locationName(event->location));
+    jsonWriteLiteral(out, ", \"timestamp\": ");
+    jsonWriteInt(out, (long)event->timestamp);
+    jsonWriteLiteral(out, ", \"riskScore\": ");
+    jsonWriteInt(out, event->riskScore);
+    jsonWriteLiteral(out, ", \"alertMask\": ");
+    jsonWriteInt(out, event->alertMask);
+    jsonWriteLiteral(out, ", \"alerts\": [");
+    writeAlertList(out, event->alertMask);
+    jsonWriteLiteral(out, "], \"count\": ");
+    jsonWriteInt(out, event->count);
+    jsonWriteLiteral(out, "}\n");
+}
+
+/**
+ * Take up to ALERT_BATCH_MAX accounts' worth of events, merging repeats
+ * per account, and append them with one write() and one fdatasync().
+ * Returns the number of events taken.
+ */
+static int drainBatch(JsonWriter *out) {
+    static AlertEvent batch[ALERT_BATCH_MAX];
+    static int16_t slots[ALERT_COALESCE_SLOTS];     // batch index + 1, 0 when empty
+    AlertEvent event;
+    int count = 0;
+    int taken = 0;
+
+    memset(slots, 0, sizeof(slots));
+    while (count < ALERT_BATCH_MAX && taken < ALERT_QUEUE_CAPACITY && takeEvent(&event)) {
+        taken++;
+
+        // Same Fibonacci hash as the account store
+        uint32_t hash = (uint32_t)event.accNo * 2654435769u;
+        uint32_t pos = (hash ^ (hash >> 16)) & (ALERT_COALESCE_SLOTS - 1);
+        while (slots[pos] && batch[slots[pos] - 1].accNo != event.accNo) {
+            pos = (pos + 1) & (ALERT_COALESCE_SLOTS - 1);
+        }
+
+        if (slots[pos]) {
+            mergeEvent(&batch[slots[pos] - 1], &event);
+            __atomic_fetch_add(&stats.coalesced, 1, __ATOMIC_RELAXED);
+        } else {
+            batch[count++] = event;
+            slots[pos] = (int16_t)count;
+        }
+    }
+    if (taken == 0) return 0;
+
+    for (int i = 0; i < count; i++) {
+        writeAlertRecord(out, &batch[i]);
+    }
+    if (jsonWriterFlush(out) && fdatasync(outboxFd) == 0) {
+        __atomic_fetch_add(&stats.written, (uint64_t)count, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats.batches, 1, __ATOMIC_RELAXED);
+    } else {
+        fprintf(stderr, "Warning: could not append %d alerts to the outbox\n", count);
+        __atomic_fetch_add(&stats.writeErrors, (uint64_t)count, __ATOMIC_RELAXED);
+    }
+    return taken;
+}
+
+static void *drainMain(void *arg) {
+    (void)arg;
+    JsonWriter out;
+    struct timespec interval = {0, ALERT_DRAIN_INTERVAL_NS};
+
+    jsonWriterInit(&out, outboxFd);
+    for (;;) {
+        // Checked before draining so the last pass sees every event
+        int stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+        while (drainBatch(&out) > 0) {
+        }
+        if (stop) break;
+        nanosleep(&interval, NULL);
+    }
+    jsonWriterFree(&out);
+    return NULL;
+}
+
+int openAlertOutbox(const char *path) {
+    if (outboxOpen) return 1;
+
+    queue = malloc(ALERT_QUEUE_CAPACITY * sizeof(AlertSlot));
+    if (!queue) return 0;
+    for (uint64_t i = 0; i < ALERT_QUEUE_CAPACITY; i++) {
+        queue[i].sequence = i;
+    }
+    enqueuePosition = dequeuePosition = 0;
+    stopping = 0;
+
+    outboxFd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (outboxFd < 0) {
+        fprintf(stderr, "Warning: could not open alert outbox %s\n", path);
+        free(queue);
+        queue = NULL;
+        return 0;
+    }
+
+    // SIGHUP is for the serve thread, whose read() it interrupts
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    int started = pthread_create(&drainThread, NULL, drainMain, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (!started) {
+        close(outboxFd);
+        outboxFd = -1;
+        free(queue);
+        queue = NULL;
+        return 0;
+    }
+    __atomic_store_n(&outboxOpen, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void closeAlertOutbox() {
+    if (!outboxOpen) return;
+
+    __atomic_store_n(&outboxOpen, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+    pthread_join(drainThread, NULL);
+
+    close(outboxFd);
+    outboxFd = -1;
+    free(queue);
+    queue = NULL;
+}
+
+void readAlertOutboxStats(AlertOutboxStats *out) {
+    out->published = __atomic_load_n(&stats.published, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&stats.dropped, __ATOMIC_RELAXED);
+    out->coalesced = __atomic_load_n(&stats.coalesced, __ATOMIC_RELAXED);
+    out->written = __atomic_load_n(&stats.written, __ATOMIC_RELAXED);
+    out->batches = __atomic_load_n(&stats.batches, __ATOMIC_RELAXED);
+    out->writeErrors = __atomic_load_n(&stats.writeErrors, __ATOMIC_RELAXED);
+    out->depth = (long)(__atomic_load_n(&enqueuePosition, __ATOMIC_RELAXED) -
+                        __atomic_load_n(&dequeuePosition, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,56 @@
+/**
+ * Alert Outbox for Fraud Detection System
+ * Structured alert events handed off through a bounded lock-free queue
+ * and appended in batches to a durable outbox file, which a separate
+ * dispatcher (server.js) turns into notifications
+ *
+ * Outbox format: one JSON object per line, e.g.
+ *   {"txnId": 7, "accNo": 100, "amount": 45000.00, "location": "Mumbai",
+ *    "timestamp": 1792204705, "riskScore": 68, "alertMask": 288,
+ *    "alerts": [...], "count": 1}
+ * where count > 1 means later alerts for the same account were merged in.
+ */
+
+#ifndef ALERT_OUTBOX_H
+#define ALERT_OUTBOX_H
+
+#include <stdint.h>
+#include "transaction_log.h"
+
+#define DATA_FILE_ALERT_OUTBOX "data/alerts.outbox"
+
+// Same cut-off server.js used for sending notifications
+#define ALERT_MIN_RISK_SCORE 20
+
+typedef struct {
+    uint64_t published;         // accepted into the queue
+    uint64_t dropped;           // rejected because the queue was full
+    uint64_t coalesced;         // merged into an earlier event of the same account
+    uint64_t written;           // records appended to the outbox
+    uint64_t batches;           // outbox appends
+    uint64_t writeErrors;       // records lost to a failed append
+    long depth;                 // events waiting in the queue
+} AlertOutboxStats;
+
+/**
+ * Open (creating) the outbox and start the thread that drains the queue
+ * into it. Until this is called publishAlert() is a no-op.
+ */
+int openAlertOutbox(const char *path);
+
+/**
+ * Drain what is queued, stop the drain thread and close the outbox. Call
+ * after the last publishAlert().
+ */
+void closeAlertOutbox();
+
+/**
+ * Queue an alert event for txn if its risk score warrants one. Lock-free
+ * and never blocks: when the queue is full the event is dropped and
+ * counted. Returns 0 if nothing was queued.
+ */
+int publishAlert(const Transaction *txn);
+
+void readAlertOutboxStats(AlertOutboxStats *stats);
+
+#endif
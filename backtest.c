@@ -0,0 +1,441 @@
+/**
+ * Backtesting for Fraud Detection System
+ * Replays the stored history through many candidate rule sets in one pass
+ * and compares each with the stored labels and with the first rule set
+ *
+ * Every rule reads only the transaction and its own account's state, and
+ * that state evolves the same way whatever the rules decide. So each
+ * account is replayed once, in time order, from a fresh state: the
+ * rule-independent facts are gathered once per transaction and every rule
+ * set is evaluated against them. Each worker owns the accounts that hash
+ * to it and keeps their state to itself.
+ *
+ * History is streamed once, sealed blocks first. Workers take turns
+ * decoding a block into a small shared window and every worker replays
+ * its own accounts' rows from it, so each block is decoded only once.
+ * Row order is time order whenever the history is time-ordered; if it is
+ * not, workers collect their rows and sort them by account and time
+ * before replaying.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "backtest.h"
+#include "account_store.h"
+#include "transaction_log.h"
+#include "history_segments.h"
+#include "fraud_engine.h"
+#include "rule_engine.h"
+#include "alert_codes.h"
+#include "json_writer.h"
+#include "util.h"
+
+typedef struct {
+    uint64_t alertCount[ALERT_CODE_COUNT];
+    uint64_t confusion[TXN_STATUS_COUNT][TXN_STATUS_COUNT];    // [stored][predicted]
+    uint64_t newlySuspicious;           // suspicious here, clean under the first rule set
+    uint64_t newlyClean;
+} BacktestTally;
+
+#define BACKTEST_WINDOW_PER_THREAD 2    // decoded sealed blocks in flight per worker
+
+// Row kept for the sorted replay of history that is not time-ordered
+typedef struct {
+    Transaction txn;
+    int row;
+} DeferredRow;
+
+typedef struct {
+    pthread_t thread;
+    int id;
+    BacktestTally *tallies;             // one per rule set
+    AccountStore accounts;              // replay state of the accounts this worker owns
+    DeferredRow *deferred;
+    int deferredCount;
+    int deferredCapacity;
+    long transactions;
+    int failed;
+} BacktestWorker;
+
+// A sealed block decoded by one worker and read by all of them
+typedef struct {
+    SegmentReader reader;
+    const TransactionColumns *columns;  // NULL if the block could not be read
+    int block;                          // block held, -1 before the first
+    int pending;                        // workers still to read it
+} BlockSlot;
+
+static struct {
+    const CompiledRules *configs;
+    int configCount;
+    int profileMinHistory;              // smallest any rule set uses, 0 if none
+    int threadCount;                    // workers that started; fixed before any of them runs
+    int ready;
+    int sealedBlocks;                   // blocks holding rows no longer in memory
+    BlockSlot *window;                  // block b is decoded into window[b % windowSize]
+    int windowSize;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t changed;             // a window slot was filled or released
+} backtest = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .changed = PTHREAD_COND_INITIALIZER
+};
+
+// Same Fibonacci hash as the account store
+static inline int ownerOf(int accNo) {
+    uint32_t h = (uint32_t)accNo * 2654435769u;
+    return (int)((h ^ (h >> 16)) % (uint32_t)backtest.threadCount);
+}
+
+static Account *replayState(BacktestWorker *worker, int accNo) {
+    Account *account = findAccount(&worker->accounts, accNo);
+    if (account) return account;
+
+    // Start before the first transaction; only the limits carry over
+    Account fresh = {0};
+    fresh.accNo = accNo;
+    const Account *stored = findAccount(&accountStore, accNo);
+    if (stored) {
+        fresh.dailyLimit = stored->dailyLimit;
+        fresh.monthlyLimit = stored->monthlyLimit;
+    }
+    return addAccount(&worker->accounts, &fresh);
+}
+
+static void replayTransaction(BacktestWorker *worker, const Transaction *txn) {
+    Account *account = replayState(worker, txn->accNo);
+    if (!account) {
+        worker->failed = 1;
+        return;
+    }
+
+    FraudContext context;
+    int label = (txn->status == TXN_STATUS_SUSPICIOUS) ? TXN_STATUS_SUSPICIOUS : TXN_STATUS_CLEAN;
+    gatherFraudContext(account, txn, backtest.profileMinHistory, &context);
+    int baseline = 0;
+    for (int c = 0; c < backtest.configCount; c++) {
+        const CompiledRules *rules = &backtest.configs[c];
+        BacktestTally *tally = &worker->tallies[c];
+        uint32_t alerts = evaluateRules(rules, account, txn, &context);
+        int suspicious = scoreAlertMask(rules, alerts) > rules->suspiciousScoreThreshold;
+
+        for (; alerts; alerts &= alerts - 1) {
+            tally->alertCount[__builtin_ctz(alerts)]++;
+        }
+        tally->confusion[label][suspicious]++;
+        if (c == 0) baseline = suspicious;
+        tally->newlySuspicious += suspicious && !baseline;
+        tally->newlyClean += !suspicious && baseline;
+    }
+    recordAccountActivity(account, txn);
+    worker->transactions++;
+}
+
+static int compareDeferred(const void *a, const void *b) {
+    const DeferredRow *x = a;
+    const DeferredRow *y = b;
+    if (x->txn.accNo != y->txn.accNo) return x->txn.accNo < y->txn.accNo ? -1 : 1;
+    if (x->txn.timestamp != y->txn.timestamp) return x->txn.timestamp < y->txn.timestamp ? -1 : 1;
+    return (x->row > y->row) - (x->row < y->row);
+}
+
+/**
+ * Take the next of the worker's rows in row order: replay it now if that
+ * is time order, or keep it for the sorted replay
+ */
+static void visitTransaction(BacktestWorker *worker, const Transaction *txn, int row) {
+    if (txnColumns.timeOrdered) {
+        replayTransaction(worker, txn);
+        return;
+    }
+
+    if (worker->deferredCount == worker->deferredCapacity) {
+        int newCapacity = worker->deferredCapacity ? worker->deferredCapacity * 2 : 4096;
+        DeferredRow *grown = realloc(worker->deferred, (size_t)newCapacity * sizeof(DeferredRow));
+        if (!grown) {
+            worker->failed = 1;
+            return;
+        }
+        worker->deferred = grown;
+        worker->deferredCapacity = newCapacity;
+    }
+    worker->deferred[worker->deferredCount].txn = *txn;
+    worker->deferred[worker->deferredCount].row = row;
+    worker->deferredCount++;
+}
+
+/**
+ * Wait until every worker is done with the block the slot held, then
+ * decode `block` into it for all of them
+ */
+static void decodeIntoSlot(BlockSlot *slot, int block) {
+    pthread_mutex_lock(&backtest.lock);
+    while (slot->pending > 0) pthread_cond_wait(&backtest.changed, &backtest.lock);
+    pthread_mutex_unlock(&backtest.lock);
+
+    const TransactionColumns *columns = readSealedBlock(&slot->reader, block);
+
+    pthread_mutex_lock(&backtest.lock);
+    slot->columns = columns;
+    slot->block = block;
+    slot->pending = backtest.threadCount;
+    pthread_cond_broadcast(&backtest.changed);
+    pthread_mutex_unlock(&backtest.lock);
+}
+
+static void waitForSlot(const BlockSlot *slot, int block) {
+    pthread_mutex_lock(&backtest.lock);
+    while (slot->block != block) pthread_cond_wait(&backtest.changed, &backtest.lock);
+    pthread_mutex_unlock(&backtest.lock);
+}
+
+static void releaseSlot(BlockSlot *slot) {
+    pthread_mutex_lock(&backtest.lock);
+    if (--slot->pending == 0) pthread_cond_broadcast(&backtest.changed);
+    pthread_mutex_unlock(&backtest.lock);
+}
+
+static void *workerMain(void *arg) {
+    BacktestWorker *worker = arg;
+    Transaction txn;
+
+    // Ownership depends on how many workers there are
+    pthread_mutex_lock(&backtest.lock);
+    while (!backtest.ready) pthread_cond_wait(&backtest.start, &backtest.lock);
+    pthread_mutex_unlock(&backtest.lock);
+
+    // Sealed rows: block b is decoded by worker b % threadCount, and the
+    // slot is reused only once every worker has moved past it
+    for (int block = 0; block < backtest.sealedBlocks; block++) {
+        BlockSlot *slot = &backtest.window[block % backtest.windowSize];
+        if (block % backtest.threadCount == worker->id) {
+            decodeIntoSlot(slot, block);
+        } else {
+            waitForSlot(slot, block);
+        }
+
+        const SealedBlock *summary = sealedBlock(block);
+        const TransactionColumns *columns = slot->columns;
+        if (!columns) {
+            worker->failed = 1;
+            releaseSlot(slot);
+            continue;
+        }
+        int rowCount = summary->rowCount;
+        if (summary->firstRow + rowCount > txnColumns.firstRow) rowCount = txnColumns.firstRow - summary->firstRow;
+        for (int i = 0; i < rowCount; i++) {
+            if (ownerOf(columns->accNos[i]) != worker->id) continue;
+            readSealedTransaction(&slot->reader, summary->firstRow + i, &txn);
+            visitTransaction(worker, &txn, summary->firstRow + i);
+        }
+        releaseSlot(slot);
+    }
+
+    for (int row = txnColumns.firstRow; row < txnCount; row++) {
+        if (ownerOf(txnColumns.accNos[txnSlot(row)]) != worker->id) continue;
+        readTransaction(row, &txn);
+        visitTransaction(worker, &txn, row);
+    }
+
+    if (worker->deferredCount > 0) {
+        qsort(worker->deferred, (size_t)worker->deferredCount, sizeof(DeferredRow), compareDeferred);
+        for (int i = 0; i < worker->deferredCount; i++) replayTransaction(worker, &worker->deferred[i].txn);
+    }
+    return NULL;
+}
+
+static void writeAlertCounts(JsonWriter *out, const BacktestTally *tally) {
+    jsonWriteLiteral(out, "{");
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        if (code > 0) jsonWriteLiteral(out, ", ");
+        jsonWriteString(out, alertTable[code].key);
+        jsonWriteLiteral(out, ": ");
+        jsonWriteInt(out, (long)tally->alertCount[code]);
+    }
+    jsonWriteLiteral(out, "}");
+}
+
+static void writeConfigReport(JsonWriter *out, const char *path, const CompiledRules *rules,
+                              const BacktestTally *tally, const BacktestTally *baseline) {
+    uint64_t truePositive = tally->confusion[TXN_STATUS_SUSPICIOUS][TXN_STATUS_SUSPICIOUS];
+    uint64_t falsePositive = tally->confusion[TXN_STATUS_CLEAN][TXN_STATUS_SUSPICIOUS];
+    uint64_t falseNegative = tally->confusion[TXN_STATUS_SUSPICIOUS][TXN_STATUS_CLEAN];
+    uint64_t trueNegative = tally->confusion[TXN_STATUS_CLEAN][TXN_STATUS_CLEAN];
+    uint64_t flagged = truePositive + falsePositive;
+    uint64_t labelled = truePositive + falseNegative;
+
+    jsonWriteLiteral(out, "{\"rules\": ");
+    jsonWriteString(out, path);
+    jsonWriteLiteral(out, ", \"ruleVersion\": ");
+    jsonWriteInt(out, rules->version);
+    jsonWriteLiteral(out, ", \"suspicious\": ");
+    jsonWriteInt(out, (long)flagged);
+    jsonWriteLiteral(out, ", \"confusion\": {\"truePositive\": ");
+    jsonWriteInt(out, (long)truePositive);
+    jsonWriteLiteral(out, ", \"falsePositive\": ");
+    jsonWriteInt(out, (long)falsePositive);
+    jsonWriteLiteral(out, ", \"falseNegative\": ");
+    jsonWriteInt(out, (long)falseNegative);
+    jsonWriteLiteral(out, ", \"trueNegative\": ");
+    jsonWriteInt(out, (long)trueNegative);
+    jsonWriteLiteral(out, "}, \"precision\": ");
+    jsonWriteFixed2(out, flagged ? truePositive * 100.0 / flagged : 0);
+    jsonWriteLiteral(out, ", \"recall\": ");
+    jsonWriteFixed2(out, labelled ? truePositive * 100.0 / labelled : 0);
+    jsonWriteLiteral(out, ", \"alerts\": ");
+    writeAlertCounts(out, tally);
+
+    jsonWriteLiteral(out, ", \"diff\": {\"newlySuspicious\": ");
+    jsonWriteInt(out, (long)tally->newlySuspicious);
+    jsonWriteLiteral(out, ", \"newlyClean\": ");
+    jsonWriteInt(out, (long)tally->newlyClean);
+    jsonWriteLiteral(out, ", \"alerts\": {");
+    int written = 0;
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        long change = (long)tally->alertCount[code] - (long)baseline->alertCount[code];
+        if (change == 0) continue;
+        if (written++) jsonWriteLiteral(out, ", ");
+        jsonWriteString(out, alertTable[code].key);
+        jsonWriteLiteral(out, ": ");
+        jsonWriteInt(out, change);
+    }
+    jsonWriteLiteral(out, "}}}");
+}
+
+int runBacktest(const char *const *rulePaths, int configCount, int threadCount, int outFd) {
+    if (configCount < 1 || configCount > MAX_BACKTEST_CONFIGS) {
+        fprintf(stderr, "Error: Backtest takes 1 to %d rule sets\n", MAX_BACKTEST_CONFIGS);
+        return 0;
+    }
+
+    CompiledRules *configs = malloc((size_t)configCount * sizeof(CompiledRules));
+    if (!configs) return 0;
+    for (int c = 0; c < configCount; c++) {
+        if (!compileFraudRules(rulePaths[c], &configs[c])) {
+            fprintf(stderr, "Error: Could not read rules file %s\n", rulePaths[c]);
+            free(configs);
+            return 0;
+        }
+    }
+
+    if (threadCount < 1) threadCount = 1;
+    BacktestWorker *workers = calloc((size_t)threadCount, sizeof(BacktestWorker));
+    BacktestTally *tallies = calloc((size_t)threadCount * (size_t)configCount, sizeof(BacktestTally));
+    BlockSlot *window = calloc((size_t)threadCount * BACKTEST_WINDOW_PER_THREAD, sizeof(BlockSlot));
+    if (!workers || !tallies || !window) {
+        free(configs);
+        free(workers);
+        free(tallies);
+        free(window);
+        return 0;
+    }
+
+    backtest.configs = configs;
+    backtest.configCount = configCount;
+    backtest.profileMinHistory = 0;
+    for (int c = 0; c < configCount; c++) {
+        int minHistory = configs[c].profileMinHistory;
+        if (minHistory > 0 && (backtest.profileMinHistory == 0 || minHistory < backtest.profileMinHistory)) {
+            backtest.profileMinHistory = minHistory;
+        }
+    }
+    backtest.ready = 0;
+    backtest.window = window;
+    backtest.sealedBlocks = 0;
+    while (backtest.sealedBlocks < sealedBlockCount() &&
+           sealedBlock(backtest.sealedBlocks)->firstRow < txnColumns.firstRow) {
+        backtest.sealedBlocks++;
+    }
+
+    double started = monotonicSeconds();
+    for (int i = 0; i < threadCount; i++) {
+        workers[i].id = i;
+        workers[i].tallies = &tallies[(size_t)i * configCount];
+        initAccountStore(&workers[i].accounts, 0);
+    }
+    // The calling thread is worker 0; threads that fail to start leave
+    // their accounts to the ones that did
+    int requested = threadCount;
+    for (int i = 1; i < requested; i++) {
+        if (pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0) {
+            fprintf(stderr, "Warning: backtesting with %d of %d threads\n", i, requested);
+            threadCount = i;
+            break;
+        }
+    }
+    pthread_mutex_lock(&backtest.lock);
+    backtest.threadCount = threadCount;
+    backtest.windowSize = threadCount * BACKTEST_WINDOW_PER_THREAD;
+    for (int i = 0; i < backtest.windowSize; i++) {
+        initSegmentReader(&window[i].reader);
+        window[i].block = -1;
+    }
+    backtest.ready = 1;
+    pthread_cond_broadcast(&backtest.start);
+    pthread_mutex_unlock(&backtest.lock);
+    workerMain(&workers[0]);
+
+    long transactions = 0;
+    int accounts = 0;
+    int failed = 0;
+    for (int i = 0; i < requested; i++) {
+        if (i > 0 && i < threadCount) pthread_join(workers[i].thread, NULL);
+        transactions += workers[i].transactions;
+        accounts += workers[i].accounts.count;
+        failed |= workers[i].failed;
+        freeAccountStore(&workers[i].accounts);
+        free(workers[i].deferred);
+
+        // Fold every worker's tallies into worker 0's
+        if (i == 0) continue;
+        for (int c = 0; c < configCount; c++) {
+            BacktestTally *into = &tallies[c];
+            const BacktestTally *from = &workers[i].tallies[c];
+            for (int code = 0; code < ALERT_CODE_COUNT; code++) into->alertCount[code] += from->alertCount[code];
+            for (int stored = 0; stored < TXN_STATUS_COUNT; stored++) {
+                for (int predicted = 0; predicted < TXN_STATUS_COUNT; predicted++) {
+                    into->confusion[stored][predicted] += from->confusion[stored][predicted];
+                }
+            }
+            into->newlySuspicious += from->newlySuspicious;
+            into->newlyClean += from->newlyClean;
+        }
+    }
+    for (int i = 0; i < backtest.windowSize; i++) freeSegmentReader(&window[i].reader);
+    free(window);
+    double seconds = monotonicSeconds() - started;
+
+    if (failed) fprintf(stderr, "Warning: Some transactions could not be read or replayed\n");
+    fprintf(stderr, "Backtested %d rule sets over %ld transactions (%d accounts) in %.3f s "
+            "with %d threads: %.0f evaluations/sec\n",
+            configCount, transactions, accounts, seconds, threadCount,
+            (seconds > 0 ? (double)transactions * configCount / seconds : 0.0));
+
+    JsonWriter out;
+    jsonWriterInit(&out, outFd);
+    jsonWriteLiteral(&out, "{\"transactions\": ");
+    jsonWriteInt(&out, transactions);
+    jsonWriteLiteral(&out, ", \"accounts\": ");
+    jsonWriteInt(&out, accounts);
+    jsonWriteLiteral(&out, ", \"configs\": [");
+    for (int c = 0; c < configCount; c++) {
+        if (c > 0) jsonWriteLiteral(&out, ",");
+        jsonWriteLiteral(&out, "\n  ");
+        writeConfigReport(&out, rulePaths[c], &configs[c], &tallies[c], &tallies[0]);
+        jsonWriterFlushIfFull(&out);
+    }
+    jsonWriteLiteral(&out, "\n]}\n");
+    int ok = jsonWriterFlush(&out);
+    jsonWriterFree(&out);
+
+    free(tallies);
+    free(workers);
+    free(configs);
+    return ok && !failed;
+}
@@ -0,0 +1,30 @@
+/**
+ * Backtesting for Fraud Detection System
+ * Replays the stored history through many candidate rule sets in one pass
+ * and compares each with the stored labels and with the first rule set
+ *
+ * Output: one JSON object with a "configs" entry per rule set:
+ *   {"rules": "candidate.json", "ruleVersion": 123, "suspicious": 40,
+ *    "confusion": {"truePositive": 30, "falsePositive": 10,
+ *                  "falseNegative": 5, "trueNegative": 955},
+ *    "precision": 75.00, "recall": 85.71, "alerts": {"highValue": 12, ...},
+ *    "diff": {"newlySuspicious": 4, "newlyClean": 1,
+ *             "alerts": {"highValue": -3, ...}}}
+ * where "positive" means suspicious, the stored status is the truth,
+ * precision and recall are percentages, and diff is against the first
+ * rule set (only alerts whose count changed are listed).
+ */
+
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#define MAX_BACKTEST_CONFIGS 1024
+
+/**
+ * Compile every rules file, replay the history once across threadCount
+ * workers and write the report to outFd. Returns 0 if a rules file
+ * could not be read.
+ */
+int runBacktest(const char *const *rulePaths, int configCount, int threadCount, int outFd);
+
+#endif
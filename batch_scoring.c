@@ -0,0 +1,454 @@
+/**
+ * Batch Scoring for Fraud Detection System
+ * Offline scoring of JSONL/CSV transaction files across worker threads
+ *
+ * The reader thread only splits the mapped input into lines and routes
+ * each line by accNo; workers parse, score and format their own lines.
+ * Every account belongs to exactly one worker, so per-account ordering,
+ * velocity and travel state need no locks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "batch_scoring.h"
+#include "account_store.h"
+#include "transaction_log.h"
+#include "alert_codes.h"
+#include "fraud_engine.h"
+#include "data_manager.h"
+#include "json_stream.h"
+#include "json_writer.h"
+#include "location_table.h"
+#include "metrics.h"
+#include "util.h"
+
+#define BATCH_CHUNK_SIZE 1024
+#define BATCH_QUEUE_DEPTH 8
+#define OUTPUT_FLUSH_BYTES (64 * 1024)
+#define MAX_CSV_COLUMNS 32
+
+typedef enum {
+    CSV_TXN_ID = 0,
+    CSV_ACC_NO,
+    CSV_AMOUNT,
+    CSV_LOCATION,
+    CSV_TIMESTAMP,
+    CSV_STATUS,
+    CSV_TYPE,
+    CSV_FIELD_COUNT
+} CsvField;
+
+static const char *csvFieldNames[CSV_FIELD_COUNT] = {
+    "txnId", "accNo", "amount", "location", "timestamp", "status", "type"
+};
+
+typedef struct {
+    const char *text;
+    size_t length;
+} BatchLine;
+
+typedef struct {
+    BatchLine lines[BATCH_CHUNK_SIZE];
+    int count;
+} BatchChunk;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    BatchChunk *queue[BATCH_QUEUE_DEPTH];
+    int head;
+    int size;
+    int finished;
+    BatchChunk *filling;        // reader side only
+    AccountStore accounts;      // worker side only
+    long scored;
+    long suspicious;
+    long rejected;
+} BatchWorker;
+
+typedef struct {
+    int csv;
+    int columnOf[CSV_FIELD_COUNT];      // CSV column index per field, -1 if absent
+    int outFd;
+    pthread_mutex_t outLock;
+} BatchContext;
+
+static BatchContext context;
+
+/**
+ * Split one CSV line into fields, honouring double-quoted fields.
+ * Quotes are stripped but "" escapes are left as-is.
+ */
+static int splitCsv(const char *line, size_t length, BatchLine *fields, int maxFields) {
+    const char *p = line;
+    const char *end = line + length;
+    int count = 0;
+
+    while (count < maxFields) {
+        if (p < end && *p == '"') {
+            const char *start = ++p;
+            while (p < end && !(*p == '"' && (p + 1 >= end || p[1] != '"'))) {
+                p += (*p == '"') ? 2 : 1;
+            }
+            fields[count].text = start;
+            fields[count].length = (size_t)((p < end ? p : end) - start);
+            count++;
+            if (p < end) p++;
+            while (p < end && *p != ',') p++;
+        } else {
+            const char *start = p;
+            while (p < end && *p != ',') p++;
+            fields[count].text = start;
+            fields[count].length = (size_t)(p - start);
+            count++;
+        }
+        if (p >= end) break;
+        p++;
+    }
+    return count;
+}
+
+static void copyField(const BatchLine *field, char *dest, size_t destSize) {
+    size_t length = (field->length < destSize - 1) ? field->length : destSize - 1;
+    memcpy(dest, field->text, length);
+    dest[length] = '\0';
+}
+
+static double fieldNumber(const BatchLine *field) {
+    char buffer[64];
+    copyField(field, buffer, sizeof(buffer));
+    return strtod(buffer, NULL);
+}
+
+static int parseCsvTransaction(const BatchLine *line, Transaction *txn) {
+    BatchLine fields[MAX_CSV_COLUMNS];
+    int count = splitCsv(line->text, line->length, fields, MAX_CSV_COLUMNS);
+    char text[32];
+
+    for (int f = 0; f < CSV_FIELD_COUNT; f++) {
+        int column = context.columnOf[f];
+        if (column < 0 || column >= count) continue;
+        const BatchLine *field = &fields[column];
+
+        switch (f) {
+            case CSV_TXN_ID: txn->txnId = (int)fieldNumber(field); break;
+            case CSV_ACC_NO: txn->accNo = (int)fieldNumber(field); break;
+            case CSV_AMOUNT: txn->amount = fieldNumber(field); break;
+            case CSV_LOCATION: txn->location = internLocationN(field->text, field->length); break;
+            case CSV_TIMESTAMP: {
+                JsonToken token = {JSON_TOKEN_STRING, field->text, field->length, 0};
+                if (!jsonParseTimestamp(&token, &txn->timestamp)) {
+                    txn->timestamp = (time_t)fieldNumber(field);
+                }
+                break;
+            }
+            case CSV_STATUS: copyField(field, text, sizeof(text)); txn->status = parseTxnStatus(text); break;
+            case CSV_TYPE: copyField(field, text, sizeof(text)); txn->type = parseTxnType(text); break;
+        }
+    }
+    return txn->accNo != 0;
+}
+
+static int parseJsonTransaction(const BatchLine *line, Transaction *txn) {
+    JsonStream stream;
+    JsonToken token;
+
+    jsonOpenBuffer(&stream, line->text, line->length);
+    if (!jsonNext(&stream, &token) || token.type != JSON_TOKEN_OBJECT_BEGIN) return 0;
+    decodeTransaction(&stream, txn);
+    return txn->accNo != 0;
+}
+
+/**
+ * Cheap accNo extraction used only for routing; the worker parses fully
+ */
+static int routingKey(const BatchLine *line) {
+    const char *p;
+    const char *end = line->text + line->length;
+
+    if (context.csv) {
+        BatchLine fields[MAX_CSV_COLUMNS];
+        int column = context.columnOf[CSV_ACC_NO];
+        if (splitCsv(line->text, line->length, fields, column + 1) <= column) return 0;
+        p = fields[column].text;
+        end = p + fields[column].length;
+    } else {
+        p = memmem(line->text, line->length, "\"accNo\"", 7);
+        if (!p) return 0;
+        p += 7;
+        while (p < end && (*p == ' ' || *p == ':' || *p == '\t')) p++;
+    }
+
+    int negative = (p < end && *p == '-');
+    if (negative) p++;
+    int value = 0;
+    while (p < end && *p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+    return negative ? -value : value;
+}
+
+// Workers share one output fd; each flush is a single write of whole lines
+static void emitOutput(JsonWriter *out) {
+    pthread_mutex_lock(&context.outLock);
+    if (!jsonWriterFlush(out)) {
+        fprintf(stderr, "Warning: Could not write batch output\n");
+    }
+    pthread_mutex_unlock(&context.outLock);
+}
+
+static Account *workerAccount(BatchWorker *worker, int accNo) {
+    Account *account = findAccount(&worker->accounts, accNo);
+    if (account) return account;
+
+    // Start from the stored profile when there is one; the shared store is
+    // read-only while the batch runs
+    Account seed = {0};
+    const Account *known = findAccount(&accountStore, accNo);
+    if (known) {
+        seed = *known;
+    } else {
+        seed.accNo = accNo;
+        seed.name = "";
+        seed.accountType = "";
+        seed.isActive = 1;
+    }
+    return addAccount(&worker->accounts, &seed);
+}
+
+static void scoreLine(BatchWorker *worker, const CompiledRules *rules, const BatchLine *line, JsonWriter *out) {
+    Transaction txn = {0};
+    int parsed = context.csv ? parseCsvTransaction(line, &txn) : parseJsonTransaction(line, &txn);
+    Account *account = parsed ? workerAccount(worker, txn.accNo) : NULL;
+
+    if (!account) {
+        worker->rejected++;
+        return;
+    }
+
+    // Re-score from scratch: stored alerts and labels are not inputs
+    txn.alertMask = 0;
+    checkFraud(rules, account, &txn);
+
+    worker->scored++;
+    if (txn.status == TXN_STATUS_SUSPICIOUS) worker->suspicious++;
+
+    jsonWriteLiteral(out, "{\"txnId\": ");
+    jsonWriteInt(out, txn.txnId);
+    jsonWriteLiteral(out, ", \"accNo\": ");
+    jsonWriteInt(out, txn.accNo);
+    jsonWriteLiteral(out, ", \"amount\": ");
+    jsonWriteFixed2(out, txn.amount);
+    jsonWriteLiteral(out, ", \"riskScore\": ");
+    jsonWriteInt(out, txn.riskScore);
+    jsonWriteLiteral(out, ", \"ruleVersion\": ");
+    jsonWriteInt(out, txn.ruleVersion);
+    jsonWriteLiteral(out, ", \"status\": ");
+    jsonWriteString(out, txnStatusName(txn.status));
+    jsonWriteLiteral(out, ", \"alerts\": [");
+    writeAlertList(out, txn.alertMask);
+    jsonWriteLiteral(out, "]}\n");
+}
+
+static void *workerMain(void *arg) {
+    BatchWorker *worker = arg;
+    JsonWriter out;
+    jsonWriterInit(&out, context.outFd);
+
+    initAccountStore(&worker->accounts, 0);
+
+    for (;;) {
+        pthread_mutex_lock(&worker->lock);
+        while (worker->size == 0 && !worker->finished) {
+            pthread_cond_wait(&worker->notEmpty, &worker->lock);
+        }
+        if (worker->size == 0) {
+            pthread_mutex_unlock(&worker->lock);
+            break;
+        }
+        BatchChunk *chunk = worker->queue[worker->head];
+        worker->head = (worker->head + 1) % BATCH_QUEUE_DEPTH;
+        worker->size--;
+        METRICS_ADD_GAUGE(GAUGE_BATCH_QUEUE_DEPTH, -1);
+        pthread_cond_signal(&worker->notFull);
+        pthread_mutex_unlock(&worker->lock);
+
+        // One rule set per chunk, so a reload lands between chunks
+        const CompiledRules *rules = acquireRules();
+        for (int i = 0; i < chunk->count; i++) {
+            scoreLine(worker, rules, &chunk->lines[i], &out);
+        }
+        releaseRules();
+        free(chunk);
+
+        if (out.length >= OUTPUT_FLUSH_BYTES) emitOutput(&out);
+    }
+
+    emitOutput(&out);
+    jsonWriterFree(&out);
+    freeAccountStore(&worker->accounts);
+    return NULL;
+}
+
+static void sendChunk(BatchWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    while (worker->size == BATCH_QUEUE_DEPTH) {
+        pthread_cond_wait(&worker->notFull, &worker->lock);
+    }
+    worker->queue[(worker->head + worker->size) % BATCH_QUEUE_DEPTH] = worker->filling;
+    worker->size++;
+    METRICS_ADD_GAUGE(GAUGE_BATCH_QUEUE_DEPTH, 1);
+    pthread_cond_signal(&worker->notEmpty);
+    pthread_mutex_unlock(&worker->lock);
+    worker->filling = NULL;
+}
+
+// Returns 0 if the line was dropped for want of a chunk
+static int routeLine(BatchWorker *workers, int threadCount, const char *text, size_t length) {
+    BatchLine line = {text, length};
+    uint32_t hash = (uint32_t)routingKey(&line) * 2654435769u;
+    BatchWorker *worker = &workers[(hash >> 16) % (uint32_t)threadCount];
+
+    if (!worker->filling) {
+        worker->filling = malloc(sizeof(BatchChunk));
+        if (!worker->filling) return 0;
+        worker->filling->count = 0;
+    }
+    worker->filling->lines[worker->filling->count++] = line;
+    if (worker->filling->count == BATCH_CHUNK_SIZE) sendChunk(worker);
+    return 1;
+}
+
+static int readCsvHeader(const char *line, size_t length) {
+    BatchLine columns[MAX_CSV_COLUMNS];
+    int count = splitCsv(line, length, columns, MAX_CSV_COLUMNS);
+
+    for (int f = 0; f < CSV_FIELD_COUNT; f++) {
+        context.columnOf[f] = -1;
+        for (int c = 0; c < count; c++) {
+            size_t nameLength = strlen(csvFieldNames[f]);
+            if (columns[c].length == nameLength && memcmp(columns[c].text, csvFieldNames[f], nameLength) == 0) {
+                context.columnOf[f] = c;
+            }
+        }
+    }
+    return context.columnOf[CSV_ACC_NO] >= 0;
+}
+
+int runBatchScoring(const char *inputPath, int outFd, int threadCount) {
+    int fd = open(inputPath, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Error: Could not open batch input %s\n", inputPath);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+
+    const char *data = NULL;
+    if (st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+        else madvise((void *)data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    if (!data && st.st_size > 0) {
+        fprintf(stderr, "Error: Could not map batch input %s\n", inputPath);
+        return 0;
+    }
+
+    const char *pos = data;
+    const char *end = data + st.st_size;
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) pos++;
+
+    context.csv = (pos < end && *pos != '{');
+    context.outFd = outFd;
+    pthread_mutex_init(&context.outLock, NULL);
+
+    if (context.csv) {
+        const char *newline = memchr(pos, '\n', (size_t)(end - pos));
+        const char *lineEnd = newline ? newline : end;
+        if (!readCsvHeader(pos, (size_t)(lineEnd - pos - (lineEnd > pos && lineEnd[-1] == '\r')))) {
+            fprintf(stderr, "Error: CSV header must include an accNo column\n");
+            munmap((void *)data, (size_t)st.st_size);
+            return 0;
+        }
+        pos = newline ? newline + 1 : end;
+    }
+
+    if (threadCount < 1) threadCount = 1;
+    BatchWorker *workers = calloc((size_t)threadCount, sizeof(BatchWorker));
+    if (!workers) return 0;
+
+    // Lines are routed only once every worker is running, so a thread
+    // that fails to start just shrinks the pool
+    double started = monotonicSeconds();
+    for (int i = 0; i < threadCount; i++) {
+        pthread_mutex_init(&workers[i].lock, NULL);
+        pthread_cond_init(&workers[i].notEmpty, NULL);
+        pthread_cond_init(&workers[i].notFull, NULL);
+        if (pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0) {
+            pthread_mutex_destroy(&workers[i].lock);
+            pthread_cond_destroy(&workers[i].notEmpty);
+            pthread_cond_destroy(&workers[i].notFull);
+            fprintf(stderr, "Warning: scoring with %d of %d threads\n", i, threadCount);
+            threadCount = i;
+            break;
+        }
+    }
+    if (threadCount == 0) {
+        fprintf(stderr, "Error: Could not start any batch scoring thread\n");
+        free(workers);
+        pthread_mutex_destroy(&context.outLock);
+        if (data) munmap((void *)data, (size_t)st.st_size);
+        return 0;
+    }
+
+    long unrouted = 0;
+    while (pos < end) {
+        const char *newline = memchr(pos, '\n', (size_t)(end - pos));
+        const char *lineEnd = newline ? newline : end;
+        size_t length = (size_t)(lineEnd - pos);
+        if (length > 0 && pos[length - 1] == '\r') length--;
+        if (length > 0 && !routeLine(workers, threadCount, pos, length)) unrouted++;
+        pos = newline ? newline + 1 : end;
+    }
+    if (unrouted > 0) {
+        fprintf(stderr, "Warning: %ld transactions rejected, out of memory for batch chunks\n", unrouted);
+    }
+
+    long scored = 0, suspicious = 0, rejected = unrouted;
+    for (int i = 0; i < threadCount; i++) {
+        if (workers[i].filling) sendChunk(&workers[i]);
+        pthread_mutex_lock(&workers[i].lock);
+        workers[i].finished = 1;
+        pthread_cond_signal(&workers[i].notEmpty);
+        pthread_mutex_unlock(&workers[i].lock);
+    }
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(workers[i].thread, NULL);
+        scored += workers[i].scored;
+        suspicious += workers[i].suspicious;
+        rejected += workers[i].rejected;
+        pthread_mutex_destroy(&workers[i].lock);
+        pthread_cond_destroy(&workers[i].notEmpty);
+        pthread_cond_destroy(&workers[i].notFull);
+    }
+
+    double seconds = monotonicSeconds() - started;
+    fprintf(stderr, "Batch scored %ld transactions (%ld suspicious, %ld rejected) in %.3f s "
+            "with %d threads: %.0f records/sec\n",
+            scored, suspicious, rejected, seconds, threadCount,
+            (seconds > 0 ? scored / seconds : 0.0));
+
+    free(workers);
+    pthread_mutex_destroy(&context.outLock);
+    if (data) munmap((void *)data, (size_t)st.st_size);
+    return 1;
+}
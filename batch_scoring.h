@@ -0,0 +1,17 @@
+/**
+ * Batch Scoring for Fraud Detection System
+ * Offline scoring of JSONL/CSV transaction files across worker threads
+ */
+
+#ifndef BATCH_SCORING_H
+#define BATCH_SCORING_H
+
+/**
+ * Score every transaction in inputPath (JSON lines, or CSV with a header
+ * row) and stream one JSON result per line to outFd. Transactions are
+ * partitioned by accNo so each account is owned by exactly one worker.
+ * Returns 0 if the input could not be read.
+ */
+int runBatchScoring(const char *inputPath, int outFd, int threadCount);
+
+#endif
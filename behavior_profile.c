@@ -0,0 +1,123 @@
+/**
+ * Behavior Profile for Fraud Detection System
+ * Fixed-size per-account summary of past transactions, updated online in
+ * O(1), that says how unusual a new transaction is for that account
+ */
+
+#include <math.h>
+#include "behavior_profile.h"
+
+#define SECONDS_PER_DAY 86400
+#define SECONDS_PER_HOUR 3600
+#define LN2 0.69314718055994530942
+
+// Spread assumed at least this share of the mean, so an account that
+// always pays the same amount is not flagged for a few cents more
+#define PROFILE_MIN_SPREAD 0.1
+
+// Mean lifetime of a transaction in the decayed rate
+static const double rateTau = PROFILE_RATE_HALF_LIFE / LN2;
+
+static inline double decay(double seconds) {
+    return exp(-seconds / rateTau);
+}
+
+static inline int hourOf(time_t timestamp) {
+    long secondOfDay = (long)(timestamp % SECONDS_PER_DAY);
+    if (secondOfDay < 0) secondOfDay += SECONDS_PER_DAY;
+    return (int)(secondOfDay / SECONDS_PER_HOUR);
+}
+
+void updateBehaviorProfile(BehaviorProfile *profile, time_t timestamp, double amount, LocationId location) {
+    // Welford: numerically stable mean and variance in one pass
+    profile->count++;
+    double delta = amount - profile->meanAmount;
+    profile->meanAmount += delta / profile->count;
+    profile->amountM2 += delta * (amount - profile->meanAmount);
+
+    // The decayed count lives at the newest timestamp; an older transaction
+    // adds the weight it would have by then
+    if (profile->count == 1) {
+        profile->rateSum = 1.0;
+        profile->rateTime = timestamp;
+        profile->since = timestamp;
+    } else if (timestamp >= profile->rateTime) {
+        profile->rateSum = profile->rateSum * decay((double)(timestamp - profile->rateTime)) + 1.0;
+        profile->rateTime = timestamp;
+    } else {
+        profile->rateSum += decay((double)(profile->rateTime - timestamp));
+        if (timestamp < profile->since) profile->since = timestamp;
+    }
+
+    // Halving keeps the shape of the histogram; nonzero hours stay nonzero
+    int hour = hourOf(timestamp);
+    if (profile->hourCounts[hour] == UINT16_MAX) {
+        profile->hourTotal = 0;
+        for (int h = 0; h < PROFILE_HOURS; h++) {
+            profile->hourCounts[h] = (uint16_t)((profile->hourCounts[h] + 1) / 2);
+            profile->hourTotal += profile->hourCounts[h];
+        }
+    }
+    profile->hourCounts[hour]++;
+    profile->hourTotal++;
+
+    // Space-Saving: an untracked location replaces the least counted entry
+    // and inherits its count, which bounds the newcomer's overestimate
+    if (location == LOCATION_NONE) return;
+    int slot = 0;
+    for (int i = 0; i < PROFILE_TOP_LOCATIONS; i++) {
+        if (profile->locationCounts[i] && profile->topLocations[i] == location) {
+            profile->locationCounts[i]++;
+            return;
+        }
+        if (profile->locationCounts[i] < profile->locationCounts[slot]) slot = i;
+    }
+    profile->topLocations[slot] = location;
+    profile->locationCounts[slot]++;
+}
+
+double profileStdDevAmount(const BehaviorProfile *profile) {
+    return profile->count < 2 ? 0.0 : sqrt(profile->amountM2 / (profile->count - 1));
+}
+
+double profileDailyRate(const BehaviorProfile *profile, time_t now) {
+    double sum = profile->rateSum;
+    if (now > profile->rateTime) sum *= decay((double)(now - profile->rateTime));
+    return sum * SECONDS_PER_DAY / rateTau;
+}
+
+void computeBehaviorFeatures(const BehaviorProfile *profile, time_t timestamp, double amount,
+                             LocationId location, BehaviorFeatures *features) {
+    features->amountZScore = 0.0;
+    features->rateRatio = 1.0;
+    features->hourShare = 1.0;
+    features->knownLocation = 1;
+    if (profile->count == 0) return;
+
+    double spread = profileStdDevAmount(profile);
+    double minSpread = fmax(PROFILE_MIN_SPREAD * fabs(profile->meanAmount), 1.0);
+    features->amountZScore = (amount - profile->meanAmount) / fmax(spread, minSpread);
+
+    // Both rates count this transaction. A history shorter than the decay
+    // time is treated as that long, so a new account is not a spike.
+    double recent = profile->rateSum;
+    if (timestamp > profile->rateTime) recent *= decay((double)(timestamp - profile->rateTime));
+    recent += 1.0;
+    double span = fmax((double)(timestamp - profile->since), rateTau);
+    features->rateRatio = (recent / rateTau) / ((profile->count + 1) / span);
+
+    // The neighbouring hours count too, so a sparse history is not
+    // flagged for 14:05 after a string of 13:50s
+    int hour = hourOf(timestamp);
+    uint32_t nearby = profile->hourCounts[hour] +
+                      profile->hourCounts[(hour + 1) % PROFILE_HOURS] +
+                      profile->hourCounts[(hour + PROFILE_HOURS - 1) % PROFILE_HOURS];
+    if (profile->hourTotal > 0) features->hourShare = (double)nearby / profile->hourTotal;
+
+    if (location != LOCATION_NONE) {
+        features->knownLocation = 0;
+        for (int i = 0; i < PROFILE_TOP_LOCATIONS; i++) {
+            features->knownLocation |= profile->locationCounts[i] && profile->topLocations[i] == location;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * Behavior Profile for Fraud Detection System
+ * Fixed-size per-account summary of past transactions, updated online in
+ * O(1), that says how unusual a new transaction is for that account
+ *
+ * The Space-Saving location sketch and the rate decay both depend on the
+ * order transactions are folded in, so a rebuild replays stored history
+ * in row (arrival) order to reproduce the live profile exactly.
+ */
+
+#ifndef BEHAVIOR_PROFILE_H
+#define BEHAVIOR_PROFILE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "location_table.h"
+
+#define PROFILE_HOURS 24
+#define PROFILE_TOP_LOCATIONS 4
+#define PROFILE_RATE_HALF_LIFE 86400        // seconds
+
+typedef struct {
+    uint32_t count;                 // transactions folded in
+    uint32_t hourTotal;             // sum of hourCounts (they are halved on overflow)
+    double meanAmount;              // Welford running mean
+    double amountM2;                // Welford sum of squared deviations
+    double rateSum;                 // exponentially decayed transaction count
+    time_t rateTime;                // when rateSum was last decayed to
+    time_t since;                   // earliest transaction seen
+    uint16_t hourCounts[PROFILE_HOURS];                 // by UTC hour
+    LocationId topLocations[PROFILE_TOP_LOCATIONS];     // Space-Saving sketch
+    uint32_t locationCounts[PROFILE_TOP_LOCATIONS];     // 0 when the entry is free
+} BehaviorProfile;
+
+// How a transaction compares with the profile built before it
+typedef struct {
+    double amountZScore;            // above the mean in standard deviations
+    double rateRatio;               // recent daily rate over the lifetime daily rate
+    double hourShare;               // share of history within an hour of this one
+    int knownLocation;              // among the account's top locations
+} BehaviorFeatures;
+
+/**
+ * Fold one transaction into the profile. Transactions may arrive out of
+ * time order; older ones are decayed as of the newest seen.
+ */
+void updateBehaviorProfile(BehaviorProfile *profile, time_t timestamp, double amount, LocationId location);
+
+/**
+ * Score a transaction against the profile without changing it. Only
+ * meaningful once the profile holds a few transactions.
+ */
+void computeBehaviorFeatures(const BehaviorProfile *profile, time_t timestamp, double amount,
+                             LocationId location, BehaviorFeatures *features);
+
+double profileStdDevAmount(const BehaviorProfile *profile);
+
+/**
+ * Decayed transactions per day as of `now`
+ */
+double profileDailyRate(const BehaviorProfile *profile, time_t now);
+
+#endif
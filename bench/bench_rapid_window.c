@@ -0,0 +1,105 @@
+/**
+ * Rapid-transaction check benchmark
+ * Shows that checkFraud() latency stays flat as stored history grows,
+ * because the velocity rule reads only the per-account ring.
+ *
+ * Usage: ./bench_rapid_window [maxStoredTransactions]
+ * Output: CSV lines "storedTransactions,checkFraudNsPerTxn"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "account_store.h"
+#include "transaction_log.h"
+#include "fraud_engine.h"
+
+#define BENCH_ACCOUNTS 10000
+#define BATCH_SIZE 20000
+
+static const char *benchCities[] = {"New York", "London", "Tokyo", "Paris", "Sydney", "Dubai"};
+static LocationId benchLocations[6];
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fillBatch(Transaction *batch, int size, long firstIndex, time_t baseTime) {
+    for (int i = 0; i < size; i++) {
+        long n = firstIndex + i;
+        Transaction *txn = &batch[i];
+        txn->txnId = (int)(n + 1);
+        txn->accNo = 1 + (int)(rand() % BENCH_ACCOUNTS);
+        txn->amount = 10.0 + rand() % 120000;
+        txn->location = benchLocations[rand() % 6];
+        txn->timestamp = baseTime + n / 50;     // ~50 transactions per second overall
+        txn->alertMask = 0;
+        txn->riskScore = 0;
+        txn->type = TXN_TYPE_PURCHASE;
+    }
+}
+
+static int checkAndStore(const CompiledRules *rules, Transaction *batch, int size) {
+    for (int i = 0; i < size; i++) {
+        checkFraud(rules, findAccount(&accountStore, batch[i].accNo), &batch[i]);
+        if (!storeTransaction(&batch[i])) {
+            fprintf(stderr, "Out of memory at %d stored transactions\n", txnCount);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    long maxStored = (argc > 1) ? atol(argv[1]) : 10000000L;
+    Transaction *batch = malloc(BATCH_SIZE * sizeof(Transaction));
+    if (!batch) return 1;
+
+    CompiledRules rules;
+    srand(42);
+    initDefaultRules(&rules);
+    for (int i = 0; i < 6; i++) {
+        benchLocations[i] = internLocation(benchCities[i]);
+    }
+    initAccountStore(&accountStore, BENCH_ACCOUNTS);
+    for (int i = 1; i <= BENCH_ACCOUNTS; i++) {
+        Account account = {0};
+        account.accNo = i;
+        account.balance = 1e12;
+        account.isActive = 1;
+        addAccount(&accountStore, &account);
+    }
+
+    time_t baseTime = 1700000000;
+    printf("storedTransactions,checkFraudNsPerTxn\n");
+
+    for (long checkpoint = 1000; checkpoint <= maxStored; checkpoint *= 10) {
+        // Grow the history to the checkpoint through the normal path
+        while (txnCount < checkpoint) {
+            int chunk = (checkpoint - txnCount < BATCH_SIZE) ? (int)(checkpoint - txnCount) : BATCH_SIZE;
+            fillBatch(batch, chunk, txnCount, baseTime);
+            if (!checkAndStore(&rules, batch, chunk)) return 1;
+        }
+
+        // Time one batch of checks against that much stored history
+        fillBatch(batch, BATCH_SIZE, txnCount, baseTime);
+        double start = nowNs();
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            checkFraud(&rules, findAccount(&accountStore, batch[i].accNo), &batch[i]);
+        }
+        double elapsed = nowNs() - start;
+
+        printf("%ld,%.1f\n", checkpoint, elapsed / BATCH_SIZE);
+        fflush(stdout);
+
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            if (!storeTransaction(&batch[i])) return 1;
+        }
+    }
+
+    free(batch);
+    return 0;
+}
@@ -0,0 +1,417 @@
+/**
+ * Scoring-path benchmark suite
+ * Generates a seeded synthetic workload, then times the hot functions
+ * one call at a time and the whole request path end to end.
+ *
+ * Usage: ./bench_suite [--seed N] [--accounts N] [--transactions N]
+ *                      [--serve-batch N] [--threads N] [--workdir DIR]
+ * Run from the repository root so data/ rules and locations are found.
+ * Output: CSV on stdout, one row per benchmark:
+ *   benchmark,ops,seconds,opsPerSec,meanNs,p50Ns,p99Ns,p999Ns
+ * Percentiles are empty for whole-file benchmarks. Per-call timings
+ * include the clock read itself; the clockGettime row measures it.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "account_store.h"
+#include "transaction_log.h"
+#include "statistics.h"
+#include "fraud_engine.h"
+#include "data_manager.h"
+#include "batch_scoring.h"
+#include "journal.h"
+#include "json_writer.h"
+#include "column_scan.h"
+#include "history_index.h"
+#include "snapshot.h"
+#include "alert_outbox.h"
+#include "serve_pipeline.h"
+#include "load_generator.h"
+
+typedef struct {
+    LoadProfile profile;
+    long transactionCount;
+    int serveBatch;             // requests per simulated read() in the serve path
+    int threads;                // batch scoring and serve workers
+    const char *workdir;
+} SuiteOptions;
+
+// Results land here so the compiler cannot drop the timed calls
+static volatile long sink;
+
+static inline uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compareLatency(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, long count, double q) {
+    long rank = (long)ceil(q * count);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+/**
+ * Print one result row. latencies (may be NULL) holds one sample per op
+ * and is sorted in place.
+ */
+static void report(const char *name, long ops, uint64_t elapsedNs, uint64_t *latencies) {
+    double seconds = elapsedNs / 1e9;
+    printf("%s,%ld,%.6f,%.0f,%.1f", name, ops, seconds,
+           seconds > 0 ? ops / seconds : 0.0, ops > 0 ? (double)elapsedNs / ops : 0.0);
+    if (latencies && ops > 0) {
+        qsort(latencies, (size_t)ops, sizeof(uint64_t), compareLatency);
+        printf(",%llu,%llu,%llu\n",
+               (unsigned long long)percentile(latencies, ops, 0.50),
+               (unsigned long long)percentile(latencies, ops, 0.99),
+               (unsigned long long)percentile(latencies, ops, 0.999));
+    } else {
+        printf(",,,\n");
+    }
+    fflush(stdout);
+}
+
+static void benchClock(uint64_t *latencies, long ops) {
+    uint64_t started = nowNs();
+    for (long i = 0; i < ops; i++) {
+        uint64_t t0 = nowNs();
+        latencies[i] = nowNs() - t0;
+    }
+    report("clockGettime", ops, nowNs() - started, latencies);
+}
+
+static void benchFindAccount(const Transaction *load, long count, uint64_t *latencies) {
+    long found = 0;
+    uint64_t started = nowNs();
+    for (long i = 0; i < count; i++) {
+        uint64_t t0 = nowNs();
+        found += findAccount(&accountStore, load[i].accNo) != NULL;
+        latencies[i] = nowNs() - t0;
+    }
+    report("findAccount", count, nowNs() - started, latencies);
+    sink = found;
+}
+
+static void benchCheckFraud(Transaction *work, long count, uint64_t *latencies) {
+    uint64_t started = nowNs();
+    for (long i = 0; i < count; i++) {
+        Account *account = findAccount(&accountStore, work[i].accNo);
+        uint64_t t0 = nowNs();
+        const CompiledRules *rules = acquireRules();
+        checkFraud(rules, account, &work[i]);
+        releaseRules();
+        latencies[i] = nowNs() - t0;
+    }
+    report("checkFraud", count, nowNs() - started, latencies);
+}
+
+static void benchRiskScore(Transaction *work, long count, uint64_t *latencies) {
+    long total = 0;
+    const CompiledRules *rules = acquireRules();
+    uint64_t started = nowNs();
+    for (long i = 0; i < count; i++) {
+        uint64_t t0 = nowNs();
+        total += calculateRiskScore(rules, &work[i]);
+        latencies[i] = nowNs() - t0;
+    }
+    releaseRules();
+    report("calculateRiskScore", count, nowNs() - started, latencies);
+    sink = total;
+}
+
+/**
+ * The --serve request path: each batch of request lines goes through the
+ * same segment workers, stores, journal appends and alert publishing as
+ * one read() in serveRequests(), then one group commit releases all
+ * responses. A request's latency runs from its batch arriving to that
+ * release.
+ */
+static void benchServePath(const Transaction *load, long count, int batchSize, uint64_t *latencies) {
+    int nullFd = open("/dev/null", O_WRONLY);
+    char *requests = malloc(READ_BUFFER_SIZE);
+    JsonWriter out;
+    jsonWriterInit(&out, nullFd);
+    if (!requests) {
+        fprintf(stderr, "Warning: Out of memory for the serve path benchmark\n");
+        jsonWriterFree(&out);
+        if (nullFd >= 0) close(nullFd);
+        return;
+    }
+
+    uint64_t started = nowNs();
+    long last;
+    for (long first = 0; first < count; first = last) {
+        // What the client sends in one write, formatted before it arrives
+        size_t used = 0;
+        for (last = first; last < count && last - first < batchSize; last++) {
+            int length = snprintf(requests + used, READ_BUFFER_SIZE - used, "TXN %d %.2f %s\n",
+                                  load[last].accNo, load[last].amount, locationName(load[last].location));
+            if (length < 0 || used + (size_t)length >= READ_BUFFER_SIZE) break;
+            used += (size_t)length;
+        }
+        uint64_t arrived = nowNs();
+
+        char *line = requests;
+        for (long i = first; i < last; i++) {
+            char *newline = strchr(line, '\n');
+            *newline = '\0';
+            if (!queueTxnRequest(&out, line)) printError(&out, "Usage: TXN <accNo> <amount> <location>");
+            line = newline + 1;
+        }
+        runSegment(&out);
+
+        journalCommit();
+        jsonWriterFlush(&out);
+        uint64_t released = nowNs();
+        for (long i = first; i < last; i++) latencies[i] = released - arrived;
+    }
+    report("servePath", count, nowNs() - started, latencies);
+
+    free(requests);
+    jsonWriterFree(&out);
+    if (nullFd >= 0) close(nullFd);
+}
+
+/**
+ * Column scans over the whole stored history, repeated for a stable
+ * figure; ops counts rows scanned
+ */
+static void benchColumnScans() {
+    const int repeats = 10;
+    ScanFilter filter;
+    initScanFilter(&filter);
+    filter.status = TXN_STATUS_SUSPICIOUS;
+
+    uint64_t started = nowNs();
+    for (int i = 0; i < repeats; i++) {
+        ScanTotals totals = scanTotals(&filter);
+        sink = totals.count;
+    }
+    report("scanSuspiciousTotal", (long)txnCount * repeats, nowNs() - started, NULL);
+
+    ScanTotals *perLocation = malloc((size_t)locationTable.count * sizeof(ScanTotals));
+    if (!perLocation) return;
+    started = nowNs();
+    for (int i = 0; i < repeats; i++) {
+        sink = scanTotalsByLocation(&filter, perLocation, locationTable.count);
+    }
+    report("scanSuspiciousByLocation", (long)txnCount * repeats, nowNs() - started, NULL);
+    free(perLocation);
+}
+
+/**
+ * First history page of 50 for each account in the workload, driven by
+ * the per-account index; ops counts pages
+ */
+static void benchHistoryPages(const Transaction *load, long count, uint64_t *latencies) {
+    int rows[50];
+    HistoryQuery query;
+    initHistoryQuery(&query);
+
+    uint64_t started = nowNs();
+    for (long i = 0; i < count; i++) {
+        uint64_t begin = nowNs();
+        long nextCursor;
+        query.accNo = load[i].accNo;
+        sink = queryHistoryPage(&query, HISTORY_FIRST_PAGE, 50, rows, &nextCursor);
+        latencies[i] = nowNs() - begin;
+    }
+    report("historyAccountPage", count, nowNs() - started, latencies);
+}
+
+static void writeBatchInput(const char *path, const Transaction *load, long count) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    JsonWriter out;
+    jsonWriterInit(&out, fd);
+    for (long i = 0; i < count; i++) {
+        jsonWriteLiteral(&out, "{\"txnId\": ");
+        jsonWriteInt(&out, load[i].txnId);
+        jsonWriteLiteral(&out, ", \"accNo\": ");
+        jsonWriteInt(&out, load[i].accNo);
+        jsonWriteLiteral(&out, ", \"amount\": ");
+        jsonWriteFixed2(&out, load[i].amount);
+        jsonWriteLiteral(&out, ", \"location\": ");
+        jsonWriteString(&out, locationName(load[i].location));
+        jsonWriteLiteral(&out, ", \"timestamp\": ");
+        jsonWriteInt(&out, (long)load[i].timestamp);
+        jsonWriteLiteral(&out, ", \"type\": ");
+        jsonWriteString(&out, txnTypeName(load[i].type));
+        jsonWriteLiteral(&out, "}\n");
+        jsonWriterFlushIfFull(&out);
+    }
+    if (!jsonWriterFlush(&out)) fprintf(stderr, "Warning: Could not write %s\n", path);
+    jsonWriterFree(&out);
+    if (fd >= 0) close(fd);
+}
+
+static void benchBatchScoring(const char *inputPath, long count, int threads) {
+    int nullFd = open("/dev/null", O_WRONLY);
+    uint64_t started = nowNs();
+    runBatchScoring(inputPath, nullFd, threads);
+    report("batchScoring", count, nowNs() - started, NULL);
+    if (nullFd >= 0) close(nullFd);
+}
+
+static void benchSaveAndLoad() {
+    long accounts = accountStore.count;
+    long stored = txnCount;
+
+    uint64_t started = nowNs();
+    saveAccountsToFile();
+    report("saveAccounts", accounts, nowNs() - started, NULL);
+
+    started = nowNs();
+    saveTransactionsToFile();
+    report("saveTransactions", stored, nowNs() - started, NULL);
+
+    freeAccountStore(&accountStore);
+    clearTransactions();
+    memset(&txnStatistics, 0, sizeof(txnStatistics));
+
+    started = nowNs();
+    loadAccountsFromFile();
+    report("loadAccounts", accountStore.count, nowNs() - started, NULL);
+
+    started = nowNs();
+    loadTransactionsFromFile();
+    report("loadTransactions", txnCount, nowNs() - started, NULL);
+
+    // Snapshot rows count transactions, the bulk of the image
+    started = nowNs();
+    saveSnapshot(DATA_FILE_SNAPSHOT);
+    report("saveSnapshot", stored, nowNs() - started, NULL);
+
+    freeAccountStore(&accountStore);
+    clearTransactions();
+    memset(&txnStatistics, 0, sizeof(txnStatistics));
+
+    started = nowNs();
+    loadSnapshot(DATA_FILE_SNAPSHOT);
+    report("loadSnapshot", txnCount, nowNs() - started, NULL);
+}
+
+static int parseOptions(int argc, char *argv[], SuiteOptions *options) {
+    defaultLoadProfile(&options->profile);
+    options->transactionCount = 1000000;
+    options->serveBatch = 32;
+    options->threads = 1;
+    options->workdir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!value) return 0;
+        if (strcmp(argv[i], "--seed") == 0) {
+            options->profile.seed = strtoull(value, NULL, 10);
+        } else if (strcmp(argv[i], "--accounts") == 0) {
+            options->profile.accountCount = atoi(value);
+        } else if (strcmp(argv[i], "--transactions") == 0) {
+            options->transactionCount = atol(value);
+        } else if (strcmp(argv[i], "--serve-batch") == 0) {
+            options->serveBatch = atoi(value);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            options->threads = atoi(value);
+        } else if (strcmp(argv[i], "--workdir") == 0) {
+            options->workdir = value;
+        } else {
+            return 0;
+        }
+        i++;
+    }
+    return options->profile.accountCount > 0 && options->transactionCount > 0 &&
+           options->serveBatch > 0 && options->threads > 0;
+}
+
+int main(int argc, char *argv[]) {
+    SuiteOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--seed N] [--accounts N] [--transactions N] "
+                        "[--serve-batch N] [--threads N] [--workdir DIR]\n", argv[0]);
+        return 1;
+    }
+
+    loadLocations();
+    loadFraudRules();
+    loadBlacklist();
+
+    // Generated files go to a scratch directory laid out like the repo's
+    static char scratch[] = "/tmp/fraudbench.XXXXXX";
+    const char *workdir = options.workdir ? options.workdir : mkdtemp(scratch);
+    if (!workdir || (mkdir(workdir, 0755) != 0 && access(workdir, W_OK) != 0) || chdir(workdir) != 0) {
+        fprintf(stderr, "Error: Could not use work directory %s\n", workdir ? workdir : scratch);
+        return 1;
+    }
+    mkdir("data", 0755);
+    unlink(DATA_FILE_JOURNAL);
+    if (!openJournal(DATA_FILE_JOURNAL)) {
+        fprintf(stderr, "Error: Could not open journal in %s\n", workdir);
+        return 1;
+    }
+    openAlertOutbox(DATA_FILE_ALERT_OUTBOX);
+
+    long count = options.transactionCount;
+    Transaction *load = malloc((size_t)count * sizeof(Transaction));
+    Transaction *work = malloc((size_t)count * sizeof(Transaction));
+    uint64_t *latencies = malloc((size_t)count * sizeof(uint64_t));
+    Account *pristine = malloc((size_t)options.profile.accountCount * sizeof(Account));
+    LoadGenerator generator;
+    if (!load || !work || !latencies || !pristine || !initLoadGenerator(&generator, &options.profile)) {
+        fprintf(stderr, "Error: Out of memory for %ld transactions\n", count);
+        return 1;
+    }
+
+    initAccountStore(&accountStore, options.profile.accountCount);
+    generateAccounts(&generator, &accountStore);
+    for (long i = 0; i < count; i++) {
+        nextTransaction(&generator, &load[i]);
+    }
+    memcpy(pristine, accountStore.accounts, (size_t)accountStore.count * sizeof(Account));
+    size_t accountBytes = (size_t)accountStore.count * sizeof(Account);
+
+    fprintf(stderr, "Workload: seed %llu, %d accounts, %ld transactions, work directory %s, %s scans\n",
+            (unsigned long long)options.profile.seed, options.profile.accountCount, count, workdir,
+            scanKernelName());
+    printf("benchmark,ops,seconds,opsPerSec,meanNs,p50Ns,p99Ns,p999Ns\n");
+
+    benchClock(latencies, count);
+    benchFindAccount(load, count, latencies);
+
+    memcpy(work, load, (size_t)count * sizeof(Transaction));
+    benchCheckFraud(work, count, latencies);
+    benchRiskScore(work, count, latencies);
+
+    // Each end-to-end run starts from the freshly generated account state
+    memcpy(accountStore.accounts, pristine, accountBytes);
+    writeBatchInput("load.jsonl", load, count);
+    benchBatchScoring("load.jsonl", count, options.threads);
+
+    memcpy(accountStore.accounts, pristine, accountBytes);
+    startServeWorkers(options.threads);
+    benchServePath(load, count, options.serveBatch, latencies);
+    stopServeWorkers();
+    benchColumnScans();
+    benchHistoryPages(load, count, latencies);
+
+    benchSaveAndLoad();
+
+    closeAlertOutbox();
+    closeJournal();
+    freeLoadGenerator(&generator);
+    free(pristine);
+    free(latencies);
+    free(work);
+    free(load);
+    return 0;
+}
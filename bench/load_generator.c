@@ -0,0 +1,199 @@
+/**
+ * Synthetic Load Generator for Fraud Detection System benchmarks
+ * Seeded, reproducible accounts and transaction streams with the shapes
+ * the rules look for: bursts, travel anomalies, round and micro amounts
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "load_generator.h"
+#include "string_arena.h"
+
+static const char *fallbackCities[] = {
+    "New York", "London", "Tokyo", "Paris", "Sydney", "Dubai", "Mumbai", "Singapore"
+};
+static const char *accountTypes[] = {"savings", "checking", "business", "premium"};
+
+void defaultLoadProfile(LoadProfile *profile) {
+    profile->seed = 42;
+    profile->accountCount = 100000;
+    profile->txnsPerSecond = 50.0;
+    profile->burstRate = 0.002;
+    profile->travelAnomalyRate = 0.001;
+    profile->roundAmountRate = 0.05;
+    profile->microAmountRate = 0.01;
+    profile->startTime = 1700000000;
+}
+
+// splitmix64: tiny, seedable and good enough for load shapes
+static inline uint64_t nextRandom(LoadGenerator *gen) {
+    uint64_t z = (gen->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+static inline double uniform(LoadGenerator *gen) {
+    return (nextRandom(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline int uniformInt(LoadGenerator *gen, int bound) {
+    return (int)(uniform(gen) * bound);
+}
+
+static double standardNormal(LoadGenerator *gen) {
+    double u = uniform(gen);
+    double v = uniform(gen);
+    return sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);
+}
+
+static double exponentialGap(LoadGenerator *gen, double rate) {
+    return -log(1.0 - uniform(gen)) / rate;
+}
+
+int initLoadGenerator(LoadGenerator *gen, const LoadProfile *profile) {
+    memset(gen, 0, sizeof(*gen));
+    gen->profile = *profile;
+    gen->state = profile->seed;
+    gen->nextTxnId = 1;
+
+    gen->cities = malloc((size_t)(locationTable.count + 8) * sizeof(LocationId));
+    gen->homes = malloc((size_t)(profile->accountCount > 0 ? profile->accountCount : 1) * sizeof(LocationId));
+    if (!gen->cities || !gen->homes) {
+        freeLoadGenerator(gen);
+        return 0;
+    }
+
+    // Only cities with coordinates take part in the travel checks
+    for (int id = 1; id < locationTable.count; id++) {
+        if (locationTable.locations[id].hasCoordinates) gen->cities[gen->cityCount++] = (LocationId)id;
+    }
+    if (gen->cityCount < 2) {
+        gen->cityCount = 0;
+        for (size_t i = 0; i < sizeof(fallbackCities) / sizeof(fallbackCities[0]); i++) {
+            gen->cities[gen->cityCount++] = internLocation(fallbackCities[i]);
+        }
+    }
+
+    for (int i = 0; i < profile->accountCount; i++) {
+        gen->homes[i] = gen->cities[uniformInt(gen, gen->cityCount)];
+    }
+    gen->nextArrival = exponentialGap(gen, profile->txnsPerSecond);
+    return 1;
+}
+
+void freeLoadGenerator(LoadGenerator *gen) {
+    free(gen->cities);
+    free(gen->homes);
+    gen->cities = NULL;
+    gen->homes = NULL;
+}
+
+int generateAccounts(LoadGenerator *gen, AccountStore *store) {
+    int added = 0;
+    char name[32];
+
+    for (int i = 0; i < gen->profile.accountCount; i++) {
+        Account account = {0};
+        int length = snprintf(name, sizeof(name), "Synthetic Holder %d", i);
+        account.accNo = LOAD_FIRST_ACC_NO + i;
+        account.name = arenaStrndup(&stringArena, name, (size_t)length);
+        account.balance = 1e9;      // large enough that scoring, not balance, decides
+        account.isActive = 1;
+        account.accountType = accountTypes[uniformInt(gen, 4)];
+        account.dailyLimit = 200000.0;
+        account.monthlyLimit = 2000000.0;
+        if (addAccount(store, &account)) added++;
+    }
+    return added;
+}
+
+static double randomAmount(LoadGenerator *gen) {
+    double roll = uniform(gen);
+    if (roll < gen->profile.microAmountRate) {
+        return 0.01 + uniformInt(gen, 99) / 100.0;
+    }
+
+    // Log-normal around 800 with a tail reaching the high-value tiers
+    double amount = exp(log(800.0) + 1.4 * standardNormal(gen));
+    if (roll < gen->profile.microAmountRate + gen->profile.roundAmountRate) {
+        amount = 1000.0 * (1 + (int)(amount / 1000.0));
+    }
+    return round(amount * 100.0) / 100.0;
+}
+
+// Hot accounts dominate, as in real traffic
+static int randomAccount(LoadGenerator *gen) {
+    double u = uniform(gen);
+    return (int)(u * u * gen->profile.accountCount);
+}
+
+static LocationId awayFrom(LoadGenerator *gen, LocationId home) {
+    LocationId city = gen->cities[uniformInt(gen, gen->cityCount)];
+    return (city != home) ? city : gen->cities[(uniformInt(gen, gen->cityCount - 1) + 1) % gen->cityCount];
+}
+
+static void schedule(LoadGenerator *gen, double at, int account, LocationId location, int remaining, double gap) {
+    if (gen->scheduledCount >= LOAD_MAX_SCHEDULED) return;
+    ScheduledTxn *entry = &gen->scheduled[gen->scheduledCount++];
+    entry->at = at;
+    entry->account = account;
+    entry->location = location;
+    entry->remaining = remaining;
+    entry->gap = gap;
+}
+
+static int earliestScheduled(const LoadGenerator *gen) {
+    int earliest = -1;
+    for (int i = 0; i < gen->scheduledCount; i++) {
+        if (earliest < 0 || gen->scheduled[i].at < gen->scheduled[earliest].at) earliest = i;
+    }
+    return earliest;
+}
+
+void nextTransaction(LoadGenerator *gen, Transaction *txn) {
+    memset(txn, 0, sizeof(*txn));
+    txn->txnId = gen->nextTxnId++;
+    txn->amount = randomAmount(gen);
+
+    double roll = uniform(gen);
+    txn->type = (roll < 0.8) ? TXN_TYPE_PURCHASE : (roll < 0.9) ? TXN_TYPE_TRANSFER : TXN_TYPE_WITHDRAWAL;
+
+    int account;
+    double at;
+    int next = earliestScheduled(gen);
+
+    if (next >= 0 && gen->scheduled[next].at <= gen->nextArrival) {
+        // Follow-up of a burst or travel anomaly
+        ScheduledTxn *entry = &gen->scheduled[next];
+        account = entry->account;
+        at = entry->at;
+        txn->location = entry->location;
+        if (entry->remaining > 0) {
+            entry->remaining--;
+            entry->at += entry->gap * (0.5 + uniform(gen));
+        } else {
+            *entry = gen->scheduled[--gen->scheduledCount];
+        }
+    } else {
+        account = randomAccount(gen);
+        at = gen->nextArrival;
+        txn->location = gen->homes[account];
+        gen->nextArrival += exponentialGap(gen, gen->profile.txnsPerSecond);
+
+        double anomaly = uniform(gen);
+        if (anomaly < gen->profile.burstRate) {
+            // 3-8 more transactions a few seconds apart
+            schedule(gen, at + 2.0 + uniform(gen) * 8.0, account, txn->location, 2 + uniformInt(gen, 6), 6.0);
+        } else if (anomaly < gen->profile.burstRate + gen->profile.travelAnomalyRate) {
+            // The same card shows up far away minutes later
+            schedule(gen, at + 60.0 + uniform(gen) * 840.0, account, awayFrom(gen, txn->location), 0, 0.0);
+        }
+    }
+
+    txn->accNo = LOAD_FIRST_ACC_NO + account;
+    txn->timestamp = gen->profile.startTime + (time_t)at;
+}
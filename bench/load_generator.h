@@ -0,0 +1,71 @@
+/**
+ * Synthetic Load Generator for Fraud Detection System benchmarks
+ * Seeded, reproducible accounts and transaction streams with the shapes
+ * the rules look for: bursts, travel anomalies, round and micro amounts
+ */
+
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <stdint.h>
+#include <time.h>
+#include "account_store.h"
+#include "transaction_log.h"
+
+#define LOAD_FIRST_ACC_NO 100000
+#define LOAD_MAX_SCHEDULED 64
+
+// Follow-up transactions of a burst or a travel anomaly
+typedef struct {
+    double at;                  // seconds since profile.startTime
+    int account;                // index from LOAD_FIRST_ACC_NO
+    LocationId location;
+    int remaining;              // further transactions after this one
+    double gap;                 // seconds between them
+} ScheduledTxn;
+
+typedef struct {
+    uint64_t seed;
+    int accountCount;
+    double txnsPerSecond;       // mean arrival rate across all accounts
+    double burstRate;           // chance a transaction starts a rapid burst
+    double travelAnomalyRate;   // chance a transaction is far from home
+    double roundAmountRate;
+    double microAmountRate;
+    time_t startTime;
+} LoadProfile;
+
+typedef struct {
+    LoadProfile profile;
+    uint64_t state;
+    double nextArrival;         // seconds since profile.startTime
+    int nextTxnId;
+    LocationId *homes;          // per account, index from LOAD_FIRST_ACC_NO
+    LocationId *cities;
+    int cityCount;
+    ScheduledTxn scheduled[LOAD_MAX_SCHEDULED];
+    int scheduledCount;
+} LoadGenerator;
+
+void defaultLoadProfile(LoadProfile *profile);
+
+/**
+ * Prepare a generator over the cities in locationTable (a fixed list is
+ * interned when no location file was loaded). Returns 0 on allocation
+ * failure.
+ */
+int initLoadGenerator(LoadGenerator *gen, const LoadProfile *profile);
+void freeLoadGenerator(LoadGenerator *gen);
+
+/**
+ * Add profile.accountCount accounts, numbered from LOAD_FIRST_ACC_NO.
+ * Returns the number added.
+ */
+int generateAccounts(LoadGenerator *gen, AccountStore *store);
+
+/**
+ * Next transaction of the stream, in timestamp order
+ */
+void nextTransaction(LoadGenerator *gen, Transaction *txn);
+
+#endif
@@ -0,0 +1,365 @@
+/**
+ * Blacklist for Fraud Detection System
+ * Blocked Bloom filter in front of an exact hashed key set, plus a CIDR
+ * trie for IP ranges. Snapshots are immutable and swapped atomically.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include "blacklist.h"
+#include "json_stream.h"
+#include "epoch_reclaim.h"
+
+#define BLOOM_BLOCK_WORDS 8         // 512 bits, one cache line
+#define BLOOM_BITS_PER_KEY 12
+#define BLOOM_PROBES 6
+
+// Keys collected while parsing, before the final sizes are known
+typedef struct {
+    uint64_t *keys;
+    size_t count;
+    size_t capacity;
+} KeyList;
+
+// Replaced snapshots are freed once no reader can still hold them
+static Blacklist *activeBlacklist = NULL;
+static EpochDomain blacklistDomain = EPOCH_DOMAIN_INITIALIZER;
+static __thread EpochReader *blacklistReader = NULL;
+static pthread_mutex_t reloadLock = PTHREAD_MUTEX_INITIALIZER;
+static int reloadRunning = 0;
+
+// splitmix64 finalizer: a bijection, so integer keys stay exact
+static inline uint64_t mixKey(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x ? x : 1;
+}
+
+static inline uint64_t tagKey(BlacklistKind kind, uint64_t value) {
+    return mixKey(value ^ ((uint64_t)kind << 56));
+}
+
+static uint64_t hashBytes(const char *text, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int addKey(KeyList *list, uint64_t key) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        uint64_t *grown = realloc(list->keys, capacity * sizeof(uint64_t));
+        if (!grown) return 0;
+        list->keys = grown;
+        list->capacity = capacity;
+    }
+    list->keys[list->count++] = key;
+    return 1;
+}
+
+static inline const uint64_t *bloomBlock(const Blacklist *blacklist, uint64_t key) {
+    uint32_t block = (uint32_t)(((key >> 32) * blacklist->bloomBlocks) >> 32);
+    return &blacklist->bloom[(size_t)block * BLOOM_BLOCK_WORDS];
+}
+
+static inline uint64_t bloomProbeBits(uint64_t key) {
+    return key * 0x9e3779b97f4a7c15ULL;
+}
+
+static void bloomAdd(Blacklist *blacklist, uint64_t key) {
+    uint64_t *block = (uint64_t *)bloomBlock(blacklist, key);
+    uint64_t bits = bloomProbeBits(key);
+    for (int i = 0; i < BLOOM_PROBES; i++) {
+        uint32_t bit = (uint32_t)(bits >> (i * 9)) & 511;
+        block[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+static inline int bloomMayContain(const Blacklist *blacklist, uint64_t key) {
+    const uint64_t *block = bloomBlock(blacklist, key);
+    uint64_t bits = bloomProbeBits(key);
+    for (int i = 0; i < BLOOM_PROBES; i++) {
+        uint32_t bit = (uint32_t)(bits >> (i * 9)) & 511;
+        if (!(block[bit >> 6] & (1ULL << (bit & 63)))) return 0;
+    }
+    return 1;
+}
+
+static int setInsert(Blacklist *blacklist, uint64_t key) {
+    uint32_t slot = (uint32_t)key & blacklist->keyMask;
+    while (blacklist->keys[slot] != 0) {
+        if (blacklist->keys[slot] == key) return 0;
+        slot = (slot + 1) & blacklist->keyMask;
+    }
+    blacklist->keys[slot] = key;
+    return 1;
+}
+
+static int containsKey(const Blacklist *blacklist, uint64_t key) {
+    if (!bloomMayContain(blacklist, key)) return 0;
+
+    uint32_t slot = (uint32_t)key & blacklist->keyMask;
+    while (blacklist->keys[slot] != 0) {
+        if (blacklist->keys[slot] == key) return 1;
+        slot = (slot + 1) & blacklist->keyMask;
+    }
+    return 0;
+}
+
+static int addIpPrefix(Blacklist *blacklist, int *capacity, uint32_t ip, int prefix) {
+    int node = 0;
+
+    for (int depth = 0; depth < prefix; depth++) {
+        int bit = (ip >> (31 - depth)) & 1;
+        if (blacklist->ipTrie[node].child[bit] == 0) {
+            if (blacklist->ipTrieCount == *capacity) {
+                int grownCapacity = *capacity * 2;
+                IpTrieNode *grown = realloc(blacklist->ipTrie, grownCapacity * sizeof(IpTrieNode));
+                if (!grown) return 0;
+                blacklist->ipTrie = grown;
+                *capacity = grownCapacity;
+            }
+            memset(&blacklist->ipTrie[blacklist->ipTrieCount], 0, sizeof(IpTrieNode));
+            blacklist->ipTrie[node].child[bit] = blacklist->ipTrieCount++;
+        }
+        node = blacklist->ipTrie[node].child[bit];
+    }
+
+    blacklist->ipTrie[node].terminal = 1;
+    return 1;
+}
+
+int parseIpv4(const char *text, size_t length, uint32_t *ip, int *prefix) {
+    const char *p = text;
+    const char *end = text + length;
+    uint32_t address = 0;
+
+    for (int octet = 0; octet < 4; octet++) {
+        if (p >= end || *p < '0' || *p > '9') return 0;
+        int value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p++ - '0');
+            if (value > 255) return 0;
+        }
+        address = (address << 8) | (uint32_t)value;
+        if (octet < 3) {
+            if (p >= end || *p != '.') return 0;
+            p++;
+        }
+    }
+
+    int bits = 32;
+    if (p < end && *p == '/') {
+        p++;
+        if (p >= end) return 0;
+        bits = 0;
+        while (p < end && *p >= '0' && *p <= '9') bits = bits * 10 + (*p++ - '0');
+        if (bits > 32) return 0;
+    }
+    if (p != end) return 0;
+
+    // Clear host bits so "10.1.2.3/8" means 10.0.0.0/8
+    *ip = bits ? address & (0xffffffffu << (32 - bits)) : 0;
+    *prefix = bits;
+    return 1;
+}
+
+static void freeBlacklist(Blacklist *blacklist) {
+    if (!blacklist) return;
+    free(blacklist->bloom);
+    free(blacklist->keys);
+    free(blacklist->ipTrie);
+    free(blacklist);
+}
+
+static void parseList(JsonStream *stream, BlacklistKind kind, KeyList *keys,
+                      Blacklist *blacklist, int *trieCapacity) {
+    JsonToken item;
+
+    while (jsonNext(stream, &item) && item.type != JSON_TOKEN_ARRAY_END) {
+        uint64_t key = 0;
+
+        if (kind == BLACKLIST_ACCOUNT && item.type == JSON_TOKEN_NUMBER) {
+            key = tagKey(kind, (uint32_t)(int)item.number);
+        } else if (kind == BLACKLIST_LOCATION && item.type == JSON_TOKEN_STRING) {
+            key = tagKey(kind, hashLocationName(item.text, item.length));
+        } else if (kind == BLACKLIST_MERCHANT && item.type == JSON_TOKEN_STRING) {
+            key = tagKey(kind, hashBytes(item.text, item.length));
+        } else if (kind == BLACKLIST_IP && item.type == JSON_TOKEN_STRING) {
+            uint32_t ip;
+            int prefix;
+            if (!parseIpv4(item.text, item.length, &ip, &prefix)) {
+                fprintf(stderr, "Warning: Ignoring malformed blacklisted IP \"%.*s\"\n", (int)item.length, item.text);
+                continue;
+            }
+            if (prefix < 32) {
+                if (addIpPrefix(blacklist, trieCapacity, ip, prefix)) blacklist->counts[kind]++;
+                continue;
+            }
+            key = tagKey(kind, ip);
+        } else {
+            jsonSkipValue(stream, &item);
+            continue;
+        }
+
+        if (addKey(keys, key)) blacklist->counts[kind]++;
+    }
+}
+
+/**
+ * Parse the file and build a complete snapshot. Returns NULL on failure.
+ */
+static Blacklist *buildBlacklist(const char *path) {
+    JsonStream stream;
+    JsonToken key, value;
+    KeyList keys = {0};
+    int trieCapacity = 64;
+
+    if (!jsonOpenFile(&stream, path)) return NULL;
+
+    Blacklist *blacklist = calloc(1, sizeof(Blacklist));
+    if (blacklist) blacklist->ipTrie = calloc(trieCapacity, sizeof(IpTrieNode));
+    if (!blacklist || !blacklist->ipTrie) {
+        freeBlacklist(blacklist);
+        jsonClose(&stream);
+        return NULL;
+    }
+    blacklist->ipTrieCount = 1;
+
+    if (jsonNext(&stream, &key) && key.type == JSON_TOKEN_OBJECT_BEGIN) {
+        while (jsonNext(&stream, &key) && key.type == JSON_TOKEN_KEY) {
+            if (!jsonNext(&stream, &value)) break;
+
+            BlacklistKind kind = 0;
+            if (jsonTokenIs(&key, "blacklistedAccounts")) kind = BLACKLIST_ACCOUNT;
+            else if (jsonTokenIs(&key, "blacklistedLocations")) kind = BLACKLIST_LOCATION;
+            else if (jsonTokenIs(&key, "blacklistedIPs")) kind = BLACKLIST_IP;
+            else if (jsonTokenIs(&key, "blacklistedMerchants")) kind = BLACKLIST_MERCHANT;
+
+            if (kind && value.type == JSON_TOKEN_ARRAY_BEGIN) {
+                parseList(&stream, kind, &keys, blacklist, &trieCapacity);
+            } else {
+                jsonSkipValue(&stream, &value);
+            }
+        }
+    }
+
+    jsonClose(&stream);
+
+    // Exact set at most two-thirds full; Bloom filter at ~1% false positives
+    uint32_t slots = 16;
+    while (slots < keys.count + keys.count / 2) slots <<= 1;
+    blacklist->keyMask = slots - 1;
+    blacklist->bloomBlocks = (uint32_t)((keys.count * BLOOM_BITS_PER_KEY + 511) / 512);
+    if (blacklist->bloomBlocks == 0) blacklist->bloomBlocks = 1;
+
+    blacklist->keys = calloc(slots, sizeof(uint64_t));
+    blacklist->bloom = calloc((size_t)blacklist->bloomBlocks * BLOOM_BLOCK_WORDS, sizeof(uint64_t));
+    if (!blacklist->keys || !blacklist->bloom) {
+        free(keys.keys);
+        freeBlacklist(blacklist);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < keys.count; i++) {
+        if (setInsert(blacklist, keys.keys[i])) bloomAdd(blacklist, keys.keys[i]);
+    }
+    free(keys.keys);
+    return blacklist;
+}
+
+const Blacklist *acquireBlacklist() {
+    enterEpoch(&blacklistDomain, &blacklistReader);
+    return __atomic_load_n(&activeBlacklist, __ATOMIC_SEQ_CST);
+}
+
+void releaseBlacklist() {
+    leaveEpoch(blacklistReader);
+}
+
+int reloadBlacklist(const char *path) {
+    Blacklist *fresh = buildBlacklist(path);
+    if (!fresh) return 0;
+
+    pthread_mutex_lock(&reloadLock);
+    Blacklist *previous = __atomic_exchange_n(&activeBlacklist, fresh, __ATOMIC_SEQ_CST);
+    synchronizeEpoch(&blacklistDomain);
+    pthread_mutex_unlock(&reloadLock);
+    freeBlacklist(previous);
+
+    fprintf(stderr, "Blacklist loaded: %d accounts, %d locations, %d IPs, %d merchants\n",
+            fresh->counts[BLACKLIST_ACCOUNT], fresh->counts[BLACKLIST_LOCATION],
+            fresh->counts[BLACKLIST_IP], fresh->counts[BLACKLIST_MERCHANT]);
+    return 1;
+}
+
+static void *reloadThread(void *arg) {
+    char *path = arg;
+    if (!reloadBlacklist(path)) {
+        fprintf(stderr, "Warning: Blacklist reload failed, keeping the previous snapshot\n");
+    }
+    free(path);
+    __atomic_store_n(&reloadRunning, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int reloadBlacklistInBackground(const char *path) {
+    if (__atomic_exchange_n(&reloadRunning, 1, __ATOMIC_ACQ_REL)) return 0;
+
+    pthread_t thread;
+    pthread_attr_t attributes;
+    char *pathCopy = strdup(path);
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    // SIGHUP is for the serve thread, whose read() it interrupts
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    int started = pathCopy && pthread_create(&thread, &attributes, reloadThread, pathCopy) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    pthread_attr_destroy(&attributes);
+
+    if (!started) {
+        free(pathCopy);
+        __atomic_store_n(&reloadRunning, 0, __ATOMIC_RELEASE);
+        return 0;
+    }
+    return 1;
+}
+
+int blacklistHasAccount(const Blacklist *blacklist, int accNo) {
+    return containsKey(blacklist, tagKey(BLACKLIST_ACCOUNT, (uint32_t)accNo));
+}
+
+int blacklistHasLocation(const Blacklist *blacklist, LocationId location) {
+    if (location == LOCATION_NONE || location >= locationTable.count) return 0;
+    return containsKey(blacklist, tagKey(BLACKLIST_LOCATION, locationTable.locations[location].nameHash));
+}
+
+int blacklistHasMerchant(const Blacklist *blacklist, const char *merchant, size_t length) {
+    return containsKey(blacklist, tagKey(BLACKLIST_MERCHANT, hashBytes(merchant, length)));
+}
+
+int blacklistHasIp(const Blacklist *blacklist, uint32_t ip) {
+    if (containsKey(blacklist, tagKey(BLACKLIST_IP, ip))) return 1;
+
+    int node = 0;
+    for (int depth = 0; ; depth++) {
+        if (blacklist->ipTrie[node].terminal) return 1;
+        if (depth == 32) return 0;
+        node = blacklist->ipTrie[node].child[(ip >> (31 - depth)) & 1];
+        if (node == 0) return 0;
+    }
+}
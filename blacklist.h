@@ -0,0 +1,80 @@
+/**
+ * Blacklist for Fraud Detection System
+ * Blocked Bloom filter in front of an exact hashed key set, plus a CIDR
+ * trie for IP ranges. Snapshots are immutable and swapped atomically.
+ */
+
+#ifndef BLACKLIST_H
+#define BLACKLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "location_table.h"
+
+#define DATA_FILE_BLACKLIST "data/blacklist.json"
+
+typedef enum {
+    BLACKLIST_ACCOUNT = 1,
+    BLACKLIST_LOCATION,
+    BLACKLIST_IP,
+    BLACKLIST_MERCHANT
+} BlacklistKind;
+
+// Binary trie node for IPv4 prefixes shorter than /32
+typedef struct {
+    int32_t child[2];           // node index, 0 = none (node 0 is the root)
+    int terminal;               // a blacklisted prefix ends here
+} IpTrieNode;
+
+typedef struct {
+    // Blocked Bloom filter: every probe for a key lands in one 64-byte block
+    uint64_t *bloom;
+    uint32_t bloomBlocks;
+
+    // Open-addressed exact set of tagged key hashes (0 = empty slot)
+    uint64_t *keys;
+    uint32_t keyMask;
+
+    IpTrieNode *ipTrie;
+    int ipTrieCount;
+
+    int counts[BLACKLIST_MERCHANT + 1];     // entries per BlacklistKind
+} Blacklist;
+
+/**
+ * Snapshot in effect, held until releaseBlacklist(), or NULL when none has
+ * been loaded. A reload frees the old snapshot only after every read that
+ * could still see it has ended. Reads must not nest; keep them to the
+ * lookups for one transaction or request.
+ */
+const Blacklist *acquireBlacklist();
+void releaseBlacklist();
+
+/**
+ * Build a snapshot from the file and swap it in. Returns 0 (keeping the
+ * current snapshot) if the file cannot be read. Must not be called while
+ * this thread holds the blacklist.
+ */
+int reloadBlacklist(const char *path);
+
+/**
+ * Run reloadBlacklist() on a detached thread so scoring never waits on it.
+ * Returns 0 if a reload is already in progress or the thread fails to start.
+ */
+int reloadBlacklistInBackground(const char *path);
+
+int blacklistHasAccount(const Blacklist *blacklist, int accNo);
+int blacklistHasLocation(const Blacklist *blacklist, LocationId location);
+int blacklistHasMerchant(const Blacklist *blacklist, const char *merchant, size_t length);
+
+/**
+ * Exact address or any blacklisted range containing it. ip is host order.
+ */
+int blacklistHasIp(const Blacklist *blacklist, uint32_t ip);
+
+/**
+ * Parse dotted-quad IPv4 with an optional "/prefix". Returns 0 if malformed.
+ */
+int parseIpv4(const char *text, size_t length, uint32_t *ip, int *prefix);
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * Column Scans for Fraud Detection System
+ * Filter, count and sum kernels over the columnar transaction history,
+ * vectorized with AVX2 when the CPU has it and scalar otherwise. Sealed
+ * blocks are decoded and scanned by the same kernels.
+ */
+
+#include <string.h>
+#include "column_scan.h"
+#include "history_segments.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SCAN_HAVE_AVX2 1
+#endif
+
+typedef void (*ScanKernel)(const TransactionColumns *columns, const ScanFilter *filter, int begin, int end,
+                           ScanTotals *totals, ScanTotals *perLocation, int locationCount);
+
+void initScanFilter(ScanFilter *filter) {
+    filter->from = (time_t)INT64_MIN;
+    filter->to = (time_t)INT64_MAX;
+    filter->status = SCAN_ANY_STATUS;
+    filter->anyAlerts = 0;
+    filter->location = LOCATION_NONE;
+}
+
+static inline int rowMatches(const TransactionColumns *columns, const ScanFilter *filter, int row) {
+    int64_t timestamp = columns->timestamps[row];
+    return timestamp >= (int64_t)filter->from && timestamp <= (int64_t)filter->to &&
+           (filter->status == SCAN_ANY_STATUS || columns->statuses[row] == filter->status) &&
+           (filter->anyAlerts == 0 || (columns->alertMasks[row] & filter->anyAlerts)) &&
+           (filter->location == LOCATION_NONE || columns->locations[row] == filter->location);
+}
+
+static inline void addRow(const TransactionColumns *columns, int row,
+                          ScanTotals *totals, ScanTotals *perLocation, int locationCount) {
+    double amount = columns->amounts[row];
+    totals->count++;
+    totals->amount += amount;
+    if (perLocation) {
+        LocationId location = columns->locations[row];
+        if (location < locationCount) {
+            perLocation[location].count++;
+            perLocation[location].amount += amount;
+        }
+    }
+}
+
+static void scanScalar(const TransactionColumns *columns, const ScanFilter *filter, int begin, int end,
+                       ScanTotals *totals, ScanTotals *perLocation, int locationCount) {
+    for (int row = begin; row < end; row++) {
+        if (rowMatches(columns, filter, row)) addRow(columns, row, totals, perLocation, locationCount);
+    }
+}
+
+#ifdef SCAN_HAVE_AVX2
+
+/**
+ * Four rows per step: each condition becomes a 64-bit lane mask, the
+ * masks are ANDed, and the amount sum and count accumulate branch-free.
+ * Grouping by location walks only the matching lanes.
+ */
+__attribute__((target("avx2")))
+static void scanAvx2(const TransactionColumns *columns, const ScanFilter *filter, int begin, int end,
+                     ScanTotals *totals, ScanTotals *perLocation, int locationCount) {
+    const __m256i allOnes = _mm256_set1_epi64x(-1);
+    // Inclusive bounds via strict compares; the extremes cannot be widened
+    const __m256i afterFrom = _mm256_set1_epi64x((int64_t)filter->from == INT64_MIN ? INT64_MIN : (int64_t)filter->from - 1);
+    const __m256i beforeTo = _mm256_set1_epi64x((int64_t)filter->to == INT64_MAX ? INT64_MAX : (int64_t)filter->to + 1);
+    const int checkFrom = (int64_t)filter->from != INT64_MIN;
+    const int checkTo = (int64_t)filter->to != INT64_MAX;
+    const __m256i status = _mm256_set1_epi64x(filter->status);
+    const __m256i alerts = _mm256_set1_epi64x(filter->anyAlerts);
+    const __m256i location = _mm256_set1_epi64x(filter->location);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256d amountSum = _mm256_setzero_pd();
+    __m256i matchCount = _mm256_setzero_si256();
+    int row = begin;
+
+    for (; row + 4 <= end; row += 4) {
+        __m256i timestamps = _mm256_loadu_si256((const __m256i *)(columns->timestamps + row));
+        __m256i mask = allOnes;
+        if (checkFrom) mask = _mm256_and_si256(mask, _mm256_cmpgt_epi64(timestamps, afterFrom));
+        if (checkTo) mask = _mm256_and_si256(mask, _mm256_cmpgt_epi64(beforeTo, timestamps));
+
+        if (filter->status != SCAN_ANY_STATUS) {
+            int32_t packed;
+            memcpy(&packed, columns->statuses + row, sizeof(packed));
+            __m256i statuses = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+            mask = _mm256_and_si256(mask, _mm256_cmpeq_epi64(statuses, status));
+        }
+        if (filter->anyAlerts) {
+            __m256i masks = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(columns->alertMasks + row)));
+            __m256i none = _mm256_cmpeq_epi64(_mm256_and_si256(masks, alerts), zero);
+            mask = _mm256_andnot_si256(none, mask);
+        }
+        if (filter->location != LOCATION_NONE) {
+            __m256i locations = _mm256_cvtepu16_epi64(_mm_loadl_epi64((const __m128i *)(columns->locations + row)));
+            mask = _mm256_and_si256(mask, _mm256_cmpeq_epi64(locations, location));
+        }
+
+        __m256d amounts = _mm256_loadu_pd(columns->amounts + row);
+        amountSum = _mm256_add_pd(amountSum, _mm256_and_pd(amounts, _mm256_castsi256_pd(mask)));
+        matchCount = _mm256_sub_epi64(matchCount, mask);
+
+        if (perLocation) {
+            int lanes = _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+            while (lanes) {
+                int lane = __builtin_ctz(lanes);
+                lanes &= lanes - 1;
+                LocationId id = columns->locations[row + lane];
+                if (id < locationCount) {
+                    perLocation[id].count++;
+                    perLocation[id].amount += columns->amounts[row + lane];
+                }
+            }
+        }
+    }
+
+    double sums[4];
+    int64_t counts[4];
+    _mm256_storeu_pd(sums, amountSum);
+    _mm256_storeu_si256((__m256i *)counts, matchCount);
+    totals->amount += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    totals->count += counts[0] + counts[1] + counts[2] + counts[3];
+
+    scanScalar(columns, filter, row, end, totals, perLocation, locationCount);
+}
+
+#endif
+
+static ScanKernel selectKernel() {
+    static ScanKernel kernel = NULL;
+    if (!kernel) {
+#ifdef SCAN_HAVE_AVX2
+        kernel = __builtin_cpu_supports("avx2") ? scanAvx2 : scanScalar;
+#else
+        kernel = scanScalar;
+#endif
+    }
+    return kernel;
+}
+
+const char *scanKernelName() {
+#ifdef SCAN_HAVE_AVX2
+    if (selectKernel() == scanAvx2) return "avx2";
+#endif
+    return "scalar";
+}
+
+// First logical row with timestamp >= value in time-ordered memory rows
+static int lowerBound(int64_t value) {
+    int low = txnColumns.firstRow;
+    int high = txnCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (txnColumns.timestamps[txnSlot(middle)] < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void scanRows(const ScanFilter *filter, ScanTotals *totals, ScanTotals *perLocation, int locationCount) {
+    ScanKernel kernel = selectKernel();
+
+    // Sealed rows: only blocks whose time range overlaps are decoded
+    for (int block = 0; block < sealedBlockCount(); block++) {
+        const SealedBlock *summary = sealedBlock(block);
+        if (summary->firstRow >= txnColumns.firstRow) break;
+        if (summary->maxTime < (int64_t)filter->from || summary->minTime > (int64_t)filter->to) continue;
+
+        const TransactionColumns *columns = readSealedBlock(NULL, block);
+        if (!columns) continue;
+
+        // A block may reach into rows still held in memory after a restart
+        int rowCount = summary->rowCount;
+        if (summary->firstRow + rowCount > txnColumns.firstRow) rowCount = txnColumns.firstRow - summary->firstRow;
+        kernel(columns, filter, 0, rowCount, totals, perLocation, locationCount);
+    }
+
+    int begin = txnColumns.firstRow;
+    int end = txnCount;
+
+    // Appends are normally in time order, so a range only touches its rows
+    if (txnColumns.timeOrdered) {
+        begin = lowerBound((int64_t)filter->from);
+        end = ((int64_t)filter->to == INT64_MAX) ? txnCount : lowerBound((int64_t)filter->to + 1);
+    }
+
+    // The ring wraps at most once, so the rows are at most two runs of slots
+    SlotRun runs[2];
+    int runCount = (begin < end) ? hotSlotRuns(begin, end, runs) : 0;
+    for (int i = 0; i < runCount; i++) {
+        kernel(&txnColumns, filter, runs[i].start, runs[i].start + runs[i].count, totals, perLocation, locationCount);
+    }
+}
+
+ScanTotals scanTotals(const ScanFilter *filter) {
+    ScanTotals totals = {0, 0.0};
+    scanRows(filter, &totals, NULL, 0);
+    return totals;
+}
+
+long scanTotalsByLocation(const ScanFilter *filter, ScanTotals *perLocation, int locationCount) {
+    ScanTotals totals = {0, 0.0};
+    memset(perLocation, 0, (size_t)locationCount * sizeof(ScanTotals));
+    scanRows(filter, &totals, perLocation, locationCount);
+    return totals.count;
+}
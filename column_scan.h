@@ -0,0 +1,49 @@
+/**
+ * Column Scans for Fraud Detection System
+ * Filter, count and sum kernels over the columnar transaction history,
+ * vectorized with AVX2 when the CPU has it and scalar otherwise
+ */
+
+#ifndef COLUMN_SCAN_H
+#define COLUMN_SCAN_H
+
+#include <stdint.h>
+#include <time.h>
+#include "transaction_log.h"
+
+#define SCAN_ANY_STATUS -1
+
+// A row matches when every set condition holds
+typedef struct {
+    time_t from;                // inclusive timestamp range
+    time_t to;
+    int status;                 // TxnStatus, or SCAN_ANY_STATUS
+    uint32_t anyAlerts;         // at least one of these alerts; 0 = no filter
+    LocationId location;        // LOCATION_NONE = any location
+} ScanFilter;
+
+typedef struct {
+    long count;
+    double amount;
+} ScanTotals;
+
+/**
+ * Filter matching every stored row; narrow the fields from here
+ */
+void initScanFilter(ScanFilter *filter);
+
+ScanTotals scanTotals(const ScanFilter *filter);
+
+/**
+ * Totals per location: perLocation[id] for every LocationId below
+ * locationCount (rows at higher IDs are not counted). Returns the
+ * number of rows that matched.
+ */
+long scanTotalsByLocation(const ScanFilter *filter, ScanTotals *perLocation, int locationCount);
+
+/**
+ * Name of the kernel set in use ("avx2" or "scalar")
+ */
+const char *scanKernelName();
+
+#endif
@@ -14,7 +14,11 @@ if ! command -v gcc &> /dev/null; then
 fi
 
 # Compile the C program
-gcc -o fraudbackend fraudbackend.c -std=c99
+ENGINE_SOURCES="account_store.c transaction_log.c statistics.c alert_codes.c location_table.c rule_engine.c blacklist.c fraud_engine.c journal.c string_arena.c json_stream.c data_manager.c data_export.c batch_scoring.c json_writer.c metrics.c column_scan.c history_index.c history_segments.c snapshot.c alert_outbox.c behavior_profile.c backtest.c util.c epoch_reclaim.c serve_pipeline.c"
+# EXTRA_CFLAGS=-DFRAUD_NO_METRICS ./compile.sh builds without instrumentation
+CFLAGS="-std=c99 -O2 -D_GNU_SOURCE -I. $EXTRA_CFLAGS"
+LIBS="-lm -pthread"
+gcc -o fraudbackend fraudbackend.c $ENGINE_SOURCES $CFLAGS $LIBS
 
 # Check if compilation was successful
 if [ $? -eq 0 ]; then
@@ -23,8 +27,12 @@ if [ $? -eq 0 ]; then
     echo ""
     echo "🚀 Usage:"
     echo "  Process transaction: ./fraudbackend <accNo> <amount> <location>"
+    echo "  Persistent server:  ./fraudbackend --serve   (TXN <accNo> <amount> <location> per line)"
     echo "  View accounts:      ./fraudbackend --accounts"
-    echo "  View history:       ./fraudbackend --history"
+    echo "  View history:       ./fraudbackend --history [limit]"
+    echo "  View statistics:    ./fraudbackend --stats"
+    echo "  Batch scoring:      ./fraudbackend --batch <in.jsonl|in.csv> [out] [--threads N]"
+    echo "  Backtest rules:     ./fraudbackend --backtest [rules.json ...] [--threads N]"
     echo "  Help:               ./fraudbackend --help"
 else
     echo "❌ Compilation failed!"
@@ -33,3 +41,10 @@ fi
 
 # Make executable
 chmod +x fraudbackend
+
+# Optional benchmarks: ./compile.sh bench
+if [ "$1" == "bench" ]; then
+    gcc -o bench_rapid_window bench/bench_rapid_window.c $ENGINE_SOURCES $CFLAGS $LIBS || exit 1
+    gcc -o bench_suite bench/bench_suite.c bench/load_generator.c $ENGINE_SOURCES $CFLAGS $LIBS || exit 1
+    echo "📈 Benchmarks created: bench_rapid_window, bench_suite"
+fi
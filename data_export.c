@@ -2,85 +2,306 @@
  * Data Export Functions for Web Integration
  */
 
-#include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include <time.h>
+#include "data_export.h"
+#include "account_store.h"
+#include "transaction_log.h"
+#include "alert_codes.h"
+#include "location_table.h"
+#include "statistics.h"
+#include "history_index.h"
+
+#define MAX_INDENT 32
+
+static const char spaces[MAX_INDENT + 1] = "                                ";
+
+static inline void writeIndent(JsonWriter *out, int indent) {
+    if (indent <= 0) return;
+    jsonWriteRaw(out, spaces, (size_t)(indent < MAX_INDENT ? indent : MAX_INDENT));
+}
+
+/**
+ * Start a member: separator, newline, indent and the quoted key. Compact
+ * records (negative indent) keep every member on one line.
+ */
+static inline void writeMember(JsonWriter *out, int indent, const char *key, int first) {
+    if (indent < 0) {
+        if (!first) jsonWriteLiteral(out, ", ");
+    } else if (first) {
+        jsonWriteLiteral(out, "\n");
+    } else {
+        jsonWriteLiteral(out, ",\n");
+    }
+    writeIndent(out, indent);
+    jsonWriteString(out, key);
+    jsonWriteLiteral(out, ": ");
+}
+
+void writeAccountRecord(JsonWriter *out, const Account *account, int indent) {
+    int fields = indent + 2;
+
+    jsonWriteLiteral(out, "{");
+    writeMember(out, fields, "accNo", 1);
+    jsonWriteInt(out, account->accNo);
+    writeMember(out, fields, "name", 0);
+    jsonWriteString(out, account->name);
+    writeMember(out, fields, "balance", 0);
+    jsonWriteFixed2(out, account->balance);
+    writeMember(out, fields, "lastLocation", 0);
+    jsonWriteString(out, locationName(account->lastLocation));
+    writeMember(out, fields, "lastTxnTime", 0);
+    jsonWriteTimestamp(out, account->lastTxnTime);
+    writeMember(out, fields, "isActive", 0);
+    jsonWriteBool(out, account->isActive);
+    writeMember(out, fields, "accountType", 0);
+    jsonWriteString(out, account->accountType);
+    writeMember(out, fields, "dailyLimit", 0);
+    jsonWriteFixed2(out, account->dailyLimit);
+    writeMember(out, fields, "monthlyLimit", 0);
+    jsonWriteFixed2(out, account->monthlyLimit);
+    jsonWriteLiteral(out, "\n");
+    writeIndent(out, indent);
+    jsonWriteLiteral(out, "}");
+}
+
+void writeTransactionRecord(JsonWriter *out, const Transaction *txn, int indent) {
+    int fields = (indent < 0) ? COMPACT_RECORD : indent + 2;
+
+    jsonWriteLiteral(out, "{");
+    writeMember(out, fields, "txnId", 1);
+    jsonWriteInt(out, txn->txnId);
+    writeMember(out, fields, "accNo", 0);
+    jsonWriteInt(out, txn->accNo);
+    writeMember(out, fields, "amount", 0);
+    jsonWriteFixed2(out, txn->amount);
+    writeMember(out, fields, "location", 0);
+    jsonWriteString(out, locationName(txn->location));
+    writeMember(out, fields, "timestamp", 0);
+    jsonWriteTimestamp(out, txn->timestamp);
+    writeMember(out, fields, "status", 0);
+    jsonWriteString(out, txnStatusName(txn->status));
+    writeMember(out, fields, "type", 0);
+    jsonWriteString(out, txnTypeName(txn->type));
+    writeMember(out, fields, "riskScore", 0);
+    jsonWriteInt(out, txn->riskScore);
+    writeMember(out, fields, "ruleVersion", 0);
+    jsonWriteInt(out, txn->ruleVersion);
+
+    // Alert text is only materialized here, from the mask
+    writeMember(out, fields, "alerts", 0);
+    jsonWriteLiteral(out, "[");
+    writeAlertList(out, txn->alertMask);
+    if (indent < 0) {
+        jsonWriteLiteral(out, "]}");
+        return;
+    }
+    jsonWriteLiteral(out, "]\n");
+    writeIndent(out, indent);
+    jsonWriteLiteral(out, "}");
+}
 
 // Export accounts to JSON
-void exportAccountsToJSON() {
-    printf("{\"accounts\": [");
-    for (int i = 0; i < accountCount; i++) {
-        char timeStr[30];
-        strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", 
-                gmtime(&accounts[i].lastTxnTime));
-        
-        printf("%s{\n", (i > 0 ? "," : ""));
-        printf("  \"accNo\": %d,\n", accounts[i].accNo);
-        printf("  \"name\": \"%s\",\n", accounts[i].name);
-        printf("  \"balance\": %.2f,\n", accounts[i].balance);
-        printf("  \"lastLocation\": \"%s\",\n", accounts[i].lastLocation);
-        printf("  \"lastTxnTime\": \"%s\",\n", timeStr);
-        printf("  \"isActive\": %s,\n", accounts[i].isActive ? "true" : "false");
-        printf("  \"accountType\": \"%s\",\n", accounts[i].accountType);
-        printf("  \"dailyLimit\": %.2f,\n", accounts[i].dailyLimit);
-        printf("  \"monthlyLimit\": %.2f\n", accounts[i].monthlyLimit);
-        printf("}");
+void exportAccountsToJSON(JsonWriter *out) {
+    jsonWriteLiteral(out, "{\"accounts\": [");
+    for (int i = 0; i < accountStore.count; i++) {
+        if (i > 0) jsonWriteLiteral(out, ",");
+        writeAccountRecord(out, &accountStore.accounts[i], 0);
+        jsonWriterFlushIfFull(out);
     }
-    printf("]}");
+    jsonWriteLiteral(out, "]}");
 }
 
 // Export transactions to JSON
-void exportTransactionsToJSON(int limit) {
+void exportTransactionsToJSON(JsonWriter *out, int limit) {
     if (limit <= 0 || limit > txnCount) limit = txnCount;
     
-    printf("{\"transactions\": [");
+    jsonWriteLiteral(out, "{\"transactions\": [");
     for (int i = 0; i < limit; i++) {
-        int index = txnCount - 1 - i; // Most recent first
-        char timeStr[30];
-        strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", 
-                gmtime(&transactions[index].timestamp));
-        
-        printf("%s{\n", (i > 0 ? "," : ""));
-        printf("  \"txnId\": %d,\n", transactions[index].txnId);
-        printf("  \"accNo\": %d,\n", transactions[index].accNo);
-        printf("  \"amount\": %.2f,\n", transactions[index].amount);
-        printf("  \"location\": \"%s\",\n", transactions[index].location);
-        printf("  \"timestamp\": \"%s\",\n", timeStr);
-        printf("  \"status\": \"%s\",\n", transactions[index].status);
-        printf("  \"type\": \"%s\",\n", transactions[index].type);
-        printf("  \"alerts\": \"%s\"\n", transactions[index].alerts);
-        printf("}");
+        Transaction txn;
+        readTransaction(txnCount - 1 - i, &txn); // Most recent first
+        if (i > 0) jsonWriteLiteral(out, ",");
+        writeTransactionRecord(out, &txn, 0);
+        jsonWriterFlushIfFull(out);
+    }
+    jsonWriteLiteral(out, "]}");
+}
+
+// Fields only; callers add the braces so windows can append more
+static void writeTotalsFields(JsonWriter *out, const StatTotals *totals) {
+    jsonWriteLiteral(out, "\"transactions\": ");
+    jsonWriteInt(out, totals->count);
+    jsonWriteLiteral(out, ", \"suspicious\": ");
+    jsonWriteInt(out, totals->suspicious);
+    jsonWriteLiteral(out, ", \"amount\": ");
+    jsonWriteFixed2(out, totals->amount);
+    jsonWriteLiteral(out, ", \"suspiciousAmount\": ");
+    jsonWriteFixed2(out, totals->suspiciousAmount);
+    jsonWriteLiteral(out, ", \"fraudRate\": ");
+    jsonWriteFixed2(out, (totals->count > 0 ? totals->suspicious * 100.0 / totals->count : 0));
+    jsonWriteLiteral(out, ", \"averageRiskScore\": ");
+    jsonWriteFixed2(out, (totals->count > 0 ? (double)totals->riskScoreSum / totals->count : 0));
+}
+
+static void writeWindow(JsonWriter *out, const char *name, time_t now, int seconds) {
+    uint32_t histogram[RISK_HISTOGRAM_BINS];
+    StatTotals window = statsWindow(&txnStatistics, now, seconds, histogram);
+
+    jsonWriteString(out, name);
+    jsonWriteLiteral(out, ": {");
+    writeTotalsFields(out, &window);
+    jsonWriteLiteral(out, ", \"riskHistogram\": [");
+    for (int bin = 0; bin < RISK_HISTOGRAM_BINS; bin++) {
+        if (bin > 0) jsonWriteLiteral(out, ", ");
+        jsonWriteInt(out, histogram[bin]);
     }
-    printf("]}");
+    jsonWriteLiteral(out, "]}");
 }
 
 // Export statistics
-void exportStatistics() {
-    int suspiciousCount = 0;
-    double totalAmount = 0.0;
-    double suspiciousAmount = 0.0;
+void exportStatistics(JsonWriter *out) {
+    const StatTotals *overall = &txnStatistics.overall;
+    time_t now = time(NULL);
     
-    for (int i = 0; i < txnCount; i++) {
-        totalAmount += transactions[i].amount;
-        if (strcmp(transactions[i].status, "suspicious") == 0) {
-            suspiciousCount++;
-            suspiciousAmount += transactions[i].amount;
+    jsonWriteLiteral(out, "{\"statistics\": {\"totalTransactions\": ");
+    jsonWriteInt(out, overall->count);
+    jsonWriteLiteral(out, ", \"suspiciousTransactions\": ");
+    jsonWriteInt(out, overall->suspicious);
+    jsonWriteLiteral(out, ", \"totalAmount\": ");
+    jsonWriteFixed2(out, overall->amount);
+    jsonWriteLiteral(out, ", \"suspiciousAmount\": ");
+    jsonWriteFixed2(out, overall->suspiciousAmount);
+    jsonWriteLiteral(out, ", \"fraudRate\": ");
+    jsonWriteFixed2(out, (overall->count > 0 ? (overall->suspicious * 100.0 / overall->count) : 0));
+    jsonWriteLiteral(out, ", \"averageTransaction\": ");
+    jsonWriteFixed2(out, (overall->count > 0 ? overall->amount / overall->count : 0));
+    jsonWriteLiteral(out, "}, \"accounts\": {\"totalAccounts\": ");
+    jsonWriteInt(out, accountStore.count);
+    jsonWriteLiteral(out, ", \"activeAccounts\": ");
+    jsonWriteInt(out, accountStore.activeCount);
+
+    jsonWriteLiteral(out, "}, \"accountTypes\": {");
+    int written = 0;
+    for (int typeId = 0; typeId < accountTypeCount(); typeId++) {
+        if (txnStatistics.byAccountType[typeId].count == 0) continue;
+        if (written++) jsonWriteLiteral(out, ", ");
+        jsonWriteString(out, accountTypeName(typeId));
+        jsonWriteLiteral(out, ": {");
+        writeTotalsFields(out, &txnStatistics.byAccountType[typeId]);
+        jsonWriteLiteral(out, "}");
+    }
+
+    jsonWriteLiteral(out, "}, \"windows\": {");
+    writeWindow(out, "last15Minutes", now, 15 * 60);
+    jsonWriteLiteral(out, ", ");
+    writeWindow(out, "lastHour", now, 3600);
+    jsonWriteLiteral(out, ", ");
+    writeWindow(out, "last24Hours", now, 24 * 3600);
+    jsonWriteLiteral(out, "}}\n");
+}
+
+void exportLocationTotals(JsonWriter *out, const ScanFilter *filter) {
+    int locationCount = locationTable.count;
+    ScanTotals *perLocation = malloc((size_t)(locationCount > 0 ? locationCount : 1) * sizeof(ScanTotals));
+    if (!perLocation) {
+        jsonWriteLiteral(out, "{\"success\": false, \"error\": \"Out of memory\"}\n");
+        return;
+    }
+    long matched = scanTotalsByLocation(filter, perLocation, locationCount);
+
+    double amount = 0;
+    for (int id = 0; id < locationCount; id++) amount += perLocation[id].amount;
+
+    jsonWriteLiteral(out, "{\"locationTotals\": {\"kernel\": ");
+    jsonWriteString(out, scanKernelName());
+    jsonWriteLiteral(out, ", \"transactions\": ");
+    jsonWriteInt(out, matched);
+    jsonWriteLiteral(out, ", \"amount\": ");
+    jsonWriteFixed2(out, amount);
+    jsonWriteLiteral(out, ", \"locations\": [");
+    int written = 0;
+    for (int id = 0; id < locationCount; id++) {
+        if (perLocation[id].count == 0) continue;
+        if (written++) jsonWriteLiteral(out, ", ");
+        jsonWriteLiteral(out, "{\"location\": ");
+        jsonWriteString(out, locationName((LocationId)id));
+        jsonWriteLiteral(out, ", \"transactions\": ");
+        jsonWriteInt(out, perLocation[id].count);
+        jsonWriteLiteral(out, ", \"amount\": ");
+        jsonWriteFixed2(out, perLocation[id].amount);
+        jsonWriteLiteral(out, "}");
+    }
+    jsonWriteLiteral(out, "]}}\n");
+    free(perLocation);
+}
+
+void exportHistoryPage(JsonWriter *out, const HistoryQuery *query, long cursor, int pageSize) {
+    if (pageSize <= 0 || pageSize > HISTORY_MAX_PAGE) pageSize = HISTORY_MAX_PAGE;
+    int rows[HISTORY_MAX_PAGE];
+    long nextCursor;
+    int found = queryHistoryPage(query, cursor, pageSize, rows, &nextCursor);
+
+    jsonWriteLiteral(out, "{\"transactions\": [");
+    for (int i = 0; i < found; i++) {
+        Transaction txn;
+        readTransaction(rows[i], &txn);
+        if (i > 0) jsonWriteLiteral(out, ", ");
+        writeTransactionRecord(out, &txn, COMPACT_RECORD);
+    }
+    jsonWriteLiteral(out, "], \"nextCursor\": ");
+    if (nextCursor == HISTORY_NO_MORE) {
+        jsonWriteLiteral(out, "null");
+    } else {
+        jsonWriteInt(out, nextCursor);
+    }
+    jsonWriteLiteral(out, "}\n");
+}
+
+void exportBehaviorProfile(JsonWriter *out, const Account *account, time_t now) {
+    const BehaviorProfile *profile = &account->profile;
+
+    // Sketch entries by count, highest first
+    int order[PROFILE_TOP_LOCATIONS];
+    int tracked = 0;
+    for (int i = 0; i < PROFILE_TOP_LOCATIONS; i++) {
+        if (profile->locationCounts[i] == 0) continue;
+        int at = tracked++;
+        while (at > 0 && profile->locationCounts[order[at - 1]] < profile->locationCounts[i]) {
+            order[at] = order[at - 1];
+            at--;
         }
+        order[at] = i;
     }
-    
-    printf("{\n");
-    printf("  \"statistics\": {\n");
-    printf("    \"totalTransactions\": %d,\n", txnCount);
-    printf("    \"suspiciousTransactions\": %d,\n", suspiciousCount);
-    printf("    \"totalAmount\": %.2f,\n", totalAmount);
-    printf("    \"suspiciousAmount\": %.2f,\n", suspiciousAmount);
-    printf("    \"fraudRate\": %.2f,\n", (txnCount > 0 ? (suspiciousCount * 100.0 / txnCount) : 0));
-    printf("    \"averageTransaction\": %.2f\n", (txnCount > 0 ? totalAmount / txnCount : 0));
-    printf("  },\n");
-    printf("  \"accounts\": {\n");
-    printf("    \"totalAccounts\": %d,\n", accountCount);
-    printf("    \"activeAccounts\": %d\n", accountCount); // Simplified
-    printf("  }\n");
-    printf("}");
+
+    jsonWriteLiteral(out, "{\"success\": true, \"accNo\": ");
+    jsonWriteInt(out, account->accNo);
+    jsonWriteLiteral(out, ", \"transactions\": ");
+    jsonWriteInt(out, (long)profile->count);
+    jsonWriteLiteral(out, ", \"meanAmount\": ");
+    jsonWriteFixed2(out, profile->meanAmount);
+    jsonWriteLiteral(out, ", \"stdDevAmount\": ");
+    jsonWriteFixed2(out, profileStdDevAmount(profile));
+    jsonWriteLiteral(out, ", \"dailyRate\": ");
+    jsonWriteFixed2(out, profile->count ? profileDailyRate(profile, now) : 0);
+    jsonWriteLiteral(out, ", \"since\": ");
+    if (profile->count) {
+        jsonWriteTimestamp(out, profile->since);
+    } else {
+        jsonWriteLiteral(out, "null");
+    }
+    jsonWriteLiteral(out, ", \"hours\": [");
+    for (int hour = 0; hour < PROFILE_HOURS; hour++) {
+        if (hour > 0) jsonWriteLiteral(out, ", ");
+        jsonWriteInt(out, profile->hourCounts[hour]);
+    }
+    jsonWriteLiteral(out, "], \"topLocations\": [");
+    for (int i = 0; i < tracked; i++) {
+        if (i > 0) jsonWriteLiteral(out, ", ");
+        jsonWriteLiteral(out, "{\"location\": ");
+        jsonWriteString(out, locationName(profile->topLocations[order[i]]));
+        jsonWriteLiteral(out, ", \"count\": ");
+        jsonWriteInt(out, (long)profile->locationCounts[order[i]]);
+        jsonWriteLiteral(out, "}");
+    }
+    jsonWriteLiteral(out, "]}\n");
 }
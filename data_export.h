@@ -0,0 +1,52 @@
+/**
+ * Data Export Functions for Web Integration
+ */
+
+#ifndef DATA_EXPORT_H
+#define DATA_EXPORT_H
+
+#include "json_writer.h"
+#include "account_store.h"
+#include "transaction_log.h"
+#include "column_scan.h"
+#include "history_index.h"
+
+// Indent that writes a record on a single line
+#define COMPACT_RECORD -1
+
+/**
+ * One record as a JSON object whose closing brace sits `indent` spaces in
+ * and whose fields sit two deeper, or on one line with COMPACT_RECORD.
+ * Shared by the exports and the saves.
+ */
+void writeAccountRecord(JsonWriter *out, const Account *account, int indent);
+void writeTransactionRecord(JsonWriter *out, const Transaction *txn, int indent);
+
+void exportAccountsToJSON(JsonWriter *out);
+void exportTransactionsToJSON(JsonWriter *out, int limit);
+
+/**
+ * Single-line statistics JSON from the running aggregates; cost does not
+ * depend on how much history is stored
+ */
+void exportStatistics(JsonWriter *out);
+
+/**
+ * Single-line count and amount per location over the history rows that
+ * match filter, computed by one column scan
+ */
+void exportLocationTotals(JsonWriter *out, const ScanFilter *filter);
+
+/**
+ * Single-line page of history rows matching query, newest first, with the
+ * cursor for the next page or null once the query is exhausted
+ */
+void exportHistoryPage(JsonWriter *out, const HistoryQuery *query, long cursor, int pageSize);
+
+/**
+ * Single-line summary of the account's behavior profile: amount mean and
+ * spread, decayed daily rate as of now, hour histogram and top locations
+ */
+void exportBehaviorProfile(JsonWriter *out, const Account *account, time_t now);
+
+#endif
@@ -7,269 +7,508 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <json-c/json.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "data_manager.h"
+#include "data_export.h"
+#include "json_writer.h"
+#include "account_store.h"
+#include "transaction_log.h"
+#include "statistics.h"
+#include "alert_codes.h"
+#include "json_stream.h"
+#include "string_arena.h"
+#include "rule_engine.h"
+#include "location_table.h"
+#include "blacklist.h"
+#include "snapshot.h"
+#include "history_segments.h"
+#include "util.h"
 
-#define MAX_ACCOUNTS 100
-#define MAX_TRANSACTIONS 1000
 #define DATA_FILE_ACCOUNTS "data/accounts.json"
 #define DATA_FILE_TRANSACTIONS "data/transactions.json"
-#define DATA_FILE_FRAUD_RULES "data/fraud_patterns.json"
-
-typedef struct {
-    int accNo;
-    char name[50];
-    double balance;
-    char lastLocation[30];
-    time_t lastTxnTime;
-    int isActive;
-    char accountType[20];
-    double dailyLimit;
-    double monthlyLimit;
-    double dailySpent;
-    double monthlySpent;
-} Account;
-
-typedef struct {
-    int txnId;
-    int accNo;
-    double amount;
-    char location[30];
-    time_t timestamp;
-    char status[20];
-    char alerts[256];
-    char type[20];
-} Transaction;
-
-// Global data
-Account accounts[MAX_ACCOUNTS];
-Transaction transactions[MAX_TRANSACTIONS];
-int accountCount = 0;
-int txnCount = 0;
-
-// Fraud detection rules
-double highValueThreshold = 50000.0;
-int rapidTransactionCount = 3;
-int rapidTransactionWindow = 60;
-int impossibleTravelTime = 600;
+#define DATA_FILE_LOCATIONS "data/locations.json"
+#define DATA_FILE_HISTORY_STATE DATA_DIR_SEGMENTS "/state.snapshot"
+
+#define DEFAULT_HOT_ROWS (1 << 20)
+#define DEFAULT_HOT_SECONDS (30L * 86400)
+
+static void reportLoad(const char *what, int count, size_t bytes, double started) {
+    double seconds = monotonicSeconds() - started;
+    double megabytes = bytes / (1024.0 * 1024.0);
+    fprintf(stderr, "Loaded %d %s from file (%.2f MB in %.3f s, %.1f MB/s)\n",
+            count, what, megabytes, seconds, (seconds > 0 ? megabytes / seconds : 0.0));
+}
+
+/**
+ * Open a data file and position the stream inside its top-level array
+ * member `key`
+ */
+static int openRecordArray(JsonStream *stream, const char *path, const char *key) {
+    if (!jsonOpenFile(stream, path)) return 0;
+
+    JsonToken token;
+    if (!jsonNext(stream, &token) || token.type != JSON_TOKEN_OBJECT_BEGIN ||
+        !jsonFindMember(stream, key, &token) || token.type != JSON_TOKEN_ARRAY_BEGIN) {
+        fprintf(stderr, "Warning: %s has no \"%s\" array\n", path, key);
+        jsonClose(stream);
+        return 0;
+    }
+    return 1;
+}
 
 /**
  * Load accounts from JSON file
  */
 int loadAccountsFromFile() {
-    FILE *file = fopen(DATA_FILE_ACCOUNTS, "r");
-    if (!file) {
-        printf("Warning: Could not open accounts file. Using default accounts.\n");
+    double started = monotonicSeconds();
+    JsonStream stream;
+    
+    if (!openRecordArray(&stream, DATA_FILE_ACCOUNTS, "accounts")) {
+        fprintf(stderr, "Warning: Could not open accounts file. Using default accounts.\n");
         return 0;
     }
 
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    // Roughly 250 bytes of JSON per account
+    initAccountStore(&accountStore, (int)(stream.size / 250));
 
-    char *jsonData = malloc(fileSize + 1);
-    fread(jsonData, 1, fileSize, file);
-    jsonData[fileSize] = '\0';
-    fclose(file);
-
-    struct json_object *parsedJson;
-    struct json_object *accountsArray;
-    
-    parsedJson = json_tokener_parse(jsonData);
-    if (json_object_object_get_ex(parsedJson, "accounts", &accountsArray)) {
-        int arrayLen = json_object_array_length(accountsArray);
+    JsonToken token;
+    while (jsonNext(&stream, &token) && token.type == JSON_TOKEN_OBJECT_BEGIN) {
+        Account account = {0};
+        account.name = "";
+        account.accountType = "";
         
-        for (int i = 0; i < arrayLen && i < MAX_ACCOUNTS; i++) {
-            struct json_object *accountObj = json_object_array_get_idx(accountsArray, i);
+        JsonToken key, value;
+        while (jsonNext(&stream, &key) && key.type == JSON_TOKEN_KEY) {
+            if (!jsonNext(&stream, &value)) break;
             
-            accounts[accountCount].accNo = json_object_get_int(json_object_object_get(accountObj, "accNo"));
-            strcpy(accounts[accountCount].name, json_object_get_string(json_object_object_get(accountObj, "name")));
-            accounts[accountCount].balance = json_object_get_double(json_object_object_get(accountObj, "balance"));
-            strcpy(accounts[accountCount].lastLocation, json_object_get_string(json_object_object_get(accountObj, "lastLocation")));
-            
-            // Parse timestamp
-            const char *timeStr = json_object_get_string(json_object_object_get(accountObj, "lastTxnTime"));
-            struct tm tm;
-            strptime(timeStr, "%Y-%m-%dT%H:%M:%SZ", &tm);
-            accounts[accountCount].lastTxnTime = mktime(&tm);
-            
-            accounts[accountCount].isActive = json_object_get_boolean(json_object_object_get(accountObj, "isActive"));
-            strcpy(accounts[accountCount].accountType, json_object_get_string(json_object_object_get(accountObj, "accountType")));
-            accounts[accountCount].dailyLimit = json_object_get_double(json_object_object_get(accountObj, "dailyLimit"));
-            accounts[accountCount].monthlyLimit = json_object_get_double(json_object_object_get(accountObj, "monthlyLimit"));
-            accounts[accountCount].dailySpent = 0.0;
-            accounts[accountCount].monthlySpent = 0.0;
-            
-            accountCount++;
+            if (jsonTokenIs(&key, "accNo")) {
+                account.accNo = (int)value.number;
+            } else if (jsonTokenIs(&key, "name") && value.type == JSON_TOKEN_STRING) {
+                account.name = arenaStrndup(&stringArena, value.text, value.length);
+            } else if (jsonTokenIs(&key, "balance")) {
+                account.balance = value.number;
+            } else if (jsonTokenIs(&key, "lastLocation") && value.type == JSON_TOKEN_STRING) {
+                account.lastLocation = internLocationN(value.text, value.length);
+            } else if (jsonTokenIs(&key, "lastTxnTime")) {
+                jsonParseTimestamp(&value, &account.lastTxnTime);
+            } else if (jsonTokenIs(&key, "isActive")) {
+                account.isActive = (value.type == JSON_TOKEN_TRUE);
+            } else if (jsonTokenIs(&key, "accountType") && value.type == JSON_TOKEN_STRING) {
+                account.accountType = arenaStrndup(&stringArena, value.text, value.length);
+            } else if (jsonTokenIs(&key, "dailyLimit")) {
+                account.dailyLimit = value.number;
+            } else if (jsonTokenIs(&key, "monthlyLimit")) {
+                account.monthlyLimit = value.number;
+            } else {
+                jsonSkipValue(&stream, &value);
+            }
         }
+        
+        addAccount(&accountStore, &account);
     }
 
-    free(jsonData);
-    json_object_put(parsedJson);
-    
-    printf("Loaded %d accounts from file\n", accountCount);
+    if (token.type == JSON_TOKEN_ERROR) {
+        fprintf(stderr, "Warning: Malformed JSON in %s\n", DATA_FILE_ACCOUNTS);
+    }
+    reportLoad("accounts", accountStore.count, stream.size, started);
+    jsonClose(&stream);
     return 1;
 }
 
 /**
- * Load transactions from JSON file
+ * Decode the members of one transaction object (the opening brace has
+ * already been read) into txn. Unknown members are skipped.
  */
-int loadTransactionsFromFile() {
-    FILE *file = fopen(DATA_FILE_TRANSACTIONS, "r");
-    if (!file) {
-        printf("Warning: Could not open transactions file.\n");
-        return 0;
+void decodeTransaction(JsonStream *stream, Transaction *txn) {
+    JsonToken key, value;
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+        
+        if (jsonTokenIs(&key, "txnId")) {
+            txn->txnId = (int)value.number;
+        } else if (jsonTokenIs(&key, "accNo")) {
+            txn->accNo = (int)value.number;
+        } else if (jsonTokenIs(&key, "amount")) {
+            txn->amount = value.number;
+        } else if (jsonTokenIs(&key, "location") && value.type == JSON_TOKEN_STRING) {
+            txn->location = internLocationN(value.text, value.length);
+        } else if (jsonTokenIs(&key, "timestamp")) {
+            if (value.type == JSON_TOKEN_NUMBER) {
+                txn->timestamp = (time_t)value.number;
+            } else {
+                jsonParseTimestamp(&value, &txn->timestamp);
+            }
+        } else if (jsonTokenIs(&key, "status")) {
+            char statusName[20];
+            jsonCopyString(&value, statusName, sizeof(statusName));
+            txn->status = parseTxnStatus(statusName);
+        } else if (jsonTokenIs(&key, "type")) {
+            char typeName[20];
+            jsonCopyString(&value, typeName, sizeof(typeName));
+            txn->type = parseTxnType(typeName);
+        } else if (jsonTokenIs(&key, "riskScore")) {
+            txn->riskScore = (int)value.number;
+        } else if (jsonTokenIs(&key, "ruleVersion")) {
+            txn->ruleVersion = (uint32_t)value.number;
+        } else if (jsonTokenIs(&key, "alerts") && value.type == JSON_TOKEN_ARRAY_BEGIN) {
+            // Parse alerts array into the alert mask
+            JsonToken alert;
+            while (jsonNext(stream, &alert) && alert.type == JSON_TOKEN_STRING) {
+                char message[100];
+                jsonCopyString(&alert, message, sizeof(message));
+                int code = alertCodeFromMessage(message);
+                if (code >= 0) txn->alertMask |= ALERT_BIT(code);
+            }
+        } else {
+            jsonSkipValue(stream, &value);
+        }
+    }
+}
+
+/**
+ * Like openRecordArray() for the transactions file, also reading the
+ * "firstRow" member that precedes the array
+ */
+static int openTransactionArray(JsonStream *stream, int *firstRow) {
+    *firstRow = 0;
+    if (!jsonOpenFile(stream, DATA_FILE_TRANSACTIONS)) return 0;
+
+    JsonToken token, key;
+    if (jsonNext(stream, &token) && token.type == JSON_TOKEN_OBJECT_BEGIN) {
+        while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY && jsonNext(stream, &token)) {
+            if (jsonTokenIs(&key, "transactions") && token.type == JSON_TOKEN_ARRAY_BEGIN) return 1;
+            if (jsonTokenIs(&key, "firstRow") && token.type == JSON_TOKEN_NUMBER && token.number > 0) {
+                *firstRow = (int)token.number;
+            } else {
+                jsonSkipValue(stream, &token);
+            }
+        }
     }
+    fprintf(stderr, "Warning: %s has no \"transactions\" array\n", DATA_FILE_TRANSACTIONS);
+    jsonClose(stream);
+    return 0;
+}
+
+/**
+ * Seed the account's velocity ring, spend counters and behavior profile
+ * from its history
+ */
+static void seedAccountHistory(const Transaction *txn) {
+    Account *account = findAccount(&accountStore, txn->accNo);
+    if (account) {
+        recordRecentActivity(account, txn->timestamp, txn->amount);
+        recordSpending(account, txn->timestamp, txn->amount);
+        updateBehaviorProfile(&account->profile, txn->timestamp, txn->amount, txn->location);
+    }
+}
+
+/**
+ * Recompute everything history folds into the statistics and accounts by
+ * replaying every row, sealed ones included. Only for when no saved
+ * history state matches the JSON file, as it costs a pass over the whole
+ * sealed history.
+ */
+static void replayHistory(int firstRow) {
+    fprintf(stderr, "Warning: No history state saved with %s, replaying %d sealed transactions\n",
+            DATA_FILE_TRANSACTIONS, firstRow);
 
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    memset(&txnStatistics, 0, sizeof(txnStatistics));
+    restoreHistoryOrder(0, 1, INT64_MIN);
+    for (int i = 0; i < accountStore.count; i++) {
+        Account *account = &accountStore.accounts[i];
+        memset(&account->recent, 0, sizeof(account->recent));
+        memset(&account->profile, 0, sizeof(account->profile));
+        account->dailySpent = account->monthlySpent = 0;
+        account->spendDay = account->spendMonth = 0;
+    }
 
-    char *jsonData = malloc(fileSize + 1);
-    fread(jsonData, 1, fileSize, file);
-    jsonData[fileSize] = '\0';
-    fclose(file);
+    for (int row = 0; row < txnCount; row++) {
+        Transaction txn;
+        if (row < txnColumns.firstRow) {
+            if (!readSealedTransaction(NULL, row, &txn)) continue;
+        } else {
+            readTransaction(row, &txn);
+        }
+        recordSealedTransaction(&txn);
+        seedAccountHistory(&txn);
+    }
+}
 
-    struct json_object *parsedJson;
-    struct json_object *txnsArray;
+/**
+ * Load transactions from JSON file. The file holds the rows from firstRow
+ * on; what the older, sealed ones add to the statistics and accounts
+ * comes from the history state saved with it.
+ */
+int loadTransactionsFromFile() {
+    double started = monotonicSeconds();
+    JsonStream stream;
+    int firstRow;
     
-    parsedJson = json_tokener_parse(jsonData);
-    if (json_object_object_get_ex(parsedJson, "transactions", &txnsArray)) {
-        int arrayLen = json_object_array_length(txnsArray);
+    if (!openTransactionArray(&stream, &firstRow)) {
+        fprintf(stderr, "Warning: Could not open transactions file.\n");
+        return 0;
+    }
+
+    startTransactionsAt(firstRow);
+
+    // Records saved before rule versioning are rescored under the current rules
+    const CompiledRules *rules = acquireRules();
+    JsonToken token;
+    while (jsonNext(&stream, &token) && token.type == JSON_TOKEN_OBJECT_BEGIN) {
+        Transaction txn = {0};
+        decodeTransaction(&stream, &txn);
+        if (txn.ruleVersion == RULES_VERSION_UNKNOWN) {
+            txn.riskScore = scoreAlertMask(rules, txn.alertMask);
+            txn.ruleVersion = rules->version;
+        }
         
-        for (int i = 0; i < arrayLen && i < MAX_TRANSACTIONS; i++) {
-            struct json_object *txnObj = json_object_array_get_idx(txnsArray, i);
-            
-            transactions[txnCount].txnId = json_object_get_int(json_object_object_get(txnObj, "txnId"));
-            transactions[txnCount].accNo = json_object_get_int(json_object_object_get(txnObj, "accNo"));
-            transactions[txnCount].amount = json_object_get_double(json_object_object_get(txnObj, "amount"));
-            strcpy(transactions[txnCount].location, json_object_get_string(json_object_object_get(txnObj, "location")));
-            strcpy(transactions[txnCount].status, json_object_get_string(json_object_object_get(txnObj, "status")));
-            strcpy(transactions[txnCount].type, json_object_get_string(json_object_object_get(txnObj, "type")));
-            
-            // Parse alerts array
-            struct json_object *alertsArray;
-            if (json_object_object_get_ex(txnObj, "alerts", &alertsArray)) {
-                strcpy(transactions[txnCount].alerts, "");
-                int alertCount = json_object_array_length(alertsArray);
-                for (int j = 0; j < alertCount; j++) {
-                    if (j > 0) strcat(transactions[txnCount].alerts, ",");
-                    strcat(transactions[txnCount].alerts, 
-                          json_object_get_string(json_object_array_get_idx(alertsArray, j)));
-                }
-            }
-            
-            // Parse timestamp
-            const char *timeStr = json_object_get_string(json_object_object_get(txnObj, "timestamp"));
-            struct tm tm;
-            strptime(timeStr, "%Y-%m-%dT%H:%M:%SZ", &tm);
-            transactions[txnCount].timestamp = mktime(&tm);
-            
-            txnCount++;
+        if (!storeTransaction(&txn)) {
+            fprintf(stderr, "Warning: Out of memory after %d transactions\n", txnCount);
+            break;
         }
+        seedAccountHistory(&txn);
+    }
+
+    releaseRules();
+
+    if (token.type == JSON_TOKEN_ERROR) {
+        fprintf(stderr, "Warning: Malformed JSON in %s\n", DATA_FILE_TRANSACTIONS);
+    }
+
+    // The saved state covers every row, so it replaces what the rows just
+    // loaded folded in
+    if (firstRow > 0 && !loadHistoryState(DATA_FILE_HISTORY_STATE, firstRow)) {
+        replayHistory(firstRow);
+    }
+    reportLoad("transactions", txnCount, stream.size, started);
+    jsonClose(&stream);
+    return 1;
+}
+
+/**
+ * Finish a file written to path.tmp and atomically move it over path,
+ * so a crash mid-save never leaves a truncated data file behind
+ */
+static int commitDataFile(JsonWriter *out, const char *tmpPath, const char *path) {
+    int ok = jsonWriterFlush(out) && fsync(out->fd) == 0;
+    ok = (close(out->fd) == 0) && ok;
+    jsonWriterFree(out);
+    
+    if (!ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Save the in-memory transactions to JSON file, after making sure the
+ * sealed ones are on disk
+ */
+int saveTransactionsToFile() {
+    if (!flushHistorySegments()) {
+        fprintf(stderr, "Error: Could not flush history segments, transactions not saved\n");
+        return 0;
+    }
+
+    // Loading leaves the sealed rows out of the file and takes their part
+    // in the statistics and accounts from this
+    if (txnColumns.firstRow > 0 && !saveHistoryState(DATA_FILE_HISTORY_STATE)) {
+        fprintf(stderr, "Warning: Could not save history state, loading %s will replay sealed history\n",
+                DATA_FILE_TRANSACTIONS);
     }
 
-    free(jsonData);
-    json_object_put(parsedJson);
+    const char *tmpPath = DATA_FILE_TRANSACTIONS ".tmp";
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not save transactions to file\n");
+        return 0;
+    }
+
+    JsonWriter out;
+    jsonWriterInit(&out, fd);
+    jsonWriteLiteral(&out, "{\n  \"firstRow\": ");
+    jsonWriteInt(&out, txnColumns.firstRow);
+    jsonWriteLiteral(&out, ",\n  \"transactions\": [\n");
     
-    printf("Loaded %d transactions from file\n", txnCount);
+    for (int row = txnColumns.firstRow; row < txnCount; row++) {
+        Transaction txn;
+        readTransaction(row, &txn);
+        jsonWriteLiteral(&out, "    ");
+        writeTransactionRecord(&out, &txn, 4);
+        if (row < txnCount - 1) jsonWriteLiteral(&out, ",");
+        jsonWriteLiteral(&out, "\n");
+        jsonWriterFlushIfFull(&out);
+    }
+    
+    jsonWriteLiteral(&out, "  ]\n}");
+    if (!commitDataFile(&out, tmpPath, DATA_FILE_TRANSACTIONS)) {
+        fprintf(stderr, "Error: Could not save transactions to file\n");
+        return 0;
+    }
+    
+    fprintf(stderr, "Saved %d transactions to file\n", txnCount - txnColumns.firstRow);
     return 1;
 }
 
 /**
- * Save transactions to JSON file
+ * Save accounts (with current balances) to JSON file
  */
-void saveTransactionsToFile() {
-    FILE *file = fopen(DATA_FILE_TRANSACTIONS, "w");
-    if (!file) {
-        printf("Error: Could not save transactions to file\n");
-        return;
+int saveAccountsToFile() {
+    const char *tmpPath = DATA_FILE_ACCOUNTS ".tmp";
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not save accounts to file\n");
+        return 0;
     }
 
-    fprintf(file, "{\n  \"transactions\": [\n");
+    JsonWriter out;
+    jsonWriterInit(&out, fd);
+    jsonWriteLiteral(&out, "{\n  \"accounts\": [\n");
     
-    for (int i = 0; i < txnCount; i++) {
-        char timeStr[30];
-        strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", 
-                gmtime(&transactions[i].timestamp));
-        
-        fprintf(file, "    {\n");
-        fprintf(file, "      \"txnId\": %d,\n", transactions[i].txnId);
-        fprintf(file, "      \"accNo\": %d,\n", transactions[i].accNo);
-        fprintf(file, "      \"amount\": %.2f,\n", transactions[i].amount);
-        fprintf(file, "      \"location\": \"%s\",\n", transactions[i].location);
-        fprintf(file, "      \"timestamp\": \"%s\",\n", timeStr);
-        fprintf(file, "      \"status\": \"%s\",\n", transactions[i].status);
-        fprintf(file, "      \"type\": \"%s\",\n", transactions[i].type);
-        
-        // Format alerts as array
-        fprintf(file, "      \"alerts\": [");
-        if (strlen(transactions[i].alerts) > 0) {
-            char *alertCopy = strdup(transactions[i].alerts);
-            char *token = strtok(alertCopy, ",");
-            int first = 1;
-            
-            while (token != NULL) {
-                fprintf(file, "%s\"%s\"", (first ? "" : ","), token);
-                first = 0;
-                token = strtok(NULL, ",");
-            }
-            free(alertCopy);
-        }
-        fprintf(file, "]\n");
-        
-        fprintf(file, "    }%s\n", (i < txnCount - 1 ? "," : ""));
+    for (int i = 0; i < accountStore.count; i++) {
+        jsonWriteLiteral(&out, "    ");
+        writeAccountRecord(&out, &accountStore.accounts[i], 4);
+        if (i < accountStore.count - 1) jsonWriteLiteral(&out, ",");
+        jsonWriteLiteral(&out, "\n");
+        jsonWriterFlushIfFull(&out);
     }
     
-    fprintf(file, "  ]\n}");
-    fclose(file);
+    jsonWriteLiteral(&out, "  ]\n}\n");
+    if (!commitDataFile(&out, tmpPath, DATA_FILE_ACCOUNTS)) {
+        fprintf(stderr, "Error: Could not save accounts to file\n");
+        return 0;
+    }
     
-    printf("Saved %d transactions to file\n", txnCount);
+    fprintf(stderr, "Saved %d accounts to file\n", accountStore.count);
+    return 1;
+}
+
+/**
+ * Load city coordinates. Runs first so known cities get the low IDs
+ * covered by the travel-time matrix.
+ */
+void loadLocations() {
+    int cities = loadLocationTable(DATA_FILE_LOCATIONS);
+    if (cities == 0) {
+        fprintf(stderr, "Warning: No location coordinates, impossible travel uses impossibleTravelTime only\n");
+        return;
+    }
+
+    fprintf(stderr, "Locations loaded: %d cities, max travel speed %.0f km/h\n",
+            cities, locationTable.maxTravelSpeedKmh);
 }
 
 /**
  * Load fraud detection rules
  */
 void loadFraudRules() {
-    FILE *file = fopen(DATA_FILE_FRAUD_RULES, "r");
-    if (!file) {
-        printf("Warning: Using default fraud rules\n");
-        return;
+    if (!reloadFraudRules(DATA_FILE_FRAUD_RULES)) {
+        CompiledRules defaults;
+        initDefaultRules(&defaults);
+        publishRules(&defaults);
+        fprintf(stderr, "Warning: Using default fraud rules\n");
+    }
+}
+
+/**
+ * Load the blacklist snapshot; scoring runs without one if it is missing
+ */
+void loadBlacklist() {
+    if (!reloadBlacklist(DATA_FILE_BLACKLIST)) {
+        fprintf(stderr, "Warning: Could not load blacklist, blacklist checks disabled\n");
     }
+}
 
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
+/**
+ * Open the history segments and apply the "retention" section of the
+ * rules file (read at startup only). The age limit never drops below the
+ * rule windows, so queries over a window stay in memory.
+ */
+void loadHistoryRetention() {
+    if (!openHistorySegments(DATA_DIR_SEGMENTS)) {
+        fprintf(stderr, "Warning: Could not open %s, keeping the whole history in memory\n", DATA_DIR_SEGMENTS);
+        return;
+    }
 
-    char *jsonData = malloc(fileSize + 1);
-    fread(jsonData, 1, fileSize, file);
-    jsonData[fileSize] = '\0';
-    fclose(file);
+    long hotRows = DEFAULT_HOT_ROWS;
+    long hotSeconds = DEFAULT_HOT_SECONDS;
+    JsonStream stream;
+    JsonToken token;
+    if (jsonOpenFile(&stream, DATA_FILE_FRAUD_RULES)) {
+        if (jsonNext(&stream, &token) && token.type == JSON_TOKEN_OBJECT_BEGIN &&
+            jsonFindMember(&stream, "retention", &token) && token.type == JSON_TOKEN_OBJECT_BEGIN) {
+            JsonToken key, value;
+            while (jsonNext(&stream, &key) && key.type == JSON_TOKEN_KEY) {
+                if (!jsonNext(&stream, &value)) break;
 
-    struct json_object *parsedJson;
-    struct json_object *fraudRules;
-    
-    parsedJson = json_tokener_parse(jsonData);
-    if (json_object_object_get_ex(parsedJson, "fraudRules", &fraudRules)) {
-        highValueThreshold = json_object_get_double(json_object_object_get(fraudRules, "highValueThreshold"));
-        rapidTransactionCount = json_object_get_int(json_object_object_get(fraudRules, "rapidTransactionCount"));
-        rapidTransactionWindow = json_object_get_int(json_object_object_get(fraudRules, "rapidTransactionWindow"));
-        impossibleTravelTime = json_object_get_int(json_object_object_get(fraudRules, "impossibleTravelTime"));
+                if (jsonTokenIs(&key, "hotRows")) {
+                    hotRows = (long)value.number;
+                } else if (jsonTokenIs(&key, "hotSeconds")) {
+                    hotSeconds = (long)value.number;
+                } else {
+                    jsonSkipValue(&stream, &value);
+                }
+            }
+        }
+        jsonClose(&stream);
     }
+    if (hotRows > INT32_MAX) hotRows = 0;
 
-    free(jsonData);
-    json_object_put(parsedJson);
-    
-    printf("Fraud rules loaded: HighValue=%.2f, RapidCount=%d\n", 
-           highValueThreshold, rapidTransactionCount);
+    const CompiledRules *rules = acquireRules();
+    long window = rules->rapidTransactionWindow;
+    if (rules->locationChangeWindow > window) window = rules->locationChangeWindow;
+    if (rules->impossibleTravelTime > window) window = rules->impossibleTravelTime;
+    releaseRules();
+    if (hotSeconds > 0 && hotSeconds < window) hotSeconds = window;
+
+    setHistoryRetention((int)hotRows, hotSeconds);
+    fprintf(stderr, "History retention: %ld rows, %ld seconds in memory\n", hotRows, hotSeconds);
+}
+
+static int modifiedAfter(const struct stat *a, const struct stat *b) {
+    return a->st_mtim.tv_sec > b->st_mtim.tv_sec ||
+           (a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec > b->st_mtim.tv_nsec);
 }
 
 /**
- * Initialize data system
+ * The snapshot is only trusted while neither JSON file was written after
+ * it, e.g. by a compaction whose follow-up snapshot never landed
+ */
+static int snapshotIsCurrent() {
+    struct stat snapshot, accounts, transactions;
+    if (stat(DATA_FILE_SNAPSHOT, &snapshot) != 0) return 0;
+
+    if ((stat(DATA_FILE_ACCOUNTS, &accounts) == 0 && modifiedAfter(&accounts, &snapshot)) ||
+        (stat(DATA_FILE_TRANSACTIONS, &transactions) == 0 && modifiedAfter(&transactions, &snapshot))) {
+        fprintf(stderr, "Warning: Snapshot is older than the JSON data files, ignoring it\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Initialize data system. A current snapshot replaces parsing the
+ * accounts and transactions files.
  */
 void initializeDataSystem() {
-    printf("Initializing Data System...\n");
+    fprintf(stderr, "Initializing Data System...\n");
+    loadLocations();
     loadFraudRules();
-    loadAccountsFromFile();
-    loadTransactionsFromFile();
-    printf("Data system ready. Accounts: %d, Transactions: %d\n", accountCount, txnCount);
+    loadBlacklist();
+    loadHistoryRetention();
+    if (!snapshotIsCurrent() || !loadSnapshot(DATA_FILE_SNAPSHOT)) {
+        loadAccountsFromFile();
+        loadTransactionsFromFile();
+    }
+
+    // Rows sealed after the files were written leave memory again
+    applyHistoryRetention();
+    if (sealedRowCount() < txnColumns.firstRow) {
+        fprintf(stderr, "Warning: History segments end at row %d, rows %d to %d are missing\n",
+                sealedRowCount(), sealedRowCount(), txnColumns.firstRow - 1);
+    }
+    fprintf(stderr, "Data system ready. Accounts: %d, Transactions: %d\n", accountStore.count, txnCount);
 }
@@ -0,0 +1,23 @@
+/**
+ * Data Manager for Fraud Detection System
+ * Handles JSON file operations and data persistence
+ */
+
+#ifndef DATA_MANAGER_H
+#define DATA_MANAGER_H
+
+#include "json_stream.h"
+#include "transaction_log.h"
+
+int loadAccountsFromFile();
+int loadTransactionsFromFile();
+void decodeTransaction(JsonStream *stream, Transaction *txn);
+int saveTransactionsToFile();
+int saveAccountsToFile();
+void loadLocations();
+void loadFraudRules();
+void loadBlacklist();
+void loadHistoryRetention();
+void initializeDataSystem();
+
+#endif
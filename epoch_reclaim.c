@@ -0,0 +1,53 @@
+/**
+ * Epoch Reclamation for Fraud Detection System
+ * Reader registry and grace-period wait shared by the rule engine and the
+ * blacklist
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "epoch_reclaim.h"
+
+static EpochReader *registerReader(EpochDomain *domain) {
+    EpochReader *reader = calloc(1, sizeof(EpochReader));
+    if (!reader) {
+        fprintf(stderr, "Fatal: cannot allocate epoch reader\n");
+        abort();
+    }
+
+    reader->next = __atomic_load_n(&domain->readers, __ATOMIC_ACQUIRE);
+    while (!__atomic_compare_exchange_n(&domain->readers, &reader->next, reader, 1,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)) {
+    }
+    return reader;
+}
+
+void enterEpoch(EpochDomain *domain, EpochReader **reader) {
+    if (!*reader) *reader = registerReader(domain);
+
+    // The epoch must be visible before the caller loads the pointer
+    __atomic_store_n(&(*reader)->epoch, __atomic_load_n(&domain->epoch, __ATOMIC_ACQUIRE), __ATOMIC_SEQ_CST);
+}
+
+void leaveEpoch(EpochReader *reader) {
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Advance the epoch, then wait until every reader is idle or started at or
+ * after it. The publisher stores the pointer and then loads reader epochs
+ * while readers store their epoch and then load the pointer, so both sides
+ * must be sequentially consistent or each could miss the other's store.
+ */
+void synchronizeEpoch(EpochDomain *domain) {
+    uint64_t epoch = __atomic_add_fetch(&domain->epoch, 1, __ATOMIC_SEQ_CST);
+
+    for (EpochReader *reader = __atomic_load_n(&domain->readers, __ATOMIC_SEQ_CST); reader; reader = reader->next) {
+        for (;;) {
+            uint64_t seen = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+            if (seen == 0 || seen >= epoch) break;
+            sched_yield();
+        }
+    }
+}
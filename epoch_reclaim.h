@@ -0,0 +1,46 @@
+/**
+ * Epoch Reclamation for Fraud Detection System
+ * Lets lock-free readers use an immutable snapshot while a publisher swaps
+ * in a new one, and tells the publisher when the old one can be freed
+ */
+
+#ifndef EPOCH_RECLAIM_H
+#define EPOCH_RECLAIM_H
+
+#include <stdint.h>
+
+/**
+ * One per reading thread and domain. A reader publishes the epoch it
+ * started in and clears it when done. Readers are never unlinked, so a
+ * publisher can walk the list freely.
+ */
+typedef struct EpochReader {
+    uint64_t epoch;             // 0 while outside a read section
+    struct EpochReader *next;
+} EpochReader;
+
+typedef struct {
+    uint64_t epoch;
+    EpochReader *readers;
+} EpochDomain;
+
+#define EPOCH_DOMAIN_INITIALIZER {1, NULL}
+
+/**
+ * Start a read section. *reader is the calling thread's slot for this
+ * domain (a __thread variable), registered on first use. Load the shared
+ * pointer with __ATOMIC_SEQ_CST afterwards: a publisher that swapped first
+ * either sees this epoch or the reader sees its new snapshot.
+ */
+void enterEpoch(EpochDomain *domain, EpochReader **reader);
+void leaveEpoch(EpochReader *reader);
+
+/**
+ * Call after swapping the shared pointer with __ATOMIC_SEQ_CST. Returns
+ * once every read section that could have loaded the old pointer has
+ * ended, so it can be freed. Must not be called inside a read section of
+ * the same domain.
+ */
+void synchronizeEpoch(EpochDomain *domain);
+
+#endif
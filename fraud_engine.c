@@ -0,0 +1,166 @@
+/**
+ * Fraud Engine for Fraud Detection System
+ * Rule evaluation and risk scoring for a single transaction
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "fraud_engine.h"
+#include "alert_codes.h"
+#include "location_table.h"
+#include "blacklist.h"
+#include "metrics.h"
+
+#define SECONDS_PER_DAY 86400
+
+int calculateRiskScore(const CompiledRules *rules, Transaction *txn) {
+    return scoreAlertMask(rules, txn->alertMask);
+}
+
+void gatherFraudContext(Account *acc, const Transaction *txn, int profileMinHistory, FraudContext *context) {
+    // Daily and monthly spend against the account's own limits
+    context->spendingExceeded = recordSpending(acc, txn->timestamp, txn->amount);
+
+    long secondOfDay = (long)(txn->timestamp % SECONDS_PER_DAY);
+    if (secondOfDay < 0) secondOfDay += SECONDS_PER_DAY;
+    context->minuteOfDay = (int)(secondOfDay / 60);
+
+    // Blacklist snapshot (Bloom filter rejects almost every clean key)
+    const Blacklist *blacklist = acquireBlacklist();
+    context->blacklistedAccount = blacklist && blacklistHasAccount(blacklist, txn->accNo);
+    context->blacklistedLocation = blacklist && blacklistHasLocation(blacklist, txn->location);
+    releaseBlacklist();
+
+    // Faster than the great-circle flight time is impossible; 0 means the
+    // rules' impossibleTravelTime applies
+    context->locationChanged = acc->lastLocation != LOCATION_NONE && txn->location != acc->lastLocation;
+    context->sinceLastTxn = 0;
+    context->minTravelSeconds = 0;
+    if (context->locationChanged) {
+        context->sinceLastTxn = difftime(txn->timestamp, acc->lastTxnTime);
+        context->minTravelSeconds = minTravelSeconds(acc->lastLocation, txn->location);
+    }
+
+    // Features no rule set will look at are not worth computing
+    context->profileCount = acc->profile.count;
+    if (profileMinHistory > 0 && context->profileCount >= (uint32_t)profileMinHistory) {
+        computeBehaviorFeatures(&acc->profile, txn->timestamp, txn->amount, txn->location, &context->behavior);
+    }
+}
+
+// Amount tiers, round and micro amount patterns
+static inline uint32_t amountAlerts(const CompiledRules *rules, double amount) {
+    uint32_t alerts = 0;
+
+    // Highest tier first: at most one high-value alert fires
+    for (int i = 0; i < AMOUNT_TIER_COUNT; i++) {
+        if (amount > rules->amountTierThresholds[i]) {
+            alerts |= ALERT_BIT(rules->amountTierAlerts[i]);
+            break;
+        }
+    }
+
+    int isRound = rules->roundAmountUnit > 0 && amount > rules->roundAmountUnit &&
+                  fmod(amount, rules->roundAmountUnit) == 0;
+    for (int i = 0; i < rules->roundAmountCount; i++) {
+        isRound |= (amount == rules->roundAmounts[i]);
+    }
+    alerts |= (uint32_t)isRound << ALERT_ROUND_AMOUNT;
+    alerts |= (uint32_t)(amount < rules->microAmountThreshold) << ALERT_MICRO_AMOUNT;
+    return alerts;
+}
+
+// Rapid transactions (per-account ring) and spending limits
+static inline uint32_t velocityAlerts(const CompiledRules *rules, const Account *acc, const Transaction *txn,
+                                      const FraudContext *context) {
+    int recentCount = countRecentActivity(acc, txn->timestamp - rules->rapidTransactionWindow);
+    return (uint32_t)(recentCount >= rules->rapidTransactionCount) << ALERT_RAPID_TRANSACTIONS |
+           (uint32_t)context->spendingExceeded << ALERT_SPENDING_LIMIT;
+}
+
+// Unusual hours, suspicious locations and the blacklist
+static inline uint32_t locationAlerts(const CompiledRules *rules, const Transaction *txn,
+                                      const FraudContext *context) {
+    return (uint32_t)isUnusualMinute(rules, context->minuteOfDay) << ALERT_UNUSUAL_HOURS |
+           (uint32_t)isSuspiciousLocation(rules, txn->location) << ALERT_SUSPICIOUS_LOCATION |
+           (uint32_t)context->blacklistedAccount << ALERT_BLACKLISTED_ACCOUNT |
+           (uint32_t)context->blacklistedLocation << ALERT_BLACKLISTED_LOCATION;
+}
+
+// Impossible travel and location changes
+static inline uint32_t travelAlerts(const CompiledRules *rules, const FraudContext *context) {
+    if (!context->locationChanged) return 0;
+
+    uint32_t minTravel = context->minTravelSeconds;
+    if (minTravel == 0) minTravel = (uint32_t)rules->impossibleTravelTime;
+
+    if (context->sinceLastTxn < minTravel) return ALERT_BIT(ALERT_IMPOSSIBLE_TRAVEL);
+    if (context->sinceLastTxn < rules->locationChangeWindow) return ALERT_BIT(ALERT_LOCATION_CHANGE);
+    return 0;
+}
+
+// Account-relative checks: amount, rate, hour and place against what the
+// account's own earlier transactions look like
+static inline uint32_t profileAlerts(const CompiledRules *rules, const FraudContext *context) {
+    if (rules->profileMinHistory <= 0 || context->profileCount < (uint32_t)rules->profileMinHistory) return 0;
+
+    const BehaviorFeatures *features = &context->behavior;
+    return (uint32_t)(features->amountZScore > rules->amountZScoreThreshold) << ALERT_AMOUNT_ANOMALY |
+           (uint32_t)(features->rateRatio > rules->rateSpikeRatio) << ALERT_RATE_SPIKE |
+           (uint32_t)(features->hourShare < rules->rareHourShare) << ALERT_UNUSUAL_ACCOUNT_HOUR |
+           (uint32_t)!features->knownLocation << ALERT_NEW_LOCATION;
+}
+
+uint32_t evaluateRules(const CompiledRules *rules, const Account *acc, const Transaction *txn,
+                       const FraudContext *context) {
+    return amountAlerts(rules, txn->amount) |
+           velocityAlerts(rules, acc, txn, context) |
+           locationAlerts(rules, txn, context) |
+           travelAlerts(rules, context) |
+           profileAlerts(rules, context);
+}
+
+void recordAccountActivity(Account *acc, const Transaction *txn) {
+    acc->lastLocation = txn->location;
+    acc->lastTxnTime = txn->timestamp;
+    acc->transactionCount++;
+    recordRecentActivity(acc, txn->timestamp, txn->amount);
+    updateBehaviorProfile(&acc->profile, txn->timestamp, txn->amount, txn->location);
+}
+
+void checkFraud(const CompiledRules *rules, Account *acc, Transaction *txn) {
+    FraudContext context;
+    uint32_t alerts = 0;
+    METRICS_START_SAMPLED(started);
+    METRICS_START_FROM(mark, started);
+
+    gatherFraudContext(acc, txn, rules->profileMinHistory, &context);
+    METRICS_LAP(STAGE_RULE_CONTEXT, mark);
+
+    // Same stages as evaluateRules(), timed one by one
+    alerts |= amountAlerts(rules, txn->amount);
+    METRICS_LAP(STAGE_RULE_AMOUNT, mark);
+    alerts |= velocityAlerts(rules, acc, txn, &context);
+    METRICS_LAP(STAGE_RULE_VELOCITY, mark);
+    alerts |= locationAlerts(rules, txn, &context);
+    METRICS_LAP(STAGE_RULE_LOCATION, mark);
+    alerts |= travelAlerts(rules, &context);
+    METRICS_LAP(STAGE_RULE_TRAVEL, mark);
+    alerts |= profileAlerts(rules, &context);
+    METRICS_LAP(STAGE_RULE_PROFILE, mark);
+
+    txn->alertMask |= alerts;
+    recordAccountActivity(acc, txn);
+
+    // Calculate risk score
+    txn->riskScore = calculateRiskScore(rules, txn);
+    txn->ruleVersion = rules->version;
+
+    // Determine status ("No fraud detected" is added when serializing)
+    txn->status = (txn->riskScore > rules->suspiciousScoreThreshold) ? TXN_STATUS_SUSPICIOUS : TXN_STATUS_CLEAN;
+
+    METRICS_LAP(STAGE_SCORING, mark);
+    METRICS_SPAN(STAGE_CHECK_FRAUD, started, mark);
+    METRICS_COUNT_TRANSACTION(txn);
+}
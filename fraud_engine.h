@@ -0,0 +1,59 @@
+/**
+ * Fraud Engine for Fraud Detection System
+ * Rule evaluation and risk scoring for a single transaction
+ */
+
+#ifndef FRAUD_ENGINE_H
+#define FRAUD_ENGINE_H
+
+#include "account_store.h"
+#include "transaction_log.h"
+#include "rule_engine.h"
+
+// Everything the rules read that does not depend on the rule set, so one
+// transaction can be evaluated under many rule sets at the cost of one
+typedef struct {
+    int spendingExceeded;       // over the daily or monthly limit
+    int minuteOfDay;            // UTC
+    int blacklistedAccount;
+    int blacklistedLocation;
+    int locationChanged;        // differs from the account's last location
+    double sinceLastTxn;        // seconds, when locationChanged
+    uint32_t minTravelSeconds;  // great-circle flight time, 0 if unknown
+    uint32_t profileCount;      // transactions in the behavior profile
+    BehaviorFeatures behavior;  // see gatherFraudContext()
+} FraudContext;
+
+int calculateRiskScore(const CompiledRules *rules, Transaction *txn);
+
+/**
+ * Fill in context for txn from the account's state before it. Adds txn to
+ * the account's spend counters, so call once per transaction. Behavior
+ * features are only filled in once the profile holds profileMinHistory
+ * transactions: pass the smallest nonzero value of the rule sets to be
+ * evaluated, or 0 if none uses the profile.
+ */
+void gatherFraudContext(Account *acc, const Transaction *txn, int profileMinHistory, FraudContext *context);
+
+/**
+ * Alerts the rule set raises for txn. Pure: reads the account, changes
+ * nothing, and may be called for any number of rule sets in between
+ * gatherFraudContext() and recordAccountActivity().
+ */
+uint32_t evaluateRules(const CompiledRules *rules, const Account *acc, const Transaction *txn,
+                       const FraudContext *context);
+
+/**
+ * Move the account's location, time, velocity ring and behavior profile
+ * past txn
+ */
+void recordAccountActivity(Account *acc, const Transaction *txn);
+
+/**
+ * Run every compiled rule against txn, fill in its alerts, risk score and
+ * status, and update the account's location, velocity and behavior state.
+ * Equivalent to the three calls above, with each rule stage timed.
+ */
+void checkFraud(const CompiledRules *rules, Account *acc, Transaction *txn);
+
+#endif
@@ -2,252 +2,546 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include "account_store.h"
+#include "transaction_log.h"
+#include "data_manager.h"
+#include "data_export.h"
+#include "fraud_engine.h"
+#include "alert_codes.h"
+#include "journal.h"
+#include "history_segments.h"
+#include "batch_scoring.h"
+#include "location_table.h"
+#include "blacklist.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "alert_outbox.h"
+#include "backtest.h"
+#include "serve_pipeline.h"
 
-#define MAX_ACCOUNTS 10
-#define MAX_TRANSACTIONS 100
-#define MAX_ALERTS 10
 #define BUFFER_SIZE 1024
+#define RULES_CHECK_INTERVAL 1      // seconds between fraud_patterns.json mtime checks
 
-typedef struct {
-    int accNo;
-    char name[50];
-    double balance;
-    char lastLocation[30];
-    time_t lastTxnTime;
-    int transactionCount;
-} Account;
-
-typedef struct {
-    int txnId;
-    int accNo;
-    double amount;
-    char location[30];
-    time_t timestamp;
-    char alerts[MAX_ALERTS][100];
-    int alertCount;
-    int riskScore;
-    char status[20];
-} Transaction;
-
-Account accounts[MAX_ACCOUNTS];
-Transaction transactions[MAX_TRANSACTIONS];
-int txnCount = 0;
+static volatile sig_atomic_t reloadRequested = 0;
 
+// Fallback accounts used when data/accounts.json is unavailable
 void setupAccounts() {
     Account sampleAccounts[] = {
-        {100, "Alice Smith", 150000.0, "", 0, 0},
-        {101, "Bob Johnson", 75000.0, "", 0, 0},
-        {102, "Carol Davis", 250000.0, "", 0, 0},
-        {103, "David Wilson", 50000.0, "", 0, 0},
-        {104, "Eva Brown", 300000.0, "", 0, 0},
-        {105, "Frank Miller", 120000.0, "", 0, 0},
-        {106, "Grace Lee", 80000.0, "", 0, 0},
-        {107, "Henry Clark", 200000.0, "", 0, 0},
-        {108, "Ivy Garcia", 60000.0, "", 0, 0},
-        {109, "Jack Martinez", 180000.0, "", 0, 0}
+        {.accNo = 100, .name = "Alice Smith", .balance = 150000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 101, .name = "Bob Johnson", .balance = 75000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 102, .name = "Carol Davis", .balance = 250000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 103, .name = "David Wilson", .balance = 50000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 104, .name = "Eva Brown", .balance = 300000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 105, .name = "Frank Miller", .balance = 120000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 106, .name = "Grace Lee", .balance = 80000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 107, .name = "Henry Clark", .balance = 200000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 108, .name = "Ivy Garcia", .balance = 60000.0, .lastLocation = LOCATION_NONE},
+        {.accNo = 109, .name = "Jack Martinez", .balance = 180000.0, .lastLocation = LOCATION_NONE}
     };
+    int sampleCount = sizeof(sampleAccounts) / sizeof(sampleAccounts[0]);
     
-    for (int i = 0; i < MAX_ACCOUNTS; i++) {
-        accounts[i] = sampleAccounts[i];
+    initAccountStore(&accountStore, sampleCount);
+    for (int i = 0; i < sampleCount; i++) {
+        sampleAccounts[i].isActive = 1;
+        sampleAccounts[i].accountType = "standard";
+        addAccount(&accountStore, &sampleAccounts[i]);
     }
 }
 
-void addAlert(Transaction *txn, const char *alert) {
-    if (txn->alertCount < MAX_ALERTS) {
-        strcpy(txn->alerts[txn->alertCount], alert);
-        txn->alertCount++;
+// LOCATIONS <from> <to> [clean|suspicious]
+void handleLocationQuery(JsonWriter *out, const char *args) {
+    long long from, to;
+    char status[16] = "";
+    ScanFilter filter;
+
+    if (sscanf(args, "%lld %lld %15s", &from, &to, status) < 2 || from > to) {
+        printError(out, "Usage: LOCATIONS <from> <to> [clean|suspicious]");
+        return;
     }
+
+    initScanFilter(&filter);
+    filter.from = (time_t)from;
+    filter.to = (time_t)to;
+    if (status[0]) filter.status = parseTxnStatus(status);
+    exportLocationTotals(out, &filter);
 }
 
-int calculateRiskScore(Transaction *txn) {
-    int score = 0;
-    
-    for (int i = 0; i < txn->alertCount; i++) {
-        if (strstr(txn->alerts[i], "High-value")) score += 25;
-        if (strstr(txn->alerts[i], "Very high-value")) score += 50;
-        if (strstr(txn->alerts[i], "Rapid multiple")) score += 30;
-        if (strstr(txn->alerts[i], "Impossible travel")) score += 40;
-        if (strstr(txn->alerts[i], "Location change")) score += 10;
-        if (strstr(txn->alerts[i], "Round amount")) score += 5;
+// HISTORY [ACCOUNT <accNo>] [FROM <t>] [TO <t>] [STATUS <status>] [CURSOR <c>] [LIMIT <n>]
+void handleHistoryQuery(JsonWriter *out, const char *args) {
+    HistoryQuery query;
+    long cursor = HISTORY_FIRST_PAGE;
+    int limit = 50;
+    char key[16], value[32];
+    int consumed;
+
+    initHistoryQuery(&query);
+    while (sscanf(args, "%15s %31s%n", key, value, &consumed) == 2) {
+        if (strcmp(key, "ACCOUNT") == 0) {
+            query.accNo = atoi(value);
+        } else if (strcmp(key, "FROM") == 0) {
+            query.from = (time_t)atoll(value);
+        } else if (strcmp(key, "TO") == 0) {
+            query.to = (time_t)atoll(value);
+        } else if (strcmp(key, "STATUS") == 0) {
+            query.status = parseTxnStatus(value);
+        } else if (strcmp(key, "CURSOR") == 0) {
+            cursor = atol(value);
+        } else if (strcmp(key, "LIMIT") == 0) {
+            limit = atoi(value);
+        } else {
+            break;
+        }
+        args += consumed;
     }
-    
-    return (score > 100) ? 100 : score;
+
+    if (args[strspn(args, " \t")] != '\0' || query.from > query.to || cursor < 0 ||
+        limit <= 0 || limit > HISTORY_MAX_PAGE) {
+        printError(out, "Usage: HISTORY [ACCOUNT n] [FROM t] [TO t] [STATUS s] [CURSOR c] [LIMIT 1-1000]");
+        return;
+    }
+    exportHistoryPage(out, &query, cursor, limit);
 }
 
-void checkFraud(Transaction *txn) {
-    Account *acc = NULL;
-    for (int i = 0; i < MAX_ACCOUNTS; i++) {
-        if (accounts[i].accNo == txn->accNo) { 
-            acc = &accounts[i]; 
-            break; 
+// RULES | RULES RELOAD
+void handleRulesCommand(JsonWriter *out, const char *args) {
+    char action[16];
+
+    if (sscanf(args, "%15s", action) == 1) {
+        if (strcmp(action, "RELOAD") != 0) {
+            printError(out, "Usage: RULES [RELOAD]");
+        } else if (reloadFraudRulesInBackground(DATA_FILE_FRAUD_RULES)) {
+            jsonWriteLiteral(out, "{\"success\": true}\n");
+        } else {
+            printError(out, "Rules reload already running");
         }
+        return;
     }
-    if (!acc) return;
 
-    // High value transaction checks
-    if (txn->amount > 100000) {
-        addAlert(txn, "Very high-value transaction");
-    } else if (txn->amount > 50000) {
-        addAlert(txn, "High-value transaction");
+    const CompiledRules *rules = acquireRules();
+    uint32_t version = rules->version;
+    releaseRules();
+
+    jsonWriteLiteral(out, "{\"success\": true, \"ruleVersion\": ");
+    jsonWriteInt(out, version);
+    jsonWriteLiteral(out, "}\n");
+}
+
+// PROFILE <accNo>
+void handleProfileQuery(JsonWriter *out, const char *args) {
+    int accNo;
+
+    if (sscanf(args, "%d", &accNo) != 1) {
+        printError(out, "Usage: PROFILE <accNo>");
+        return;
     }
 
-    // Rapid transaction check (last 5 minutes)
-    int recentCount = 0;
-    time_t fiveMinutesAgo = txn->timestamp - 300; // 5 minutes in seconds
-    
-    for (int i = 0; i < txnCount; i++) {
-        if (transactions[i].accNo == txn->accNo && 
-            transactions[i].timestamp >= fiveMinutesAgo) {
-            recentCount++;
+    const Account *account = findAccount(&accountStore, accNo);
+    if (!account) {
+        printError(out, "Account not found");
+        return;
+    }
+    exportBehaviorProfile(out, account, time(NULL));
+}
+
+// BLACKLIST IP <addr> | BLACKLIST MERCHANT <name>
+void handleBlacklistQuery(JsonWriter *out, const char *args) {
+    char kind[16];
+    int offset = 0;
+
+    if (sscanf(args, "%15s %n", kind, &offset) != 1 || args[offset] == '\0') {
+        printError(out, "Usage: BLACKLIST <IP|MERCHANT> <value>");
+        return;
+    }
+
+    const char *value = args + offset;
+    int listed;
+    if (strcmp(kind, "IP") == 0) {
+        uint32_t ip;
+        int prefix;
+        if (!parseIpv4(value, strlen(value), &ip, &prefix) || prefix != 32) {
+            printError(out, "Invalid IPv4 address");
+            return;
         }
+        const Blacklist *blacklist = acquireBlacklist();
+        listed = blacklist && blacklistHasIp(blacklist, ip);
+        releaseBlacklist();
+    } else if (strcmp(kind, "MERCHANT") == 0) {
+        const Blacklist *blacklist = acquireBlacklist();
+        listed = blacklist && blacklistHasMerchant(blacklist, value, strlen(value));
+        releaseBlacklist();
+    } else {
+        printError(out, "Usage: BLACKLIST <IP|MERCHANT> <value>");
+        return;
     }
-    
-    if (recentCount >= 3) {
-        addAlert(txn, "Multiple rapid transactions detected");
+
+    jsonWriteLiteral(out, "{\"success\": true, \"blacklisted\": ");
+    jsonWriteBool(out, listed);
+    jsonWriteLiteral(out, "}\n");
+}
+
+/**
+ * Handle one request line of the --serve protocol:
+ *   TXN <accNo> <amount> <location>   process a transaction
+ *   PING                              liveness check
+ *   STATS                             running statistics and time windows
+ *   LOCATIONS <from> <to> [status]    per-location totals over a time range
+ *                                     (Unix seconds), optionally one status
+ *   HISTORY [ACCOUNT n] [FROM t] [TO t] [STATUS s] [CURSOR c] [LIMIT n]
+ *                                     one page of matching transactions,
+ *                                     newest first; pass nextCursor back
+ *                                     as CURSOR for the following page
+ *   METRICS                           stage timings and alert counters as
+ *                                     Prometheus text in the "metrics" field
+ *   COMPACT                           fold the journal into the JSON files
+ *                                     and start a fresh snapshot
+ *   SNAPSHOT                          write the binary snapshot in the
+ *                                     background
+ *   RELOAD                            rebuild the blacklist in the background
+ *   RULES                             version of the fraud rules in effect
+ *   RULES RELOAD                      recompile the fraud rules in the
+ *                                     background; scoring continues on the
+ *                                     old set until the new one is swapped in
+ *   PROFILE <accNo>                   the account's behavior profile
+ *   BLACKLIST IP <addr>               check an address against the blacklist
+ *   BLACKLIST MERCHANT <name>         check a merchant against the blacklist
+ *   QUIT                              stop serving
+ * Every request gets exactly one single-line JSON response.
+ * Returns 0 when the session should end.
+ */
+int handleRequest(JsonWriter *out, char *line) {
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char command[16];
+    int consumed = 0;
+    if (sscanf(line, "%15s%n", command, &consumed) != 1) {
+        printError(out, "Empty request");
+        return 1;
     }
 
-    // Location-based checks
-    if (strlen(acc->lastLocation) > 0) {
-        double timeDiff = difftime(txn->timestamp, acc->lastTxnTime);
-        
-        // Impossible travel check (less than 2 hours between distant locations)
-        if (timeDiff < 7200) { // 2 hours
-            int impossibleTravel = 0;
-            
-            if ((strcmp(acc->lastLocation, "Tokyo") == 0 && strcmp(txn->location, "New York") == 0) ||
-                (strcmp(acc->lastLocation, "London") == 0 && strcmp(txn->location, "Sydney") == 0) ||
-                (strcmp(acc->lastLocation, "Paris") == 0 && strcmp(txn->location, "Dubai") == 0)) {
-                impossibleTravel = 1;
-                addAlert(txn, "Impossible travel detected");
-            } else if (strcmp(acc->lastLocation, txn->location) != 0) {
-                addAlert(txn, "Location change detected");
-            }
+    if (strcmp(command, "TXN") == 0) {
+        int accNo;
+        double amount;
+        const char *location;
+        if (!parseTxnArgs(line + consumed, &accNo, &amount, &location)) {
+            printError(out, "Usage: TXN <accNo> <amount> <location>");
+            return 1;
+        }
+        performTransaction(out, accNo, amount, location);
+    } else if (strcmp(command, "PING") == 0) {
+        jsonWriteLiteral(out, "{\"success\": true, \"transactions\": ");
+        jsonWriteInt(out, txnCount);
+        jsonWriteLiteral(out, "}\n");
+    } else if (strcmp(command, "STATS") == 0) {
+        exportStatistics(out);
+    } else if (strcmp(command, "LOCATIONS") == 0) {
+        handleLocationQuery(out, line + consumed);
+    } else if (strcmp(command, "HISTORY") == 0) {
+        handleHistoryQuery(out, line + consumed);
+    } else if (strcmp(command, "METRICS") == 0) {
+        JsonWriter text;
+        jsonWriterInit(&text, -1);
+        writeMetricsText(&text);
+        jsonWriteLiteral(out, "{\"success\": true, \"metrics\": ");
+        jsonWriteStringN(out, text.data, text.length);
+        jsonWriteLiteral(out, "}\n");
+        jsonWriterFree(&text);
+    } else if (strcmp(command, "COMPACT") == 0) {
+        if (compactJournal()) {
+            startBackgroundSnapshot(DATA_FILE_SNAPSHOT);
+            jsonWriteLiteral(out, "{\"success\": true}\n");
+        } else {
+            printError(out, "Compaction failed");
+        }
+    } else if (strcmp(command, "SNAPSHOT") == 0) {
+        // Everything answered so far must be durable before it is imaged
+        if (!journalCommit()) {
+            printError(out, "Journal commit failed");
+        } else if (startBackgroundSnapshot(DATA_FILE_SNAPSHOT)) {
+            jsonWriteLiteral(out, "{\"success\": true}\n");
+        } else {
+            printError(out, "Snapshot already running");
         }
+    } else if (strcmp(command, "RELOAD") == 0) {
+        if (reloadBlacklistInBackground(DATA_FILE_BLACKLIST)) {
+            jsonWriteLiteral(out, "{\"success\": true}\n");
+        } else {
+            printError(out, "Blacklist reload already running");
+        }
+    } else if (strcmp(command, "RULES") == 0) {
+        handleRulesCommand(out, line + consumed);
+    } else if (strcmp(command, "PROFILE") == 0) {
+        handleProfileQuery(out, line + consumed);
+    } else if (strcmp(command, "BLACKLIST") == 0) {
+        handleBlacklistQuery(out, line + consumed);
+    } else if (strcmp(command, "QUIT") == 0) {
+        jsonWriteLiteral(out, "{\"success\": true}\n");
+        return 0;
+    } else {
+        printError(out, "Unknown command");
+    }
+    return 1;
+}
+
+static void requestReload(int signal) {
+    (void)signal;
+    reloadRequested = 1;
+}
+
+/**
+ * Start background reloads: rules and blacklist on SIGHUP, rules alone
+ * when fraud_patterns.json has been modified
+ */
+static void checkReloadTriggers(time_t *lastRulesCheck) {
+    if (reloadRequested) {
+        reloadRequested = 0;
+        reloadFraudRulesInBackground(DATA_FILE_FRAUD_RULES);
+        reloadBlacklistInBackground(DATA_FILE_BLACKLIST);
+        return;
     }
 
-    // Round amount check
-    if (fmod(txn->amount, 1000.0) == 0 && txn->amount > 1000.0) {
-        addAlert(txn, "Round amount transaction");
+    time_t now = time(NULL);
+    if (now - *lastRulesCheck < RULES_CHECK_INTERVAL) return;
+    *lastRulesCheck = now;
+    if (fraudRulesFileChanged(DATA_FILE_FRAUD_RULES)) {
+        reloadFraudRulesInBackground(DATA_FILE_FRAUD_RULES);
     }
+}
 
-    // Update account location and time
-    strcpy(acc->lastLocation, txn->location);
-    acc->lastTxnTime = txn->timestamp;
-    acc->transactionCount++;
+// Long-lived mode: accounts and history stay in memory between requests.
+// Every request that arrived in the same read() shares one journal commit
+// (group commit), and its responses are released only after that commit,
+// together in a single write(). TXN requests are spread over threadCount
+// workers by account.
+void serveRequests(int inFd, int outFd, int threadCount) {
+    static char input[READ_BUFFER_SIZE];
+    size_t used = 0;
+    int keepGoing = 1;
+    time_t lastRulesCheck = time(NULL);
+    JsonWriter batch;
+    jsonWriterInit(&batch, outFd);
 
-    // Calculate risk score
-    txn->riskScore = calculateRiskScore(txn);
+    // No SA_RESTART, so SIGHUP also wakes an idle read()
+    struct sigaction hangup;
+    memset(&hangup, 0, sizeof(hangup));
+    hangup.sa_handler = requestReload;
+    sigemptyset(&hangup.sa_mask);
+    sigaction(SIGHUP, &hangup, NULL);
+    startServeWorkers(threadCount);
+
+    // main() blocked SIGHUP before starting any thread; only this one takes it
+    sigset_t hangupSet;
+    sigemptyset(&hangupSet);
+    sigaddset(&hangupSet, SIGHUP);
+    pthread_sigmask(SIG_UNBLOCK, &hangupSet, NULL);
+    checkReloadTriggers(&lastRulesCheck);
     
-    // Determine status
-    if (txn->riskScore > 20) {
-        strcpy(txn->status, "suspicious");
-    } else {
-        strcpy(txn->status, "clean");
-        if (txn->alertCount == 0) {
-            addAlert(txn, "No fraud detected");
+    while (keepGoing) {
+        ssize_t bytesRead = read(inFd, input + used, sizeof(input) - used);
+        if (bytesRead < 0 && errno == EINTR) {
+            checkReloadTriggers(&lastRulesCheck);
+            continue;
+        }
+        if (bytesRead <= 0) break;
+        used += (size_t)bytesRead;
+        
+        int requests = 0;
+        char *lineStart = input;
+        char *newline;
+        while (keepGoing && (newline = memchr(lineStart, '\n', input + used - lineStart))) {
+            *newline = '\0';
+            if (!queueTxnRequest(&batch, lineStart)) {
+                runSegment(&batch);
+                keepGoing = handleRequest(&batch, lineStart);
+            }
+            requests++;
+            lineStart = newline + 1;
+        }
+        runSegment(&batch);
+        
+        if (lineStart == input && used == sizeof(input)) {
+            printError(&batch, "Request too long");
+            used = 0;
+        } else {
+            used -= (size_t)(lineStart - input);
+            memmove(input, lineStart, used);
         }
+        
+        METRICS_SET_GAUGE(GAUGE_SERVE_BATCH_REQUESTS, requests);
+        METRICS_START(commitStarted);
+        if (!journalCommit()) {
+            fprintf(stderr, "Warning: responses sent without a durable journal commit\n");
+        }
+        METRICS_STAGE(STAGE_JOURNAL_COMMIT, commitStarted);
+        if (!jsonWriterFlush(&batch)) break;
+        
+        if (journalSize() > JOURNAL_COMPACT_BYTES && compactJournal()) {
+            startBackgroundSnapshot(DATA_FILE_SNAPSHOT);
+        }
+        pollBackgroundSnapshot();
+        checkReloadTriggers(&lastRulesCheck);
     }
+    jsonWriterFree(&batch);
+    stopServeWorkers();
+    waitBackgroundSnapshot();
 }
 
-void printJsonResponse(Transaction *txn, double remainingBalance) {
-    printf("{\n");
-    printf("  \"success\": true,\n");
-    printf("  \"transaction\": {\n");
-    printf("    \"id\": %d,\n", txn->txnId);
-    printf("    \"accNo\": %d,\n", txn->accNo);
-    printf("    \"amount\": %.2f,\n", txn->amount);
-    printf("    \"location\": \"%s\",\n", txn->location);
-    printf("    \"timestamp\": %ld,\n", txn->timestamp);
-    printf("    \"riskScore\": %d,\n", txn->riskScore);
-    printf("    \"status\": \"%s\",\n", txn->status);
-    printf("    \"remainingBalance\": %.2f,\n", remainingBalance);
-    printf("    \"alerts\": [\n");
-    
-    for (int i = 0; i < txn->alertCount; i++) {
-        printf("      \"%s\"%s\n", txn->alerts[i], 
-               (i < txn->alertCount - 1) ? "," : "");
-    }
-    
-    printf("    ]\n");
-    printf("  }\n");
-    printf("}\n");
+void printUsage() {
+    printf("Usage:\n");
+    printf("  ./fraudbackend <accNo> <amount> <location>   Process one transaction\n");
+    printf("  ./fraudbackend --serve [--threads N]         Serve line requests on stdin/stdout\n");
+    printf("  ./fraudbackend --accounts                    Export accounts as JSON\n");
+    printf("  ./fraudbackend --history [limit]             Export recent transactions as JSON\n");
+    printf("  ./fraudbackend --stats                       Export statistics as JSON\n");
+    printf("  ./fraudbackend --compact                     Fold the journal into the JSON files\n");
+    printf("  ./fraudbackend --snapshot                    Write the binary startup snapshot\n");
+    printf("  ./fraudbackend --batch <in> [out] [--threads N]\n");
+    printf("                                               Score a JSONL/CSV file offline\n");
+    printf("  ./fraudbackend --backtest [rules.json ...] [--threads N]\n");
+    printf("                                               Replay history under candidate rules\n");
+    printf("  ./fraudbackend --help                        Show this help\n");
 }
 
-void performTransaction(int accNo, double amount, const char *location) {
-    if (txnCount >= MAX_TRANSACTIONS) {
-        printf("{\"success\": false, \"error\": \"Transaction limit reached\"}");
-        return;
+// Offline scoring only needs the rules and account profiles, not history
+int runBatchCommand(int argc, char *argv[]) {
+    const char *inputPath = argv[2];
+    const char *outputPath = NULL;
+    int threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else {
+            outputPath = argv[i];
+        }
     }
 
-    // Find account and validate
-    Account *acc = NULL;
-    for (int i = 0; i < MAX_ACCOUNTS; i++) {
-        if (accounts[i].accNo == accNo) {
-            acc = &accounts[i];
-            break;
+    int outFd = outputPath ? open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+    if (outFd < 0) {
+        JsonWriter out;
+        jsonWriterInit(&out, STDOUT_FILENO);
+        printError(&out, "Could not open batch output file");
+        jsonWriterFlush(&out);
+        jsonWriterFree(&out);
+        return 1;
+    }
+
+    loadLocations();
+    loadFraudRules();
+    loadBlacklist();
+    loadAccountsFromFile();
+    int ok = runBatchScoring(inputPath, outFd, threadCount);
+
+    if (outFd != STDOUT_FILENO) close(outFd);
+    return ok ? 0 : 1;
+}
+
+// The rules in effect always come first, so candidates are diffed against them
+int runBacktestCommand(int argc, char *argv[]) {
+    const char *rulePaths[MAX_BACKTEST_CONFIGS];
+    int configCount = 0;
+    int threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    rulePaths[configCount++] = DATA_FILE_FRAUD_RULES;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (configCount < MAX_BACKTEST_CONFIGS) {
+            rulePaths[configCount++] = argv[i];
+        } else {
+            fprintf(stderr, "Error: At most %d rule sets per backtest\n", MAX_BACKTEST_CONFIGS - 1);
+            return 1;
         }
     }
-    
-    if (!acc) {
-        printf("{\"success\": false, \"error\": \"Account not found\"}");
-        return;
+
+    int ok = runBacktest(rulePaths, configCount, threadCount, STDOUT_FILENO);
+    closeJournal();
+    closeHistorySegments();
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage();
+        return 0;
     }
-    
-    if (acc->balance < amount) {
-        printf("{\"success\": false, \"error\": \"Insufficient balance\"}");
-        return;
+
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        return runBatchCommand(argc, argv);
     }
 
-    // Create transaction
-    Transaction txn;
-    txn.txnId = txnCount + 1;
-    txn.accNo = accNo;
-    txn.amount = amount;
-    strcpy(txn.location, location);
-    txn.timestamp = time(NULL);
-    txn.alertCount = 0;
-    txn.riskScore = 0;
-    
-    // Update account balance
-    acc->balance -= amount;
-    double remainingBalance = acc->balance;
-    
-    // Check for fraud
-    checkFraud(&txn);
-    
-    // Store transaction
-    if (txnCount < MAX_TRANSACTIONS) {
-        transactions[txnCount] = txn;
-        txnCount++;
+    initializeDataSystem();
+    if (accountStore.count == 0) {
+        setupAccounts();
     }
     
-    // Print JSON response
-    printJsonResponse(&txn, remainingBalance);
-}
+    // Changes since the last compaction live only in the journal
+    if (openJournal(DATA_FILE_JOURNAL)) {
+        replayJournal();
+    }
 
-int main(int argc, char *argv[]) {
-    if (argc != 4) {
-        printf("{\"success\": false, \"error\": \"Usage: ./fraudbackend <accNo> <amount> <location>\"}");
-        return 1;
+    if (argc == 2 && strcmp(argv[1], "--compact") == 0) {
+        return (compactJournal() && saveSnapshot(DATA_FILE_SNAPSHOT)) ? 0 : 1;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "--snapshot") == 0) {
+        return saveSnapshot(DATA_FILE_SNAPSHOT) ? 0 : 1;
     }
 
-    setupAccounts();
+    if (argc >= 2 && strcmp(argv[1], "--backtest") == 0) {
+        return runBacktestCommand(argc, argv);
+    }
 
-    int accNo = atoi(argv[1]);
-    double amount = atof(argv[2]);
-    char *location = argv[3];
+    if (argc >= 2 && strcmp(argv[1], "--serve") == 0) {
+        int threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (argc == 4 && strcmp(argv[2], "--threads") == 0) threadCount = atoi(argv[3]);
 
-    if (accNo < 100 || accNo > 109) {
-        printf("{\"success\": false, \"error\": \"Invalid account number\"}");
-        return 1;
+        // Every thread inherits this mask, so none can take a SIGHUP
+        // before serveRequests installs its handler on this thread
+        sigset_t hangupSet;
+        sigemptyset(&hangupSet);
+        sigaddset(&hangupSet, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &hangupSet, NULL);
+        openAlertOutbox(DATA_FILE_ALERT_OUTBOX);
+        serveRequests(STDIN_FILENO, STDOUT_FILENO, threadCount);
+        closeAlertOutbox();
+        closeJournal();
+        closeHistorySegments();
+        return 0;
     }
-    
-    if (amount <= 0) {
-        printf("{\"success\": false, \"error\": \"Invalid amount\"}");
-        return 1;
+
+    JsonWriter out;
+    jsonWriterInit(&out, STDOUT_FILENO);
+    int ok = 1;
+
+    if (argc >= 2 && strcmp(argv[1], "--accounts") == 0) {
+        exportAccountsToJSON(&out);
+    } else if (argc >= 2 && strcmp(argv[1], "--history") == 0) {
+        exportTransactionsToJSON(&out, argc >= 3 ? atoi(argv[2]) : 0);
+    } else if (argc >= 2 && strcmp(argv[1], "--stats") == 0) {
+        exportStatistics(&out);
+    } else if (argc < 4) {
+        // Extra trailing arguments (contact details from server.js) are ignored
+        printError(&out, "Usage: ./fraudbackend <accNo> <amount> <location>");
+        ok = 0;
+    } else {
+        int accNo = atoi(argv[1]);
+        double amount = atof(argv[2]);
+        char *location = argv[3];
+
+        openAlertOutbox(DATA_FILE_ALERT_OUTBOX);
+        ok = performTransaction(&out, accNo, amount, location);
+        closeJournal();
+        closeHistorySegments();
+        closeAlertOutbox();
     }
 
-    performTransaction(accNo, amount, location);
-    return 0;
+    jsonWriterFlush(&out);
+    jsonWriterFree(&out);
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,353 @@
+/**
+ * History Index for Fraud Detection System
+ * Per-account and per-status row lists plus time-block summaries over
+ * the columnar history, and cursor-paginated queries on top of them
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "history_index.h"
+#include "history_segments.h"
+#include "snapshot.h"
+
+#define INITIAL_ROW_LIST_CAPACITY 4
+#define INITIAL_ACCOUNT_SLOTS 1024
+
+HistoryIndex historyIndex;
+
+// Same Fibonacci hash as the account store
+static inline uint32_t hashAccNo(int accNo) {
+    uint32_t h = (uint32_t)accNo * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+static int appendRow(RowList *list, int row) {
+    if (list->count >= list->capacity) {
+        // Evicted entries are left behind whenever the list moves; twice the
+        // live entries keeps the copying amortized either way
+        int live = list->count - list->first;
+        int newCapacity = live ? live * 2 : INITIAL_ROW_LIST_CAPACITY;
+        int *moved;
+        if (list->first == 0) {
+            moved = snapshotRealloc(list->rows, (size_t)live * sizeof(int), (size_t)newCapacity * sizeof(int));
+        } else {
+            moved = malloc((size_t)newCapacity * sizeof(int));
+            if (moved) {
+                memcpy(moved, list->rows + list->first, (size_t)live * sizeof(int));
+                snapshotFree(list->rows);
+            }
+        }
+        if (!moved) return 0;
+        list->rows = moved;
+        list->first = 0;
+        list->count = live;
+        list->capacity = newCapacity;
+    }
+    list->rows[list->count++] = row;
+    return 1;
+}
+
+static void dropFirstRow(RowList *list, int row) {
+    if (list->first >= list->count || list->rows[list->first] != row) return;
+    if (++list->first < list->count) return;
+
+    // Nothing of the list is left in memory
+    snapshotFree(list->rows);
+    memset(list, 0, sizeof(*list));
+}
+
+static AccountRows *findAccountRows(int accNo) {
+    if (!historyIndex.accounts) return NULL;
+
+    uint32_t mask = (uint32_t)historyIndex.accountSlots - 1;
+    for (uint32_t pos = hashAccNo(accNo) & mask; historyIndex.accounts[pos].accNo != 0; pos = (pos + 1) & mask) {
+        if (historyIndex.accounts[pos].accNo == accNo) return &historyIndex.accounts[pos];
+    }
+    return NULL;
+}
+
+static int growAccountSlots() {
+    int slotCount = historyIndex.accountSlots ? historyIndex.accountSlots * 2 : INITIAL_ACCOUNT_SLOTS;
+    AccountRows *slots = calloc((size_t)slotCount, sizeof(AccountRows));
+    if (!slots) return 0;
+
+    uint32_t mask = (uint32_t)slotCount - 1;
+    for (int i = 0; i < historyIndex.accountSlots; i++) {
+        AccountRows *entry = &historyIndex.accounts[i];
+        if (entry->accNo == 0) continue;
+        uint32_t pos = hashAccNo(entry->accNo) & mask;
+        while (slots[pos].accNo != 0) pos = (pos + 1) & mask;
+        slots[pos] = *entry;
+    }
+
+    free(historyIndex.accounts);
+    historyIndex.accounts = slots;
+    historyIndex.accountSlots = slotCount;
+    return 1;
+}
+
+static AccountRows *accountRowsFor(int accNo) {
+    AccountRows *entry = findAccountRows(accNo);
+    if (entry) return entry;
+
+    // Keep the load factor at or below one half
+    if ((historyIndex.accountCount + 1) * 2 > historyIndex.accountSlots && !growAccountSlots()) return NULL;
+
+    uint32_t mask = (uint32_t)historyIndex.accountSlots - 1;
+    uint32_t pos = hashAccNo(accNo) & mask;
+    while (historyIndex.accounts[pos].accNo != 0) pos = (pos + 1) & mask;
+    historyIndex.accounts[pos].accNo = accNo;
+    historyIndex.accountCount++;
+    return &historyIndex.accounts[pos];
+}
+
+static int summarizeRow(int row) {
+    int block = row / HISTORY_BLOCK_ROWS - historyIndex.blockBase;
+    if (block >= historyIndex.blockCapacity) {
+        // Blocks whose rows were all evicted are dropped on the way
+        int dropped = txnColumns.firstRow / HISTORY_BLOCK_ROWS - historyIndex.blockBase;
+        int kept = block - dropped;
+        int newCapacity = historyIndex.blockCapacity ? historyIndex.blockCapacity : 64;
+        while (newCapacity <= kept) newCapacity *= 2;
+
+        TimeBlock *moved;
+        if (dropped == 0) {
+            moved = snapshotRealloc(historyIndex.blocks, (size_t)historyIndex.blockCapacity * sizeof(TimeBlock),
+                                    (size_t)newCapacity * sizeof(TimeBlock));
+        } else {
+            moved = malloc((size_t)newCapacity * sizeof(TimeBlock));
+            if (moved) {
+                memcpy(moved, historyIndex.blocks + dropped, (size_t)kept * sizeof(TimeBlock));
+                snapshotFree(historyIndex.blocks);
+            }
+        }
+        if (!moved) return 0;
+        historyIndex.blocks = moved;
+        historyIndex.blockCapacity = newCapacity;
+        historyIndex.blockBase += dropped;
+        block = kept;
+    }
+
+    int64_t timestamp = txnColumns.timestamps[txnSlot(row)];
+    TimeBlock *summary = &historyIndex.blocks[block];
+    if (row % HISTORY_BLOCK_ROWS == 0 || row == txnColumns.firstRow) {
+        summary->minTime = summary->maxTime = timestamp;
+    } else {
+        if (timestamp < summary->minTime) summary->minTime = timestamp;
+        if (timestamp > summary->maxTime) summary->maxTime = timestamp;
+    }
+    return 1;
+}
+
+int indexTransactionRow(int row) {
+    if (!summarizeRow(row)) return 0;
+
+    int slot = txnSlot(row);
+    int status = txnColumns.statuses[slot];
+    if (status < TXN_STATUS_COUNT && !appendRow(&historyIndex.byStatus[status], row)) return 0;
+
+    // accNo 0 marks empty slots; such rows are reachable only by time or status
+    int accNo = txnColumns.accNos[slot];
+    if (accNo != 0) {
+        AccountRows *entry = accountRowsFor(accNo);
+        if (!entry || !appendRow(&entry->list, row)) {
+            if (status < TXN_STATUS_COUNT) historyIndex.byStatus[status].count--;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void unindexOldestRow(int row) {
+    int slot = txnSlot(row);
+    int status = txnColumns.statuses[slot];
+    if (status < TXN_STATUS_COUNT) dropFirstRow(&historyIndex.byStatus[status], row);
+
+    int accNo = txnColumns.accNos[slot];
+    if (accNo != 0) {
+        AccountRows *entry = findAccountRows(accNo);
+        if (entry) dropFirstRow(&entry->list, row);
+    }
+}
+
+int adoptAccountRows(int accNo, int *rows, int count) {
+    AccountRows *entry = accountRowsFor(accNo);
+    if (!entry) return 0;
+
+    entry->list.rows = rows;
+    entry->list.first = 0;
+    entry->list.count = count;
+    entry->list.capacity = count;
+    return 1;
+}
+
+void clearHistoryIndex() {
+    for (int i = 0; i < historyIndex.accountSlots; i++) {
+        snapshotFree(historyIndex.accounts[i].list.rows);
+    }
+    for (int status = 0; status < TXN_STATUS_COUNT; status++) {
+        snapshotFree(historyIndex.byStatus[status].rows);
+    }
+    free(historyIndex.accounts);
+    snapshotFree(historyIndex.blocks);
+    memset(&historyIndex, 0, sizeof(historyIndex));
+}
+
+void initHistoryQuery(HistoryQuery *query) {
+    query->accNo = 0;
+    query->from = (time_t)INT64_MIN;
+    query->to = (time_t)INT64_MAX;
+    query->status = HISTORY_ANY_STATUS;
+}
+
+static inline int rowAt(const RowList *list, long position) {
+    return list ? list->rows[position] : (int)position;
+}
+
+static inline int rowMatches(const HistoryQuery *query, int64_t timestamp, int status) {
+    return timestamp >= (int64_t)query->from && timestamp <= (int64_t)query->to &&
+           (query->status == HISTORY_ANY_STATUS || status == query->status);
+}
+
+/**
+ * First driver position in [low, high) holding a row after `row`
+ */
+static long positionAfterRow(const RowList *list, long low, long high, long row) {
+    while (low < high) {
+        long middle = low + (high - low) / 2;
+        if (rowAt(list, middle) <= row) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * First driver position in [low, high) holding a row after `to`; valid
+ * only while the history is time-ordered
+ */
+static long positionAfterTime(const RowList *list, long low, long high, int64_t to) {
+    while (low < high) {
+        long middle = low + (high - low) / 2;
+        if (txnColumns.timestamps[txnSlot(rowAt(list, middle))] <= to) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static inline int blockOverlaps(int block, int64_t from, int64_t to) {
+    const TimeBlock *summary = &historyIndex.blocks[block - historyIndex.blockBase];
+    return summary->maxTime >= from && summary->minTime <= to;
+}
+
+/**
+ * Walk the in-memory rows at or below `next`, newest first. Returns the
+ * row to resume at, firstRow - 1 once memory is exhausted, or -1 when an
+ * ordered walk has passed `from`.
+ */
+static long walkMemoryRows(const HistoryQuery *query, int firstPage, long next, int pageSize,
+                           int *rows, int *written, long *budget) {
+    int64_t from = (int64_t)query->from;
+    int64_t to = (int64_t)query->to;
+    int ordered = txnColumns.timeOrdered;
+    long exhausted = (long)txnColumns.firstRow - 1;
+
+    // Drive the walk from the narrowest list the query names
+    const RowList *list = NULL;
+    if (query->accNo != 0) {
+        const AccountRows *entry = findAccountRows(query->accNo);
+        if (!entry) return exhausted;
+        list = &entry->list;
+    } else if (query->status >= 0 && query->status < TXN_STATUS_COUNT) {
+        list = &historyIndex.byStatus[query->status];
+    }
+    long low = list ? list->first : txnColumns.firstRow;
+
+    long end = list ? positionAfterRow(list, low, list->count, next) : next + 1;
+    if (firstPage && ordered) end = positionAfterTime(list, low, end, to);
+
+    long position = end - 1;
+    while (position >= low && *written < pageSize && (*budget)-- > 0) {
+        int row = rowAt(list, position);
+
+        // Unordered full-history walks skip blocks outside the range whole
+        if (!list && !ordered && !blockOverlaps(row / HISTORY_BLOCK_ROWS, from, to)) {
+            position = (long)(row / HISTORY_BLOCK_ROWS) * HISTORY_BLOCK_ROWS - 1;
+            continue;
+        }
+
+        int slot = txnSlot(row);
+        int64_t timestamp = txnColumns.timestamps[slot];
+        if (ordered && timestamp < from) return -1;
+        if (rowMatches(query, timestamp, txnColumns.statuses[slot])) rows[(*written)++] = row;
+        position--;
+    }
+    return (position >= low) ? rowAt(list, position) : exhausted;
+}
+
+/**
+ * Walk the sealed rows at or below `next`, newest first, decoding only
+ * blocks whose summary admits a match. Returns the row to resume at, or -1
+ * once the sealed history is exhausted.
+ */
+static long walkSealedRows(const HistoryQuery *query, long next, int pageSize,
+                           int *rows, int *written, long *budget) {
+    int64_t from = (int64_t)query->from;
+    int64_t to = (int64_t)query->to;
+    int ordered = txnColumns.timeOrdered;
+
+    for (int block = findSealedBlock((int)next); block >= 0; block--) {
+        const SealedBlock *summary = sealedBlock(block);
+        long last = (long)summary->firstRow + summary->rowCount - 1;
+        if (next > last) next = last;
+        if (*written >= pageSize || *budget <= 0) return next;
+
+        if (ordered && summary->maxTime < from) return -1;
+        if (summary->maxTime < from || summary->minTime > to ||
+            (query->accNo != 0 && (query->accNo < summary->minAccNo || query->accNo > summary->maxAccNo))) {
+            (*budget)--;
+            next = (long)summary->firstRow - 1;
+            continue;
+        }
+
+        // Unreadable blocks are passed over like non-matching ones
+        const TransactionColumns *columns = readSealedBlock(NULL, block);
+        long i = next - summary->firstRow;
+        for (; columns && i >= 0 && *written < pageSize && *budget > 0; i--, (*budget)--) {
+            if ((query->accNo == 0 || columns->accNos[i] == query->accNo) &&
+                rowMatches(query, columns->timestamps[i], columns->statuses[i])) {
+                rows[(*written)++] = summary->firstRow + (int)i;
+            }
+        }
+        if (columns && i >= 0) return (long)summary->firstRow + i;
+        next = (long)summary->firstRow - 1;
+    }
+    return -1;
+}
+
+int queryHistoryPage(const HistoryQuery *query, long cursor, int pageSize, int *rows, long *nextCursor) {
+    // Cursors are the row to resume below plus one: row numbers are permanent
+    long next;
+    if (cursor == HISTORY_FIRST_PAGE) {
+        next = (long)txnCount - 1;
+    } else {
+        next = (cursor > 0 && cursor <= txnCount) ? cursor - 1 : -1;
+    }
+
+    int written = 0;
+    long budget = HISTORY_SCAN_BUDGET(pageSize);
+    if (next >= txnColumns.firstRow) {
+        next = walkMemoryRows(query, cursor == HISTORY_FIRST_PAGE, next, pageSize, rows, &written, &budget);
+    }
+    if (next >= 0 && written < pageSize && budget > 0) {
+        next = walkSealedRows(query, next, pageSize, rows, &written, &budget);
+    }
+
+    *nextCursor = (next >= 0) ? next + 1 : HISTORY_NO_MORE;
+    return written;
+}
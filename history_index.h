@@ -0,0 +1,103 @@
+/**
+ * History Index for Fraud Detection System
+ * Per-account and per-status row lists plus time-block summaries over
+ * the in-memory history, and cursor-paginated queries on top of them that
+ * continue into the sealed history segments
+ */
+
+#ifndef HISTORY_INDEX_H
+#define HISTORY_INDEX_H
+
+#include <stdint.h>
+#include <time.h>
+#include "transaction_log.h"
+
+#define HISTORY_BLOCK_ROWS 4096         // rows summarized per time block
+#define HISTORY_ANY_STATUS -1
+#define HISTORY_FIRST_PAGE 0            // cursor for the first page
+#define HISTORY_NO_MORE -1              // nextCursor once the query is exhausted
+#define HISTORY_MAX_PAGE 1000
+
+// Row numbers of one account or status, oldest first. Rows are appended
+// at the end and evicted from the front; entries before `first` are gone
+// and are dropped whenever the list is reallocated. Rows may sit in the
+// snapshot mapping until the list first grows.
+typedef struct {
+    int *rows;
+    int first;
+    int count;
+    int capacity;
+} RowList;
+
+typedef struct {
+    int accNo;
+    RowList list;
+} AccountRows;
+
+typedef struct {
+    int64_t minTime;
+    int64_t maxTime;
+} TimeBlock;
+
+typedef struct {
+    AccountRows *accounts;      // open-addressed on accNo, accNo 0 = empty
+    int accountSlots;           // power of two
+    int accountCount;
+    RowList byStatus[TXN_STATUS_COUNT];
+    TimeBlock *blocks;          // one per HISTORY_BLOCK_ROWS rows
+    int blockCapacity;
+    int blockBase;              // number of the block in blocks[0]
+} HistoryIndex;
+
+extern HistoryIndex historyIndex;
+
+// A row matches when every set condition holds
+typedef struct {
+    int accNo;                  // 0 = any account
+    time_t from;                // inclusive timestamp range
+    time_t to;
+    int status;                 // TxnStatus, or HISTORY_ANY_STATUS
+} HistoryQuery;
+
+/**
+ * Add the row just appended to txnColumns. Returns 0 if an index could
+ * not grow; the caller must then drop the row.
+ */
+int indexTransactionRow(int row);
+
+/**
+ * Forget the oldest in-memory row, which heads its lists, before its slot
+ * is reused
+ */
+void unindexOldestRow(int row);
+void clearHistoryIndex();
+
+/**
+ * Install an account's row list as loaded from a snapshot
+ */
+int adoptAccountRows(int accNo, int *rows, int count);
+
+/**
+ * Query matching every row; narrow the fields from here
+ */
+void initHistoryQuery(HistoryQuery *query);
+
+/**
+ * Fetch up to pageSize matching rows, newest first, resuming at cursor
+ * (HISTORY_FIRST_PAGE to start). A cursor is the row to resume below, and
+ * rows keep their numbers when they are sealed, so a cursor never skips
+ * or repeats rows that were already stored.
+ *
+ * In memory, the account or status list drives the walk when the query
+ * names one, and ordered history bisects the time range, so a page costs
+ * O(log N + rows examined). Sealed rows follow, block by block, skipping
+ * blocks whose time or accNo range rules them out. At most
+ * HISTORY_SCAN_BUDGET(pageSize) rows (or skipped blocks) are examined per
+ * call; a short page with a cursor means "keep going". Returns the number
+ * of rows written; *nextCursor is HISTORY_NO_MORE at the end.
+ */
+int queryHistoryPage(const HistoryQuery *query, long cursor, int pageSize, int *rows, long *nextCursor);
+
+#define HISTORY_SCAN_BUDGET(pageSize) ((long)(pageSize) * 64 + 4096)
+
+#endif
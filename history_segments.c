@@ -0,0 +1,715 @@
+/**
+ * History Segments for Fraud Detection System
+ * Cold tier of the transaction history: rows evicted from memory are
+ * sealed into immutable, block-compressed segment files on disk
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "history_segments.h"
+#include "snapshot.h"
+#include "util.h"
+
+#define SEGMENT_MAGIC 0x47455348u     // "HSEG"
+#define SEGMENT_VERSION 2
+#define BLOCK_MAGIC 0x4B4C4248u       // "HBLK"
+#define SEGMENT_NAME_FORMAT "%s/segment-%06d.seg"
+#define SEGMENT_DIRECTORY_MAX 480
+#define SEGMENT_PATH_MAX (SEGMENT_DIRECTORY_MAX + 32)   // room for "/segment-<int>.seg"
+
+// Widest row: ten-byte varints for timestamp and txnId, an escaped raw
+// amount, five-byte varints for accNo, alerts and version, two for the
+// location index, a byte each for risk score and status/type, and a
+// dictionary entry of its own (length and name)
+#define MAX_ENCODED_ROW (64 + 1 + LOCATION_NAME_MAX)
+
+// Cents above this lose precision in a double
+#define MAX_EXACT_CENTS 4503599627370496.0
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t segment;
+    int32_t reserved;
+} SegmentFileHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t rowCount;
+    int32_t firstRow;
+    int32_t minTxnId;
+    int32_t maxTxnId;
+    int32_t minAccNo;
+    int32_t maxAccNo;
+    uint32_t payloadLength;
+    int64_t minTime;
+    int64_t maxTime;
+    uint32_t payloadChecksum;
+    uint32_t checksum;          // CRC32C of the header up to this field
+} SegmentBlockHeader;
+
+static struct {
+    int open;
+    char directory[SEGMENT_DIRECTORY_MAX];
+    SealedBlock *blocks;        // encoded blocks, row order
+    int blockCount;
+    int blockCapacity;
+    int sealedRows;             // one past the newest sealed row
+    int fd;                     // newest segment, -1 until a block needs it
+    int segment;                // its number; the next one starts after it
+    int segmentBlocks;
+    off_t segmentBytes;
+    TransactionColumns pending; // rows not yet encoded
+    SealedBlock pendingSummary;
+    uint8_t *encoded;           // block header followed by its payload
+    uint16_t *dictionarySlot;   // by LocationId: index in the block's dictionary + 1
+} segments = {.fd = -1};
+
+static SegmentReader sharedReader = {.block = -1, .segment = -1, .fd = -1};
+
+// ==================== ENCODING ====================
+
+static inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline uint8_t *putVarint(uint8_t *out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+// NULL once the payload runs out or a varint is longer than ten bytes
+static inline const uint8_t *getVarint(const uint8_t *in, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; in && in < end && shift < 70; shift += 7) {
+        uint8_t byte = *in++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return in;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Whole cents, when dividing them by 100 gives back exactly this double
+ */
+static inline int amountInCents(double amount, int64_t *cents) {
+    double scaled = nearbyint(amount * 100.0);
+    if (!(fabs(scaled) < MAX_EXACT_CENTS)) return 0;
+    double restored = scaled / 100.0;
+    if (memcmp(&restored, &amount, sizeof(double)) != 0) return 0;
+    *cents = (int64_t)scaled;
+    return 1;
+}
+
+static size_t encodeBlock(const TransactionColumns *columns, int rowCount, const SealedBlock *summary,
+                          uint8_t *payload) {
+    uint8_t *out = payload;
+
+    int64_t previousTime = summary->minTime;
+    for (int i = 0; i < rowCount; i++) {
+        out = putVarint(out, zigzag(columns->timestamps[i] - previousTime));
+        previousTime = columns->timestamps[i];
+    }
+    int64_t previousId = summary->minTxnId;
+    for (int i = 0; i < rowCount; i++) {
+        out = putVarint(out, zigzag((int64_t)columns->txnIds[i] - previousId));
+        previousId = columns->txnIds[i];
+    }
+    for (int i = 0; i < rowCount; i++) {
+        out = putVarint(out, (uint64_t)((int64_t)columns->accNos[i] - summary->minAccNo));
+    }
+
+    // Low bit clear: zigzag cents above it; set: eight raw bytes follow
+    for (int i = 0; i < rowCount; i++) {
+        int64_t cents;
+        if (amountInCents(columns->amounts[i], &cents)) {
+            out = putVarint(out, zigzag(cents) << 1);
+        } else {
+            *out++ = 1;
+            memcpy(out, &columns->amounts[i], sizeof(double));
+            out += sizeof(double);
+        }
+    }
+
+    for (int i = 0; i < rowCount; i++) out = putVarint(out, columns->alertMasks[i]);
+    for (int i = 0; i < rowCount; i++) *out++ = columns->riskScores[i];
+    for (int i = 0; i < rowCount; i++) *out++ = (uint8_t)(columns->statuses[i] | columns->types[i] << 4);
+
+    // LocationIds depend on interning order, so blocks carry the names:
+    // a dictionary of the block's locations, then an index per row
+    int dictionarySize = 0;
+    LocationId dictionary[HISTORY_BLOCK_ROWS];
+    for (int i = 0; i < rowCount; i++) {
+        LocationId location = columns->locations[i];
+        if (segments.dictionarySlot[location] == 0) {
+            dictionary[dictionarySize++] = location;
+            segments.dictionarySlot[location] = (uint16_t)dictionarySize;
+        }
+    }
+    out = putVarint(out, (uint64_t)dictionarySize);
+    for (int i = 0; i < dictionarySize; i++) {
+        const char *name = locationName(dictionary[i]);
+        size_t length = strlen(name);
+        out = putVarint(out, length);
+        memcpy(out, name, length);
+        out += length;
+    }
+    for (int i = 0; i < rowCount; i++) out = putVarint(out, segments.dictionarySlot[columns->locations[i]] - 1u);
+    for (int i = 0; i < dictionarySize; i++) segments.dictionarySlot[dictionary[i]] = 0;
+
+    // Consecutive rows are almost always scored by the same rule set
+    uint32_t previousVersion = 0;
+    for (int i = 0; i < rowCount; i++) {
+        out = putVarint(out, columns->ruleVersions[i] ^ previousVersion);
+        previousVersion = columns->ruleVersions[i];
+    }
+    return (size_t)(out - payload);
+}
+
+#define DECODE_VARINT(value) do { \
+        in = getVarint(in, end, &(value)); \
+        if (!in) return 0; \
+    } while (0)
+
+static int decodeBlock(const uint8_t *in, const uint8_t *end, const SealedBlock *summary,
+                       TransactionColumns *columns) {
+    int rowCount = summary->rowCount;
+    uint64_t value;
+
+    int64_t time = summary->minTime;
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        time += unzigzag(value);
+        columns->timestamps[i] = time;
+    }
+    int64_t txnId = summary->minTxnId;
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        txnId += unzigzag(value);
+        columns->txnIds[i] = (int)txnId;
+    }
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        columns->accNos[i] = (int)((int64_t)summary->minAccNo + (int64_t)value);
+    }
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        if (value & 1) {
+            if (end - in < (long)sizeof(double)) return 0;
+            memcpy(&columns->amounts[i], in, sizeof(double));
+            in += sizeof(double);
+        } else {
+            columns->amounts[i] = (double)unzigzag(value >> 1) / 100.0;
+        }
+    }
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        columns->alertMasks[i] = (uint32_t)value;
+    }
+    if (end - in < 2L * rowCount) return 0;
+    for (int i = 0; i < rowCount; i++) columns->riskScores[i] = *in++;
+    for (int i = 0; i < rowCount; i++) {
+        columns->statuses[i] = *in & 0x0F;
+        columns->types[i] = *in++ >> 4;
+    }
+
+    // Names are interned into this run's IDs
+    LocationId dictionary[HISTORY_BLOCK_ROWS];
+    uint64_t dictionarySize;
+    DECODE_VARINT(dictionarySize);
+    if (dictionarySize > (uint64_t)rowCount) return 0;
+    for (uint64_t i = 0; i < dictionarySize; i++) {
+        DECODE_VARINT(value);
+        if (value > LOCATION_NAME_MAX || (uint64_t)(end - in) < value) return 0;
+        dictionary[i] = internLocationN((const char *)in, (size_t)value);
+        in += value;
+    }
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        if (value >= dictionarySize) return 0;
+        columns->locations[i] = dictionary[value];
+    }
+    uint32_t version = 0;
+    for (int i = 0; i < rowCount; i++) {
+        DECODE_VARINT(value);
+        version ^= (uint32_t)value;
+        columns->ruleVersions[i] = version;
+    }
+    return in == end;
+}
+
+// ==================== COLUMN BUFFERS ====================
+
+#define COLUMN_ROW_BYTES (sizeof(int) * 2 + sizeof(double) + sizeof(int64_t) + sizeof(uint32_t) * 2 + \
+                          sizeof(uint8_t) * 3 + sizeof(LocationId))
+
+/**
+ * Point columns at one allocation of HISTORY_BLOCK_ROWS rows, widest
+ * fields first so every column stays aligned
+ */
+static int allocBlockColumns(TransactionColumns *columns) {
+    char *memory = malloc(HISTORY_BLOCK_ROWS * COLUMN_ROW_BYTES);
+    if (!memory) return 0;
+
+    memset(columns, 0, sizeof(*columns));
+    columns->amounts = (double *)memory;
+    columns->timestamps = (int64_t *)(columns->amounts + HISTORY_BLOCK_ROWS);
+    columns->txnIds = (int *)(columns->timestamps + HISTORY_BLOCK_ROWS);
+    columns->accNos = columns->txnIds + HISTORY_BLOCK_ROWS;
+    columns->alertMasks = (uint32_t *)(columns->accNos + HISTORY_BLOCK_ROWS);
+    columns->ruleVersions = columns->alertMasks + HISTORY_BLOCK_ROWS;
+    columns->locations = (LocationId *)(columns->ruleVersions + HISTORY_BLOCK_ROWS);
+    columns->riskScores = (uint8_t *)(columns->locations + HISTORY_BLOCK_ROWS);
+    columns->statuses = columns->riskScores + HISTORY_BLOCK_ROWS;
+    columns->types = columns->statuses + HISTORY_BLOCK_ROWS;
+    columns->capacity = HISTORY_BLOCK_ROWS;
+    return 1;
+}
+
+// ==================== SEGMENT FILES ====================
+
+/**
+ * Returns 0 if the path does not fit; it must not be opened then
+ */
+static int segmentPath(char *path, int segment) {
+    int length = snprintf(path, SEGMENT_PATH_MAX, SEGMENT_NAME_FORMAT, segments.directory, segment);
+    return length > 0 && length < SEGMENT_PATH_MAX;
+}
+
+static int syncDirectory() {
+    int fd = open(segments.directory, O_RDONLY);
+    if (fd < 0) return 0;
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+static int growBlockIndex() {
+    if (segments.blockCount < segments.blockCapacity) return 1;
+
+    int newCapacity = segments.blockCapacity ? segments.blockCapacity * 2 : 64;
+    SealedBlock *grown = realloc(segments.blocks, (size_t)newCapacity * sizeof(SealedBlock));
+    if (!grown) return 0;
+    segments.blocks = grown;
+    segments.blockCapacity = newCapacity;
+    return 1;
+}
+
+/**
+ * Close the full segment (it is never written again) and create the next
+ */
+static int startSegment() {
+    if (segments.fd >= 0) {
+        if (fdatasync(segments.fd) != 0) return 0;
+        close(segments.fd);
+        segments.fd = -1;
+    }
+
+    char path[SEGMENT_PATH_MAX];
+    if (!segmentPath(path, segments.segment + 1)) return 0;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create history segment %s\n", path);
+        return 0;
+    }
+
+    SegmentFileHeader header = {SEGMENT_MAGIC, SEGMENT_VERSION, segments.segment + 1, 0};
+    if (!writeAll(fd, &header, sizeof(header)) || fdatasync(fd) != 0 || !syncDirectory()) {
+        close(fd);
+        unlink(path);
+        return 0;
+    }
+
+    segments.fd = fd;
+    segments.segment++;
+    segments.segmentBlocks = 0;
+    segments.segmentBytes = sizeof(header);
+    return 1;
+}
+
+/**
+ * Read the block headers of one segment into the index. Stops at the
+ * first block that is torn, corrupt or out of row order, and returns the
+ * file offset where it did.
+ */
+static off_t loadSegmentBlocks(int fd, int segment, off_t fileSize, int *blockCount) {
+    SegmentFileHeader fileHeader;
+    *blockCount = 0;
+    if (pread(fd, &fileHeader, sizeof(fileHeader), 0) != sizeof(fileHeader) ||
+        fileHeader.magic != SEGMENT_MAGIC || fileHeader.version != SEGMENT_VERSION ||
+        fileHeader.segment != segment) {
+        return 0;
+    }
+
+    off_t offset = sizeof(fileHeader);
+    while (offset < fileSize) {
+        SegmentBlockHeader header;
+        if (pread(fd, &header, sizeof(header), offset) != sizeof(header) ||
+            header.magic != BLOCK_MAGIC ||
+            snapshotChecksum(&header, offsetof(SegmentBlockHeader, checksum)) != header.checksum ||
+            header.rowCount == 0 || header.rowCount > HISTORY_BLOCK_ROWS ||
+            header.payloadLength > header.rowCount * MAX_ENCODED_ROW ||
+            header.firstRow < segments.sealedRows ||
+            offset + (off_t)sizeof(header) + header.payloadLength > fileSize ||
+            !growBlockIndex()) {
+            break;
+        }
+
+        SealedBlock *block = &segments.blocks[segments.blockCount++];
+        block->firstRow = header.firstRow;
+        block->rowCount = (int)header.rowCount;
+        block->minTime = header.minTime;
+        block->maxTime = header.maxTime;
+        block->minTxnId = header.minTxnId;
+        block->maxTxnId = header.maxTxnId;
+        block->minAccNo = header.minAccNo;
+        block->maxAccNo = header.maxAccNo;
+        block->segment = segment;
+        block->payloadLength = header.payloadLength;
+        block->checksum = header.payloadChecksum;
+        block->offset = offset + (off_t)sizeof(header);
+
+        segments.sealedRows = header.firstRow + (int)header.rowCount;
+        offset = block->offset + header.payloadLength;
+        (*blockCount)++;
+    }
+    return offset;
+}
+
+static int compareInts(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Segment numbers found in the directory, ascending
+ */
+static int listSegments(int **numbers) {
+    DIR *dir = opendir(segments.directory);
+    if (!dir) return -1;
+
+    int count = 0;
+    int capacity = 0;
+    *numbers = NULL;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        int number;
+        char tail;
+        if (sscanf(entry->d_name, "segment-%d.se%c", &number, &tail) != 2 || tail != 'g') continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            int *grown = realloc(*numbers, (size_t)capacity * sizeof(int));
+            if (!grown) break;
+            *numbers = grown;
+        }
+        (*numbers)[count++] = number;
+    }
+    closedir(dir);
+
+    if (count > 0) qsort(*numbers, (size_t)count, sizeof(int), compareInts);
+    return count;
+}
+
+int openHistorySegments(const char *directory) {
+    closeHistorySegments();
+    int length = snprintf(segments.directory, sizeof(segments.directory), "%s", directory);
+    if (length < 0 || length >= (int)sizeof(segments.directory)) {
+        fprintf(stderr, "Warning: History directory path %s is too long, history stays in memory\n", directory);
+        segments.directory[0] = '\0';
+        return 0;
+    }
+    if (mkdir(directory, 0755) != 0 && access(directory, W_OK) != 0) {
+        fprintf(stderr, "Warning: Could not use %s, history stays in memory\n", directory);
+        return 0;
+    }
+    if (!segments.encoded) {
+        segments.encoded = malloc(sizeof(SegmentBlockHeader) + (size_t)HISTORY_BLOCK_ROWS * MAX_ENCODED_ROW);
+        segments.dictionarySlot = calloc((size_t)MAX_LOCATIONS + 1, sizeof(uint16_t));
+        if (!segments.encoded || !segments.dictionarySlot || !allocBlockColumns(&segments.pending)) return 0;
+    }
+
+    int *numbers;
+    int count = listSegments(&numbers);
+    if (count < 0) return 0;
+
+    for (int i = 0; i < count; i++) {
+        char path[SEGMENT_PATH_MAX];
+        int isNewest = (i == count - 1);
+        int fd = segmentPath(path, numbers[i]) ? open(path, isNewest ? O_RDWR | O_APPEND : O_RDONLY) : -1;
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            fprintf(stderr, "Warning: Could not open history segment %s\n", path);
+            if (fd >= 0) close(fd);
+            continue;
+        }
+
+        int blockCount;
+        off_t validBytes = loadSegmentBlocks(fd, numbers[i], info.st_size, &blockCount);
+        segments.segment = numbers[i];
+        if (validBytes < info.st_size) {
+            if (!isNewest || validBytes == 0 || ftruncate(fd, validBytes) != 0) {
+                fprintf(stderr, "Warning: History segment %s is damaged after %d blocks\n", path, blockCount);
+            } else {
+                fprintf(stderr, "Warning: Discarding %ld bytes of incomplete history segment tail\n",
+                        (long)(info.st_size - validBytes));
+            }
+        }
+
+        // Only the newest segment is ever appended to, and only while it has room
+        if (isNewest && validBytes > 0 && blockCount < SEGMENT_MAX_BLOCKS) {
+            segments.fd = fd;
+            segments.segmentBlocks = blockCount;
+            segments.segmentBytes = validBytes;
+        } else {
+            close(fd);
+        }
+    }
+    free(numbers);
+
+    segments.open = 1;
+    if (segments.blockCount > 0) {
+        fprintf(stderr, "History segments: %d blocks, %d sealed rows\n", segments.blockCount, segments.sealedRows);
+    }
+    return 1;
+}
+
+/**
+ * Encode the pending rows and append them to the newest segment as one
+ * block. On failure the segment is cut back to where it was, so a later
+ * retry never leaves a damaged block in front of good ones.
+ */
+static int appendPendingBlock() {
+    SealedBlock *summary = &segments.pendingSummary;
+    if (summary->rowCount == 0) return 1;
+    if (!growBlockIndex()) return 0;
+    if ((segments.fd < 0 || segments.segmentBlocks >= SEGMENT_MAX_BLOCKS) && !startSegment()) return 0;
+
+    SegmentBlockHeader header;
+    uint8_t *payload = segments.encoded + sizeof(header);
+    size_t length = encodeBlock(&segments.pending, summary->rowCount, summary, payload);
+
+    memset(&header, 0, sizeof(header));
+    header.magic = BLOCK_MAGIC;
+    header.rowCount = (uint32_t)summary->rowCount;
+    header.firstRow = summary->firstRow;
+    header.minTxnId = summary->minTxnId;
+    header.maxTxnId = summary->maxTxnId;
+    header.minAccNo = summary->minAccNo;
+    header.maxAccNo = summary->maxAccNo;
+    header.payloadLength = (uint32_t)length;
+    header.minTime = summary->minTime;
+    header.maxTime = summary->maxTime;
+    header.payloadChecksum = snapshotChecksum(payload, length);
+    header.checksum = snapshotChecksum(&header, offsetof(SegmentBlockHeader, checksum));
+    memcpy(segments.encoded, &header, sizeof(header));
+
+    if (!writeAll(segments.fd, segments.encoded, sizeof(header) + length)) {
+        fprintf(stderr, "Error: Could not write history segment block\n");
+        if (ftruncate(segments.fd, segments.segmentBytes) != 0) {
+            // The damaged tail would hide every later block; start over in a new file
+            close(segments.fd);
+            segments.fd = -1;
+        }
+        return 0;
+    }
+
+    SealedBlock *block = &segments.blocks[segments.blockCount++];
+    *block = *summary;
+    block->segment = segments.segment;
+    block->payloadLength = (uint32_t)length;
+    block->checksum = header.payloadChecksum;
+    block->offset = segments.segmentBytes + (off_t)sizeof(header);
+
+    segments.segmentBytes += (off_t)(sizeof(header) + length);
+    segments.segmentBlocks++;
+    summary->rowCount = 0;
+    return 1;
+}
+
+int sealedRowCount() {
+    return segments.sealedRows;
+}
+
+int sealTransaction(int row, const Transaction *txn) {
+    SealedBlock *summary = &segments.pendingSummary;
+    if (!segments.open || row < segments.sealedRows) return 0;
+
+    // A full block, or a gap in the rows, ends the pending block
+    if ((summary->rowCount == HISTORY_BLOCK_ROWS ||
+         (summary->rowCount > 0 && row != summary->firstRow + summary->rowCount)) && !appendPendingBlock()) {
+        return 0;
+    }
+
+    int i = summary->rowCount++;
+    if (i == 0) {
+        summary->firstRow = row;
+        summary->minTime = summary->maxTime = (int64_t)txn->timestamp;
+        summary->minTxnId = summary->maxTxnId = txn->txnId;
+        summary->minAccNo = summary->maxAccNo = txn->accNo;
+        summary->segment = SEGMENT_PENDING;
+    } else {
+        if ((int64_t)txn->timestamp < summary->minTime) summary->minTime = (int64_t)txn->timestamp;
+        if ((int64_t)txn->timestamp > summary->maxTime) summary->maxTime = (int64_t)txn->timestamp;
+        if (txn->txnId < summary->minTxnId) summary->minTxnId = txn->txnId;
+        if (txn->txnId > summary->maxTxnId) summary->maxTxnId = txn->txnId;
+        if (txn->accNo < summary->minAccNo) summary->minAccNo = txn->accNo;
+        if (txn->accNo > summary->maxAccNo) summary->maxAccNo = txn->accNo;
+    }
+
+    TransactionColumns *pending = &segments.pending;
+    pending->txnIds[i] = txn->txnId;
+    pending->accNos[i] = txn->accNo;
+    pending->amounts[i] = txn->amount;
+    pending->timestamps[i] = (int64_t)txn->timestamp;
+    pending->alertMasks[i] = txn->alertMask;
+    pending->riskScores[i] = txn->riskScore;
+    pending->statuses[i] = txn->status;
+    pending->types[i] = txn->type;
+    pending->locations[i] = txn->location;
+    pending->ruleVersions[i] = txn->ruleVersion;
+    segments.sealedRows = row + 1;
+    return 1;
+}
+
+int flushHistorySegments() {
+    if (!segments.open) return 1;
+    if (!appendPendingBlock()) return 0;
+    return segments.fd < 0 || fdatasync(segments.fd) == 0;
+}
+
+void closeHistorySegments() {
+    if (segments.open && !flushHistorySegments()) {
+        fprintf(stderr, "Warning: Could not flush history segments\n");
+    }
+    if (segments.fd >= 0) close(segments.fd);
+    freeSegmentReader(&sharedReader);
+
+    free(segments.blocks);
+    segments.blocks = NULL;
+    segments.blockCount = segments.blockCapacity = 0;
+    segments.sealedRows = 0;
+    segments.fd = -1;
+    segments.segment = 0;
+    segments.segmentBlocks = 0;
+    segments.pendingSummary.rowCount = 0;
+    segments.open = 0;
+}
+
+// ==================== READING ====================
+
+int sealedBlockCount() {
+    return segments.blockCount + (segments.pendingSummary.rowCount > 0);
+}
+
+const SealedBlock *sealedBlock(int block) {
+    return (block < segments.blockCount) ? &segments.blocks[block] : &segments.pendingSummary;
+}
+
+int findSealedBlock(int row) {
+    int low = 0;
+    int high = sealedBlockCount();
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (sealedBlock(middle)->firstRow <= row) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low - 1;
+}
+
+void initSegmentReader(SegmentReader *reader) {
+    memset(reader, 0, sizeof(*reader));
+    reader->block = -1;
+    reader->segment = -1;
+    reader->fd = -1;
+}
+
+void freeSegmentReader(SegmentReader *reader) {
+    if (reader->fd >= 0) close(reader->fd);
+    free(reader->columns.amounts);
+    free(reader->payload);
+    initSegmentReader(reader);
+}
+
+static int readPayload(SegmentReader *reader, const SealedBlock *summary) {
+    if (reader->segment != summary->segment) {
+        if (reader->fd >= 0) close(reader->fd);
+        char path[SEGMENT_PATH_MAX];
+        reader->fd = segmentPath(path, summary->segment) ? open(path, O_RDONLY) : -1;
+        reader->segment = (reader->fd >= 0) ? summary->segment : -1;
+        if (reader->fd < 0) return 0;
+    }
+
+    if (summary->payloadLength > reader->payloadCapacity) {
+        uint8_t *grown = realloc(reader->payload, summary->payloadLength);
+        if (!grown) return 0;
+        reader->payload = grown;
+        reader->payloadCapacity = summary->payloadLength;
+    }
+    return pread(reader->fd, reader->payload, summary->payloadLength, summary->offset) == (ssize_t)summary->payloadLength &&
+           snapshotChecksum(reader->payload, summary->payloadLength) == summary->checksum;
+}
+
+const TransactionColumns *readSealedBlock(SegmentReader *reader, int block) {
+    if (!reader) reader = &sharedReader;
+    if (block < 0 || block >= sealedBlockCount()) return NULL;
+    if (block == segments.blockCount) return &segments.pending;
+    if (reader->block == block) return &reader->columns;
+
+    const SealedBlock *summary = &segments.blocks[block];
+    if (!reader->columns.amounts && !allocBlockColumns(&reader->columns)) return NULL;
+    reader->block = -1;
+    if (!readPayload(reader, summary) ||
+        !decodeBlock(reader->payload, reader->payload + summary->payloadLength, summary, &reader->columns)) {
+        fprintf(stderr, "Warning: History block at row %d is unreadable\n", summary->firstRow);
+        return NULL;
+    }
+    reader->block = block;
+    return &reader->columns;
+}
+
+int readSealedTransaction(SegmentReader *reader, int row, Transaction *txn) {
+    int block = findSealedBlock(row);
+    const TransactionColumns *columns = NULL;
+    if (block >= 0 && row < sealedBlock(block)->firstRow + sealedBlock(block)->rowCount) {
+        columns = readSealedBlock(reader, block);
+    }
+    if (!columns) {
+        memset(txn, 0, sizeof(*txn));
+        return 0;
+    }
+
+    int i = row - sealedBlock(block)->firstRow;
+    txn->txnId = columns->txnIds[i];
+    txn->accNo = columns->accNos[i];
+    txn->amount = columns->amounts[i];
+    txn->timestamp = (time_t)columns->timestamps[i];
+    txn->alertMask = columns->alertMasks[i];
+    txn->riskScore = columns->riskScores[i];
+    txn->status = columns->statuses[i];
+    txn->type = columns->types[i];
+    txn->location = columns->locations[i];
+    txn->ruleVersion = columns->ruleVersions[i];
+    return 1;
+}
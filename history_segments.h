@@ -0,0 +1,120 @@
+/**
+ * History Segments for Fraud Detection System
+ * Cold tier of the transaction history: rows evicted from memory are
+ * sealed into immutable, block-compressed segment files on disk
+ *
+ * File layout: SegmentFileHeader, then blocks of
+ *   SegmentBlockHeader | payload
+ * The payload holds up to HISTORY_BLOCK_ROWS rows column by column:
+ * timestamps and txnIds as zigzag varint deltas, accNos as varints above
+ * the block minimum, amounts as zigzag varint cents (or a raw double when
+ * cents would not round-trip), alert masks as varints, one byte each for
+ * risk score and status/type, locations as varint indexes into a
+ * dictionary of the block's location names (LocationIds are not stable
+ * across runs), and rule versions XORed with the previous row's. Block
+ * headers carry the row range and the min/max of timestamp, txnId and
+ * accNo; they are read into memory on open and let queries skip blocks
+ * that cannot match without touching the payload.
+ *
+ * Blocks are appended to the newest segment and checksummed one by one,
+ * so a torn tail is cut back to the last whole block. A segment that
+ * reaches SEGMENT_MAX_BLOCKS is closed and never written again.
+ */
+
+#ifndef HISTORY_SEGMENTS_H
+#define HISTORY_SEGMENTS_H
+
+#include <stdint.h>
+#include "transaction_log.h"
+#include "history_index.h"
+
+#define DATA_DIR_SEGMENTS "data/history"
+#define SEGMENT_MAX_BLOCKS 256          // blocks per segment file before the next is started
+
+// In-memory summary of one sealed block
+typedef struct {
+    int firstRow;
+    int rowCount;
+    int64_t minTime;
+    int64_t maxTime;
+    int minTxnId;
+    int maxTxnId;
+    int minAccNo;
+    int maxAccNo;
+    int segment;                // file number, or SEGMENT_PENDING
+    uint32_t payloadLength;
+    uint32_t checksum;          // CRC32C of the payload
+    int64_t offset;             // of the payload within the segment file
+} SealedBlock;
+
+// Rows sealed but not yet encoded; readable like any other block
+#define SEGMENT_PENDING -1
+
+// Decoded copy of one block plus an open segment file; one per thread
+typedef struct {
+    TransactionColumns columns;     // HISTORY_BLOCK_ROWS rows each
+    int block;                      // decoded block, -1 for none
+    int segment;                    // segment fd belongs to, -1 for none
+    int fd;
+    uint8_t *payload;
+    size_t payloadCapacity;
+} SegmentReader;
+
+/**
+ * Load the block summaries of every segment in directory (creating it if
+ * needed) and open the newest one for appending. A torn last block is
+ * truncated away. Returns 0 if the directory cannot be used; the history
+ * then stays in memory only.
+ */
+int openHistorySegments(const char *directory);
+void closeHistorySegments();
+
+/**
+ * Rows below this are in the cold tier (on disk or pending)
+ */
+int sealedRowCount();
+
+/**
+ * Add the transaction at `row` to the cold tier. Rows must arrive in
+ * order; the first may start past sealedRowCount() after history was lost.
+ * Full blocks are encoded and appended at once; nothing is synced.
+ * Returns 0, leaving the row unsealed, if a full block cannot be written.
+ */
+int sealTransaction(int row, const Transaction *txn);
+
+/**
+ * Encode the pending rows as a (possibly short) block and fdatasync the
+ * open segment, so every sealed row survives a crash. Must run before
+ * anything that drops sealed rows from the JSON files or the snapshot.
+ */
+int flushHistorySegments();
+
+/**
+ * Blocks in row order; the pending block, if any, is the last one
+ */
+int sealedBlockCount();
+const SealedBlock *sealedBlock(int block);
+
+/**
+ * Index of the last block starting at or before row (which may end
+ * before it if rows were lost), or -1 if there is none
+ */
+int findSealedBlock(int row);
+
+void initSegmentReader(SegmentReader *reader);
+void freeSegmentReader(SegmentReader *reader);
+
+/**
+ * Decoded columns of block (rows 0 .. rowCount - 1), valid until the next
+ * call with the same reader or the next seal. NULL if the block cannot be
+ * read or fails its checksum. A NULL reader uses the one shared by the
+ * serve thread.
+ */
+const TransactionColumns *readSealedBlock(SegmentReader *reader, int block);
+
+/**
+ * Gather one cold row. Returns 0 (txn zeroed) if no readable block holds it.
+ */
+int readSealedTransaction(SegmentReader *reader, int row, Transaction *txn);
+
+#endif
@@ -0,0 +1,265 @@
+/**
+ * Transaction Journal for Fraud Detection System
+ * Append-only, checksummed write-ahead log of transactions and balances
+ *
+ * File layout: JournalFileHeader, then records of
+ *   uint32 payloadLength | uint32 crc32(payload) | payload
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "journal.h"
+#include "account_store.h"
+#include "fraud_engine.h"
+#include "location_table.h"
+#include "data_manager.h"
+#include "metrics.h"
+#include "util.h"
+
+#define JOURNAL_MAGIC 0x4C4E524Au     // "JRNL"
+#define JOURNAL_VERSION 1
+#define JOURNAL_RECORD_TXN 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} JournalFileHeader;
+
+typedef struct {
+    uint32_t length;
+    uint32_t checksum;
+} JournalRecordHeader;
+
+typedef struct {
+    uint8_t recordType;
+    uint8_t status;
+    uint8_t type;
+    uint8_t riskScore;
+    int32_t txnId;
+    int32_t accNo;
+    uint32_t alertMask;
+    int64_t timestamp;
+    double amount;
+    double balanceAfter;
+    char location[30];
+    uint32_t ruleVersion;       // appended; older records end before it
+} JournalTxnRecord;
+
+// Shortest payload replay accepts: records written before ruleVersion
+#define JOURNAL_TXN_MIN_LENGTH offsetof(JournalTxnRecord, ruleVersion)
+
+static int journalFd = -1;
+static long journalBytes = 0;
+static char *pendingData = NULL;
+static size_t pendingSize = 0;
+static size_t pendingCapacity = 0;
+
+static uint32_t crcTable[256];
+
+static void initCrcTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[i] = c;
+    }
+}
+
+static uint32_t crc32(const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    uint32_t c = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < length; i++) {
+        c = crcTable[(c ^ bytes[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+int openJournal(const char *path) {
+    initCrcTable();
+
+    journalFd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (journalFd < 0) {
+        fprintf(stderr, "Warning: Could not open journal %s\n", path);
+        return 0;
+    }
+
+    struct stat st;
+    fstat(journalFd, &st);
+    journalBytes = st.st_size;
+
+    if (journalBytes == 0) {
+        JournalFileHeader header = {JOURNAL_MAGIC, JOURNAL_VERSION};
+        if (!writeAll(journalFd, &header, sizeof(header)) || fdatasync(journalFd) != 0) {
+            fprintf(stderr, "Error: Could not initialize journal\n");
+            return 0;
+        }
+        journalBytes = sizeof(header);
+    }
+    return 1;
+}
+
+void closeJournal() {
+    journalCommit();
+    if (journalFd >= 0) close(journalFd);
+    journalFd = -1;
+    free(pendingData);
+    pendingData = NULL;
+    pendingSize = pendingCapacity = 0;
+}
+
+static void applyTxnRecord(const JournalTxnRecord *record, int foldedThrough) {
+    // Already folded into transactions.json by an earlier compaction
+    if (record->txnId <= foldedThrough) return;
+
+    Transaction txn = {0};
+    txn.txnId = record->txnId;
+    txn.accNo = record->accNo;
+    txn.amount = record->amount;
+    txn.timestamp = (time_t)record->timestamp;
+    txn.alertMask = record->alertMask;
+    txn.riskScore = record->riskScore;
+    txn.status = record->status;
+    txn.type = record->type;
+    txn.location = internLocationN(record->location, strnlen(record->location, sizeof(record->location)));
+    txn.ruleVersion = record->ruleVersion;
+    storeTransaction(&txn);
+
+    Account *account = findAccount(&accountStore, txn.accNo);
+    if (account) {
+        account->balance = record->balanceAfter;
+        recordSpending(account, txn.timestamp, txn.amount);
+        recordAccountActivity(account, &txn);
+    }
+}
+
+int replayJournal() {
+    if (journalFd < 0) return -1;
+
+    JournalFileHeader header;
+    if (pread(journalFd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION) {
+        fprintf(stderr, "Error: Journal header is missing or has an unknown version\n");
+        return -1;
+    }
+
+    off_t offset = sizeof(header);
+    int applied = 0;
+
+    // Concurrent workers number transactions before they are journaled, so
+    // IDs are unique but not in journal order; compare against the loaded
+    // history only, not the records replayed so far
+    int foldedThrough = lastTxnId;
+
+    while (offset < journalBytes) {
+        JournalRecordHeader recordHeader;
+        JournalTxnRecord record;
+        memset(&record, 0, sizeof(record));
+
+        if (pread(journalFd, &recordHeader, sizeof(recordHeader), offset) != sizeof(recordHeader) ||
+            recordHeader.length < JOURNAL_TXN_MIN_LENGTH || recordHeader.length > sizeof(record) ||
+            pread(journalFd, &record, recordHeader.length, offset + sizeof(recordHeader)) != recordHeader.length ||
+            crc32(&record, recordHeader.length) != recordHeader.checksum) {
+            break;
+        }
+
+        if (record.recordType == JOURNAL_RECORD_TXN) {
+            applyTxnRecord(&record, foldedThrough);
+            applied++;
+        }
+        offset += sizeof(recordHeader) + recordHeader.length;
+    }
+
+    // Drop a torn write so new appends are not hidden behind it
+    if (offset < journalBytes) {
+        fprintf(stderr, "Warning: Discarding %ld bytes of incomplete journal tail\n",
+                (long)(journalBytes - offset));
+        if (ftruncate(journalFd, offset) != 0) return -1;
+        journalBytes = offset;
+    }
+
+    fprintf(stderr, "Replayed %d journal records\n", applied);
+    return applied;
+}
+
+int journalAppendTransaction(const Transaction *txn, double balanceAfter) {
+    if (journalFd < 0) return 0;
+
+    JournalTxnRecord record;
+    memset(&record, 0, sizeof(record));
+    record.recordType = JOURNAL_RECORD_TXN;
+    record.status = txn->status;
+    record.type = txn->type;
+    record.riskScore = txn->riskScore;
+    record.txnId = txn->txnId;
+    record.accNo = txn->accNo;
+    record.alertMask = txn->alertMask;
+    record.timestamp = (int64_t)txn->timestamp;
+    record.amount = txn->amount;
+    record.balanceAfter = balanceAfter;
+    record.ruleVersion = txn->ruleVersion;
+    strncpy(record.location, locationName(txn->location), sizeof(record.location) - 1);
+
+    JournalRecordHeader recordHeader = {sizeof(record), crc32(&record, sizeof(record))};
+    size_t needed = pendingSize + sizeof(recordHeader) + sizeof(record);
+
+    if (needed > pendingCapacity) {
+        size_t newCapacity = pendingCapacity ? pendingCapacity * 2 : 4096;
+        while (newCapacity < needed) newCapacity *= 2;
+        char *grown = realloc(pendingData, newCapacity);
+        if (!grown) return 0;
+        pendingData = grown;
+        pendingCapacity = newCapacity;
+    }
+
+    memcpy(pendingData + pendingSize, &recordHeader, sizeof(recordHeader));
+    memcpy(pendingData + pendingSize + sizeof(recordHeader), &record, sizeof(record));
+    pendingSize = needed;
+    METRICS_SET_GAUGE(GAUGE_JOURNAL_PENDING_BYTES, pendingSize);
+    return 1;
+}
+
+int journalCommit() {
+    if (journalFd < 0 || pendingSize == 0) return 1;
+
+    if (!writeAll(journalFd, pendingData, pendingSize) || fdatasync(journalFd) != 0) {
+        fprintf(stderr, "Error: Journal commit failed\n");
+        return 0;
+    }
+
+    journalBytes += (long)pendingSize;
+    pendingSize = 0;
+    METRICS_SET_GAUGE(GAUGE_JOURNAL_PENDING_BYTES, 0);
+    return 1;
+}
+
+long journalSize() {
+    return journalBytes;
+}
+
+int compactJournal() {
+    if (!journalCommit()) return 0;
+
+    // JSON files are replaced atomically; the journal is only cut after both land
+    if (!saveTransactionsToFile() || !saveAccountsToFile()) {
+        fprintf(stderr, "Error: Compaction failed, keeping journal\n");
+        return 0;
+    }
+
+    if (journalFd >= 0) {
+        if (ftruncate(journalFd, sizeof(JournalFileHeader)) != 0 || fdatasync(journalFd) != 0) {
+            return 0;
+        }
+        journalBytes = sizeof(JournalFileHeader);
+    }
+
+    fprintf(stderr, "Journal compacted into JSON files\n");
+    return 1;
+}
@@ -0,0 +1,48 @@
+/**
+ * Transaction Journal for Fraud Detection System
+ * Append-only, checksummed write-ahead log of transactions and balances
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "transaction_log.h"
+
+#define DATA_FILE_JOURNAL "data/transactions.journal"
+
+// Compact back into the JSON files once the journal grows past this
+#define JOURNAL_COMPACT_BYTES (8L * 1024 * 1024)
+
+/**
+ * Open (creating if needed) the journal for appending
+ */
+int openJournal(const char *path);
+void closeJournal();
+
+/**
+ * Apply journal records newer than the loaded JSON snapshot to the
+ * in-memory stores. A torn or corrupt tail is truncated away.
+ * Returns the number of records applied, or -1 on error.
+ */
+int replayJournal();
+
+/**
+ * Queue a transaction and the account balance it left behind.
+ * Nothing reaches disk until journalCommit().
+ */
+int journalAppendTransaction(const Transaction *txn, double balanceAfter);
+
+/**
+ * Group commit: one write and one fdatasync for everything queued
+ */
+int journalCommit();
+
+long journalSize();
+
+/**
+ * Fold the journal into data/accounts.json and data/transactions.json,
+ * then truncate it
+ */
+int compactJournal();
+
+#endif
@@ -0,0 +1,372 @@
+/**
+ * Streaming JSON Reader for Fraud Detection System
+ * Pull tokenizer over an mmap'd file: no DOM, no per-value allocation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "json_stream.h"
+
+int jsonOpenFile(JsonStream *stream, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *data = NULL;
+    if (st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        // Pages are read once, front to back
+        madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    jsonOpenBuffer(stream, data, (size_t)st.st_size);
+    stream->mapped = (data != NULL);
+    return 1;
+}
+
+void jsonOpenBuffer(JsonStream *stream, const char *data, size_t size) {
+    stream->data = data;
+    stream->pos = data;
+    stream->end = data + size;
+    stream->size = size;
+    stream->mapped = 0;
+    stream->depth = 0;
+    stream->expectKey = 0;
+}
+
+void jsonClose(JsonStream *stream) {
+    if (stream->mapped) {
+        munmap((void *)stream->data, stream->size);
+    }
+    stream->data = stream->pos = stream->end = NULL;
+    stream->mapped = 0;
+}
+
+static void appendUtf8(char **out, const char *limit, unsigned codepoint) {
+    char bytes[4];
+    int n;
+
+    if (codepoint < 0x80) {
+        bytes[0] = (char)codepoint; n = 1;
+    } else if (codepoint < 0x800) {
+        bytes[0] = (char)(0xC0 | (codepoint >> 6));
+        bytes[1] = (char)(0x80 | (codepoint & 0x3F)); n = 2;
+    } else if (codepoint < 0x10000) {
+        bytes[0] = (char)(0xE0 | (codepoint >> 12));
+        bytes[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        bytes[2] = (char)(0x80 | (codepoint & 0x3F)); n = 3;
+    } else {
+        bytes[0] = (char)(0xF0 | (codepoint >> 18));
+        bytes[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        bytes[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        bytes[3] = (char)(0x80 | (codepoint & 0x3F)); n = 4;
+    }
+
+    if (*out + n > limit) return;
+    memcpy(*out, bytes, (size_t)n);
+    *out += n;
+}
+
+static int parseHex4(const char *p, const char *end, unsigned *value) {
+    if (end - p < 4) return 0;
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        *value <<= 4;
+        if (c >= '0' && c <= '9') *value |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') *value |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') *value |= (unsigned)(c - 'A' + 10);
+        else return 0;
+    }
+    return 1;
+}
+
+static int parseString(JsonStream *stream, JsonToken *token) {
+    const char *start = ++stream->pos;
+    const char *p = start;
+
+    // Fast path: no escapes, hand out a pointer into the file
+    while (p < stream->end && *p != '"' && *p != '\\') p++;
+    if (p >= stream->end) return 0;
+    if (*p == '"') {
+        token->text = start;
+        token->length = (size_t)(p - start);
+        stream->pos = p + 1;
+        return 1;
+    }
+
+    // Slow path: decode into the scratch buffer (truncating very long strings)
+    char *out = stream->scratch;
+    const char *limit = stream->scratch + sizeof(stream->scratch) - 1;
+    size_t prefix = (size_t)(p - start);
+    if (prefix > (size_t)(limit - out)) prefix = (size_t)(limit - out);
+    memcpy(out, start, prefix);
+    out += prefix;
+
+    while (p < stream->end && *p != '"') {
+        if (*p != '\\') {
+            if (out < limit) *out++ = *p;
+            p++;
+            continue;
+        }
+        if (++p >= stream->end) return 0;
+
+        char c = *p++;
+        unsigned codepoint;
+        switch (c) {
+            case 'b': codepoint = '\b'; break;
+            case 'f': codepoint = '\f'; break;
+            case 'n': codepoint = '\n'; break;
+            case 'r': codepoint = '\r'; break;
+            case 't': codepoint = '\t'; break;
+            case 'u':
+                if (!parseHex4(p, stream->end, &codepoint)) return 0;
+                p += 4;
+                if (codepoint >= 0xD800 && codepoint < 0xDC00 &&
+                    stream->end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    unsigned low;
+                    if (parseHex4(p + 2, stream->end, &low) && low >= 0xDC00 && low < 0xE000) {
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                break;
+            default: codepoint = (unsigned char)c; break;
+        }
+        appendUtf8(&out, limit, codepoint);
+    }
+    if (p >= stream->end) return 0;
+
+    *out = '\0';
+    token->text = stream->scratch;
+    token->length = (size_t)(out - stream->scratch);
+    stream->pos = p + 1;
+    return 1;
+}
+
+static int isNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static int parseNumber(JsonStream *stream, JsonToken *token) {
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+    };
+    const char *start = stream->pos;
+    const char *p = start;
+
+    // Fast path: up to 15 significant digits and no exponent. Both the
+    // mantissa and the power of ten are exact doubles, so one division
+    // rounds exactly like strtod would.
+    int negative = (*p == '-');
+    if (negative) p++;
+    unsigned long long mantissa = 0;
+    int digits = 0, fractionDigits = 0, seenPoint = 0;
+    while (p < stream->end) {
+        if (*p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+            digits++;
+            fractionDigits += seenPoint;
+        } else if (*p == '.' && !seenPoint) {
+            seenPoint = 1;
+        } else {
+            break;
+        }
+        p++;
+    }
+
+    if (digits > 0 && digits <= 15 && (p >= stream->end || !isNumberChar(*p))) {
+        double value = (double)mantissa / powersOfTen[fractionDigits];
+        token->number = negative ? -value : value;
+    } else {
+        while (p < stream->end && isNumberChar(*p)) p++;
+
+        char buffer[64];
+        size_t length = (size_t)(p - start);
+        if (length == 0 || length >= sizeof(buffer)) return 0;
+        memcpy(buffer, start, length);
+        buffer[length] = '\0';
+
+        char *parsedEnd;
+        token->number = strtod(buffer, &parsedEnd);
+        if (parsedEnd != buffer + length) return 0;
+    }
+
+    token->text = start;
+    token->length = (size_t)(p - start);
+    stream->pos = p;
+    return 1;
+}
+
+static int parseLiteral(JsonStream *stream, const char *literal, JsonTokenType type, JsonToken *token) {
+    size_t length = strlen(literal);
+    if ((size_t)(stream->end - stream->pos) < length || memcmp(stream->pos, literal, length) != 0) {
+        return 0;
+    }
+    token->type = type;
+    token->text = stream->pos;
+    token->length = length;
+    stream->pos += length;
+    return 1;
+}
+
+int jsonNext(JsonStream *stream, JsonToken *token) {
+    for (;;) {
+        while (stream->pos < stream->end &&
+               (*stream->pos == ' ' || *stream->pos == '\n' || *stream->pos == '\r' || *stream->pos == '\t')) {
+            stream->pos++;
+        }
+        if (stream->pos >= stream->end) {
+            token->type = (stream->depth == 0) ? JSON_TOKEN_END : JSON_TOKEN_ERROR;
+            return 0;
+        }
+
+        char c = *stream->pos;
+        int inObject = (stream->depth > 0 && stream->containers[stream->depth - 1] == '{');
+
+        switch (c) {
+            case ',':
+                stream->pos++;
+                stream->expectKey = inObject;
+                continue;
+            case ':':
+                stream->pos++;
+                continue;
+            case '{':
+            case '[':
+                if (stream->depth >= JSON_MAX_DEPTH) break;
+                stream->containers[stream->depth++] = c;
+                stream->expectKey = (c == '{');
+                stream->pos++;
+                token->type = (c == '{') ? JSON_TOKEN_OBJECT_BEGIN : JSON_TOKEN_ARRAY_BEGIN;
+                return 1;
+            case '}':
+            case ']':
+                if (stream->depth == 0) break;
+                stream->depth--;
+                stream->expectKey = 0;
+                stream->pos++;
+                token->type = (c == '}') ? JSON_TOKEN_OBJECT_END : JSON_TOKEN_ARRAY_END;
+                return 1;
+            case '"':
+                if (!parseString(stream, token)) break;
+                token->type = stream->expectKey ? JSON_TOKEN_KEY : JSON_TOKEN_STRING;
+                stream->expectKey = 0;
+                return 1;
+            case 't':
+                if (parseLiteral(stream, "true", JSON_TOKEN_TRUE, token)) return 1;
+                break;
+            case 'f':
+                if (parseLiteral(stream, "false", JSON_TOKEN_FALSE, token)) return 1;
+                break;
+            case 'n':
+                if (parseLiteral(stream, "null", JSON_TOKEN_NULL, token)) return 1;
+                break;
+            default:
+                if ((c >= '0' && c <= '9') || c == '-') {
+                    if (!parseNumber(stream, token)) break;
+                    token->type = JSON_TOKEN_NUMBER;
+                    return 1;
+                }
+                break;
+        }
+
+        token->type = JSON_TOKEN_ERROR;
+        return 0;
+    }
+}
+
+int jsonSkipValue(JsonStream *stream, const JsonToken *first) {
+    if (first->type != JSON_TOKEN_OBJECT_BEGIN && first->type != JSON_TOKEN_ARRAY_BEGIN) {
+        return 1;
+    }
+
+    int targetDepth = stream->depth - 1;
+    JsonToken token;
+    while (stream->depth > targetDepth) {
+        if (!jsonNext(stream, &token)) return 0;
+    }
+    return 1;
+}
+
+int jsonFindMember(JsonStream *stream, const char *key, JsonToken *value) {
+    JsonToken token;
+
+    while (jsonNext(stream, &token) && token.type == JSON_TOKEN_KEY) {
+        int match = jsonTokenIs(&token, key);
+        if (!jsonNext(stream, value)) return 0;
+        if (match) return 1;
+        if (!jsonSkipValue(stream, value)) return 0;
+    }
+    return 0;
+}
+
+void jsonCopyString(const JsonToken *token, char *dest, size_t destSize) {
+    if (destSize == 0) return;
+    if (token->type != JSON_TOKEN_STRING) {
+        dest[0] = '\0';
+        return;
+    }
+
+    size_t length = (token->length < destSize - 1) ? token->length : destSize - 1;
+    memcpy(dest, token->text, length);
+    dest[length] = '\0';
+}
+
+static int parseDigits(const char *p, int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+/**
+ * Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant)
+ */
+static long daysFromCivil(int year, int month, int day) {
+    year -= (month <= 2);
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+int jsonParseTimestamp(const JsonToken *token, time_t *result) {
+    const char *p = token->text;
+    if (token->type != JSON_TOKEN_STRING || token->length < 19 ||
+        p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':') {
+        return 0;
+    }
+
+    int year = parseDigits(p, 4);
+    int month = parseDigits(p + 5, 2);
+    int day = parseDigits(p + 8, 2);
+    int hour = parseDigits(p + 11, 2);
+    int minute = parseDigits(p + 14, 2);
+    int second = parseDigits(p + 17, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60) {
+        return 0;
+    }
+
+    *result = (time_t)(daysFromCivil(year, month, day) * 86400L + hour * 3600L + minute * 60L + second);
+    return 1;
+}
@@ -0,0 +1,91 @@
+/**
+ * Streaming JSON Reader for Fraud Detection System
+ * Pull tokenizer over an mmap'd file: no DOM, no per-value allocation
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define JSON_MAX_DEPTH 64
+#define JSON_SCRATCH_SIZE 1024
+
+typedef enum {
+    JSON_TOKEN_END = 0,
+    JSON_TOKEN_ERROR,
+    JSON_TOKEN_OBJECT_BEGIN,
+    JSON_TOKEN_OBJECT_END,
+    JSON_TOKEN_ARRAY_BEGIN,
+    JSON_TOKEN_ARRAY_END,
+    JSON_TOKEN_KEY,
+    JSON_TOKEN_STRING,
+    JSON_TOKEN_NUMBER,
+    JSON_TOKEN_TRUE,
+    JSON_TOKEN_FALSE,
+    JSON_TOKEN_NULL
+} JsonTokenType;
+
+// Strings point into the mapped file (or the stream's scratch buffer when
+// they contained escapes) and are valid only until the next jsonNext().
+typedef struct {
+    JsonTokenType type;
+    const char *text;
+    size_t length;
+    double number;
+} JsonToken;
+
+typedef struct {
+    const char *data;
+    const char *pos;
+    const char *end;
+    size_t size;
+    int mapped;
+    char containers[JSON_MAX_DEPTH];
+    int depth;
+    int expectKey;
+    char scratch[JSON_SCRATCH_SIZE];
+} JsonStream;
+
+/**
+ * Map a file read-only for sequential streaming. Returns 0 on failure.
+ */
+int jsonOpenFile(JsonStream *stream, const char *path);
+void jsonOpenBuffer(JsonStream *stream, const char *data, size_t size);
+void jsonClose(JsonStream *stream);
+
+/**
+ * Advance to the next token. Returns 0 at end of input or on error.
+ */
+int jsonNext(JsonStream *stream, JsonToken *token);
+
+/**
+ * Skip the value that starts with `first` (nested containers included)
+ */
+int jsonSkipValue(JsonStream *stream, const JsonToken *first);
+
+/**
+ * Within the object just opened, skip members until `key` and read the
+ * first token of its value. Returns 0 if the object ends first.
+ */
+int jsonFindMember(JsonStream *stream, const char *key, JsonToken *value);
+
+// Inline so strlen() of a literal key folds to a constant
+static inline int jsonTokenIs(const JsonToken *token, const char *text) {
+    size_t length = strlen(text);
+    return token->length == length && memcmp(token->text, text, length) == 0;
+}
+
+/**
+ * Copy a string token into a fixed buffer, truncating if necessary
+ */
+void jsonCopyString(const JsonToken *token, char *dest, size_t destSize);
+
+/**
+ * Parse "YYYY-MM-DDTHH:MM:SSZ" as UTC without strptime/mktime
+ */
+int jsonParseTimestamp(const JsonToken *token, time_t *result);
+
+#endif
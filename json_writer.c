@@ -0,0 +1,231 @@
+/**
+ * JSON Writer for Fraud Detection System
+ * Growable output buffer with escaping and printf-free number formatting,
+ * flushed to a file descriptor in large single write() calls
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "json_writer.h"
+
+#define JSON_WRITER_INITIAL_CAPACITY 4096
+
+void jsonWriterInit(JsonWriter *writer, int fd) {
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = fd;
+    writer->cachedDay = -1;
+}
+
+void jsonWriterFree(JsonWriter *writer) {
+    free(writer->data);
+    writer->data = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+}
+
+/**
+ * Make room for `needed` more bytes. Returns NULL (and marks the writer
+ * failed) if the buffer cannot grow.
+ */
+static inline char *reserve(JsonWriter *writer, size_t needed) {
+    if (writer->length + needed > writer->capacity) {
+        size_t capacity = writer->capacity ? writer->capacity : JSON_WRITER_INITIAL_CAPACITY;
+        while (capacity < writer->length + needed) capacity *= 2;
+        char *grown = realloc(writer->data, capacity);
+        if (!grown) {
+            writer->failed = 1;
+            return NULL;
+        }
+        writer->data = grown;
+        writer->capacity = capacity;
+    }
+    return writer->data + writer->length;
+}
+
+int jsonWriterFlush(JsonWriter *writer) {
+    size_t written = 0;
+
+    while (writer->fd >= 0 && written < writer->length) {
+        ssize_t n = write(writer->fd, writer->data + written, writer->length - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            writer->failed = 1;
+            break;
+        }
+        written += (size_t)n;
+    }
+
+    int ok = !writer->failed;
+    writer->length = 0;
+    writer->failed = 0;
+    return ok;
+}
+
+void jsonWriteRaw(JsonWriter *writer, const char *text, size_t length) {
+    char *dest = reserve(writer, length);
+    if (!dest) return;
+    memcpy(dest, text, length);
+    writer->length += length;
+}
+
+void jsonWriteStringN(JsonWriter *writer, const char *text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+
+    // Worst case every byte becomes a six-byte \u00XX escape
+    char *dest = reserve(writer, length * 6 + 2);
+    if (!dest) return;
+    char *p = dest;
+
+    *p++ = '"';
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            *p++ = (char)c;
+            continue;
+        }
+        *p++ = '\\';
+        switch (c) {
+            case '"': *p++ = '"'; break;
+            case '\\': *p++ = '\\'; break;
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            default:
+                *p++ = 'u';
+                *p++ = '0';
+                *p++ = '0';
+                *p++ = hex[c >> 4];
+                *p++ = hex[c & 15];
+                break;
+        }
+    }
+    *p++ = '"';
+
+    writer->length += (size_t)(p - dest);
+}
+
+void jsonWriteString(JsonWriter *writer, const char *text) {
+    jsonWriteStringN(writer, text ? text : "", text ? strlen(text) : 0);
+}
+
+/**
+ * Digits of value, most significant first, into the end of buffer.
+ * Returns the start of the digits.
+ */
+static inline char *formatUnsigned(char *end, unsigned long long value) {
+    char *p = end;
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return p;
+}
+
+void jsonWriteInt(JsonWriter *writer, long value) {
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    unsigned long long magnitude = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    char *p = formatUnsigned(end, magnitude);
+    if (value < 0) *--p = '-';
+    jsonWriteRaw(writer, p, (size_t)(end - p));
+}
+
+void jsonWriteFixed2(JsonWriter *writer, double value) {
+    double scaled = value * 100.0;
+    double fraction = fabs(scaled - trunc(scaled));
+
+    // Hand the rare hard cases (huge, non-finite, exact half-cent ties
+    // and negative zero) to printf so output never differs from "%.2f"
+    if (!isfinite(value) || fabs(value) >= 1e13 || fabs(fraction - 0.5) < 1e-6 ||
+        (signbit(value) && llround(scaled) == 0)) {
+        char buffer[64];
+        int length = snprintf(buffer, sizeof(buffer), "%.2f", value);
+        jsonWriteRaw(writer, buffer, (size_t)length);
+        return;
+    }
+
+    long long cents = llround(scaled);
+    unsigned long long magnitude = (unsigned long long)(cents < 0 ? -cents : cents);
+    char buffer[32];
+    char *end = buffer + sizeof(buffer);
+    char *p = end;
+
+    *--p = (char)('0' + magnitude % 10);
+    *--p = (char)('0' + (magnitude / 10) % 10);
+    *--p = '.';
+    p = formatUnsigned(p, magnitude / 100);
+    if (cents < 0) *--p = '-';
+
+    jsonWriteRaw(writer, p, (size_t)(end - p));
+}
+
+void jsonWriteBool(JsonWriter *writer, int value) {
+    if (value) {
+        jsonWriteLiteral(writer, "true");
+    } else {
+        jsonWriteLiteral(writer, "false");
+    }
+}
+
+static inline void putTwoDigits(char *dest, int value) {
+    dest[0] = (char)('0' + value / 10);
+    dest[1] = (char)('0' + value % 10);
+}
+
+/**
+ * Civil date from days since 1970-01-01 (inverse of jsonParseTimestamp)
+ */
+static void civilFromDays(long days, int *year, int *month, int *day) {
+    days += 719468;
+    long era = (days >= 0 ? days : days - 146096) / 146097;
+    long dayOfEra = days - era * 146097;
+    long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long monthIndex = (5 * dayOfYear + 2) / 153;
+
+    *day = (int)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    *month = (int)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    *year = (int)(yearOfEra + era * 400 + (*month <= 2));
+}
+
+void jsonWriteTimestamp(JsonWriter *writer, time_t timestamp) {
+    long long t = (long long)timestamp;
+    long days = (long)(t >= 0 ? t / 86400 : (t - 86399) / 86400);
+    long seconds = (long)(t - (long long)days * 86400);
+
+    if (days != writer->cachedDay) {
+        int year, month, day;
+        civilFromDays(days, &year, &month, &day);
+        if (year < 0 || year > 9999) {
+            jsonWriteLiteral(writer, "\"1970-01-01T00:00:00Z\"");
+            return;
+        }
+        writer->cachedDate[0] = (char)('0' + year / 1000);
+        writer->cachedDate[1] = (char)('0' + (year / 100) % 10);
+        putTwoDigits(writer->cachedDate + 2, year % 100);
+        writer->cachedDate[4] = '-';
+        putTwoDigits(writer->cachedDate + 5, month);
+        writer->cachedDate[7] = '-';
+        putTwoDigits(writer->cachedDate + 8, day);
+        writer->cachedDay = days;
+    }
+
+    char *dest = reserve(writer, 22);
+    if (!dest) return;
+
+    dest[0] = '"';
+    memcpy(dest + 1, writer->cachedDate, 10);
+    dest[11] = 'T';
+    putTwoDigits(dest + 12, (int)(seconds / 3600));
+    dest[14] = ':';
+    putTwoDigits(dest + 15, (int)(seconds / 60 % 60));
+    dest[17] = ':';
+    putTwoDigits(dest + 18, (int)(seconds % 60));
+    dest[20] = 'Z';
+    dest[21] = '"';
+    writer->length += 22;
+}
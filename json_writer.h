@@ -0,0 +1,62 @@
+/**
+ * JSON Writer for Fraud Detection System
+ * Growable output buffer with escaping and printf-free number formatting,
+ * flushed to a file descriptor in large single write() calls
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <time.h>
+
+#define JSON_WRITER_CHUNK (256 * 1024)
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int fd;                     // flush target, -1 keeps everything in memory
+    int failed;                 // an allocation or write failed
+    long cachedDay;             // day number behind cachedDate
+    char cachedDate[11];        // "YYYY-MM-DD" for cachedDay
+} JsonWriter;
+
+void jsonWriterInit(JsonWriter *writer, int fd);
+void jsonWriterFree(JsonWriter *writer);
+
+/**
+ * Write all buffered bytes to the writer's fd and empty the buffer.
+ * Returns 0 if anything failed since the last flush.
+ */
+int jsonWriterFlush(JsonWriter *writer);
+
+// Exports call this between records to bound memory use
+static inline void jsonWriterFlushIfFull(JsonWriter *writer) {
+    if (writer->length >= JSON_WRITER_CHUNK) jsonWriterFlush(writer);
+}
+
+void jsonWriteRaw(JsonWriter *writer, const char *text, size_t length);
+#define jsonWriteLiteral(writer, text) jsonWriteRaw((writer), (text), sizeof(text) - 1)
+
+/**
+ * Quoted string with ", \ and control characters escaped
+ */
+void jsonWriteStringN(JsonWriter *writer, const char *text, size_t length);
+void jsonWriteString(JsonWriter *writer, const char *text);
+
+void jsonWriteInt(JsonWriter *writer, long value);
+
+/**
+ * Two decimal places, matching printf("%.2f")
+ */
+void jsonWriteFixed2(JsonWriter *writer, double value);
+
+void jsonWriteBool(JsonWriter *writer, int value);
+
+/**
+ * Quoted "YYYY-MM-DDTHH:MM:SSZ" (UTC); the date part is cached per day
+ */
+void jsonWriteTimestamp(JsonWriter *writer, time_t timestamp);
+
+#endif
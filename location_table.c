@@ -0,0 +1,223 @@
+/**
+ * Location Table for Fraud Detection System
+ * Interns city names to 2-byte IDs and precomputes minimum travel times
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "location_table.h"
+#include "json_stream.h"
+
+// Twice MAX_LOCATIONS rounded up to a power of two keeps probes short
+#define LOCATION_SLOT_COUNT 131072
+#define EARTH_RADIUS_KM 6371.0
+#define DEFAULT_TRAVEL_SPEED_KMH 900.0
+
+LocationTable locationTable;
+
+static pthread_mutex_t internLock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t hashLocationName(const char *name, size_t length) {
+    if (length > LOCATION_NAME_MAX) length = LOCATION_NAME_MAX;
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int nameMatches(const char *stored, const char *name, size_t length) {
+    return memcmp(stored, name, length) == 0 && stored[length] == '\0';
+}
+
+/**
+ * Probe for name; returns its ID, or LOCATION_NONE with *slotOut set to
+ * the empty slot where it would go
+ */
+static LocationId probeLocation(LocationId *slots, const char *name, size_t length, uint32_t *slotOut) {
+    uint32_t slot = (uint32_t)hashLocationName(name, length) & (LOCATION_SLOT_COUNT - 1);
+
+    for (;;) {
+        LocationId id = __atomic_load_n(&slots[slot], __ATOMIC_ACQUIRE);
+        if (id == LOCATION_NONE) break;
+        if (nameMatches(locationTable.locations[id].name, name, length)) return id;
+        slot = (slot + 1) & (LOCATION_SLOT_COUNT - 1);
+    }
+
+    if (slotOut) *slotOut = slot;
+    return LOCATION_NONE;
+}
+
+// Caller holds internLock
+static int ensureTable() {
+    if (locationTable.slots) return 1;
+
+    LocationInfo *locations = calloc((size_t)MAX_LOCATIONS + 1, sizeof(LocationInfo));
+    LocationId *slots = calloc(LOCATION_SLOT_COUNT, sizeof(LocationId));
+    if (!locations || !slots) {
+        free(locations);
+        free(slots);
+        return 0;
+    }
+
+    locations[LOCATION_NONE].name = "";
+    locationTable.locations = locations;
+    locationTable.count = 1;
+    if (locationTable.maxTravelSpeedKmh <= 0) locationTable.maxTravelSpeedKmh = DEFAULT_TRAVEL_SPEED_KMH;
+    __atomic_store_n(&locationTable.slots, slots, __ATOMIC_RELEASE);
+    return 1;
+}
+
+LocationId findLocationN(const char *name, size_t length) {
+    LocationId *slots = __atomic_load_n(&locationTable.slots, __ATOMIC_ACQUIRE);
+    if (length > LOCATION_NAME_MAX) length = LOCATION_NAME_MAX;
+    if (!slots || length == 0) return LOCATION_NONE;
+    return probeLocation(slots, name, length, NULL);
+}
+
+LocationId internLocationN(const char *name, size_t length) {
+    if (length > LOCATION_NAME_MAX) length = LOCATION_NAME_MAX;
+    if (length == 0) return LOCATION_NONE;
+
+    LocationId id = findLocationN(name, length);
+    if (id != LOCATION_NONE) return id;
+
+    pthread_mutex_lock(&internLock);
+
+    uint32_t slot = 0;
+    if (!ensureTable()) {
+        pthread_mutex_unlock(&internLock);
+        return LOCATION_NONE;
+    }
+
+    // Another thread may have added it since the lock-free lookup
+    id = probeLocation(locationTable.slots, name, length, &slot);
+    if (id == LOCATION_NONE && locationTable.count <= MAX_LOCATIONS - 1) {
+        char *copy = malloc(length + 1);
+        if (copy) {
+            memcpy(copy, name, length);
+            copy[length] = '\0';
+            id = (LocationId)locationTable.count++;
+            locationTable.locations[id].name = copy;
+            locationTable.locations[id].nameHash = hashLocationName(copy, length);
+            // Publish only after the record is complete
+            __atomic_store_n(&locationTable.slots[slot], id, __ATOMIC_RELEASE);
+        }
+    } else if (id == LOCATION_NONE) {
+        fprintf(stderr, "Warning: location table full, \"%.*s\" not interned\n", (int)length, name);
+    }
+
+    pthread_mutex_unlock(&internLock);
+    return id;
+}
+
+const char *locationName(LocationId id) {
+    if (!locationTable.locations || id >= locationTable.count) return "";
+    return locationTable.locations[id].name;
+}
+
+static double toRadians(double degrees) {
+    return degrees * (M_PI / 180.0);
+}
+
+static double greatCircleKm(const LocationInfo *a, const LocationInfo *b) {
+    double dLat = toRadians(b->latitude - a->latitude);
+    double dLon = toRadians(b->longitude - a->longitude);
+    double h = sin(dLat / 2) * sin(dLat / 2) +
+               cos(toRadians(a->latitude)) * cos(toRadians(b->latitude)) * sin(dLon / 2) * sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS_KM * asin(sqrt(h));
+}
+
+/**
+ * Rebuild the dense matrix over every ID below the first MAX_TRAVEL_MATRIX_LOCATIONS
+ */
+static void buildTravelMatrix() {
+    int size = (locationTable.count < MAX_TRAVEL_MATRIX_LOCATIONS) ? locationTable.count : MAX_TRAVEL_MATRIX_LOCATIONS;
+    uint32_t *matrix = calloc((size_t)size * size, sizeof(uint32_t));
+    if (!matrix) {
+        fprintf(stderr, "Warning: Could not allocate travel-time matrix\n");
+        return;
+    }
+
+    for (int from = 1; from < size; from++) {
+        const LocationInfo *a = &locationTable.locations[from];
+        if (!a->hasCoordinates) continue;
+
+        for (int to = 1; to < size; to++) {
+            const LocationInfo *b = &locationTable.locations[to];
+            if (to == from || !b->hasCoordinates) continue;
+
+            double seconds = greatCircleKm(a, b) / locationTable.maxTravelSpeedKmh * 3600.0;
+            matrix[from * size + to] = (seconds < 1.0) ? 1 : (uint32_t)ceil(seconds);
+        }
+    }
+
+    free(locationTable.travelSeconds);
+    locationTable.travelSeconds = matrix;
+    locationTable.matrixSize = size;
+}
+
+static void parseCity(JsonStream *stream) {
+    JsonToken key, value;
+    LocationId id = LOCATION_NONE;
+    double latitude = 0, longitude = 0;
+    int haveLatitude = 0, haveLongitude = 0;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        if (jsonTokenIs(&key, "name") && value.type == JSON_TOKEN_STRING) {
+            id = internLocationN(value.text, value.length);
+        } else if (jsonTokenIs(&key, "latitude")) {
+            latitude = value.number;
+            haveLatitude = 1;
+        } else if (jsonTokenIs(&key, "longitude")) {
+            longitude = value.number;
+            haveLongitude = 1;
+        } else {
+            jsonSkipValue(stream, &value);
+        }
+    }
+
+    if (id != LOCATION_NONE && haveLatitude && haveLongitude) {
+        LocationInfo *info = &locationTable.locations[id];
+        info->latitude = latitude;
+        info->longitude = longitude;
+        info->hasCoordinates = 1;
+    }
+}
+
+int loadLocationTable(const char *path) {
+    JsonStream stream;
+    JsonToken key, value;
+    int cities = 0;
+
+    if (!jsonOpenFile(&stream, path)) return 0;
+
+    if (jsonNext(&stream, &key) && key.type == JSON_TOKEN_OBJECT_BEGIN) {
+        while (jsonNext(&stream, &key) && key.type == JSON_TOKEN_KEY) {
+            if (!jsonNext(&stream, &value)) break;
+
+            if (jsonTokenIs(&key, "maxTravelSpeedKmh") && value.type == JSON_TOKEN_NUMBER && value.number > 0) {
+                locationTable.maxTravelSpeedKmh = value.number;
+            } else if (jsonTokenIs(&key, "locations") && value.type == JSON_TOKEN_ARRAY_BEGIN) {
+                JsonToken item;
+                while (jsonNext(&stream, &item) && item.type == JSON_TOKEN_OBJECT_BEGIN) {
+                    parseCity(&stream);
+                    cities++;
+                }
+            } else {
+                jsonSkipValue(&stream, &value);
+            }
+        }
+    }
+
+    jsonClose(&stream);
+    buildTravelMatrix();
+    return cities;
+}
@@ -0,0 +1,80 @@
+/**
+ * Location Table for Fraud Detection System
+ * Interns city names to 2-byte IDs and precomputes minimum travel times
+ */
+
+#ifndef LOCATION_TABLE_H
+#define LOCATION_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint16_t LocationId;
+
+#define LOCATION_NONE 0             // empty location string
+#define MAX_LOCATIONS 65535
+#define LOCATION_NAME_MAX 29        // longer names are truncated when interned
+#define MAX_TRAVEL_MATRIX_LOCATIONS 1024
+
+typedef struct {
+    const char *name;
+    uint64_t nameHash;              // hashLocationName(name), for lookups keyed by name
+    double latitude;
+    double longitude;
+    int hasCoordinates;
+} LocationInfo;
+
+typedef struct {
+    LocationInfo *locations;        // indexed by LocationId
+    int count;                      // IDs in use, LOCATION_NONE included
+    LocationId *slots;              // open-addressed name index, 0 = empty
+    uint32_t *travelSeconds;        // matrixSize x matrixSize, 0 = unknown
+    int matrixSize;
+    double maxTravelSpeedKmh;
+} LocationTable;
+
+extern LocationTable locationTable;
+
+/**
+ * Intern a name (need not be NUL-terminated), adding it if new. Safe to
+ * call from several threads; lookups of known names never lock.
+ * Returns LOCATION_NONE for an empty name or when the table is full.
+ */
+LocationId internLocationN(const char *name, size_t length);
+
+static inline LocationId internLocation(const char *name) {
+    size_t length = 0;
+    while (name[length]) length++;
+    return internLocationN(name, length);
+}
+
+/**
+ * FNV-1a over the (truncated) name; equal for every spelling that interns
+ * to the same ID
+ */
+uint64_t hashLocationName(const char *name, size_t length);
+
+/**
+ * Look up without interning. Returns LOCATION_NONE if unknown.
+ */
+LocationId findLocationN(const char *name, size_t length);
+
+const char *locationName(LocationId id);
+
+/**
+ * Load city coordinates and rebuild the travel-time matrix over every
+ * location that has them. Returns the number of cities loaded.
+ */
+int loadLocationTable(const char *path);
+
+/**
+ * Minimum plausible seconds to travel between two locations, or 0 when
+ * either side has no coordinates
+ */
+static inline uint32_t minTravelSeconds(LocationId from, LocationId to) {
+    int size = locationTable.matrixSize;
+    if (from >= size || to >= size) return 0;
+    return locationTable.travelSeconds[from * size + to];
+}
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * Metrics for Fraud Detection System
+ * Per-thread stage timers and alert counters, merged when read and
+ * exposed in the Prometheus text format. Build with -DFRAUD_NO_METRICS
+ * to compile every probe away.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "metrics.h"
+#include "account_store.h"
+#include "alert_outbox.h"
+#include "history_segments.h"
+#include "util.h"
+
+static void writeHeader(JsonWriter *out, const char *name, const char *type, const char *help) {
+    jsonWriteLiteral(out, "# HELP ");
+    jsonWriteRaw(out, name, strlen(name));
+    jsonWriteLiteral(out, " ");
+    jsonWriteRaw(out, help, strlen(help));
+    jsonWriteLiteral(out, "\n# TYPE ");
+    jsonWriteRaw(out, name, strlen(name));
+    jsonWriteLiteral(out, " ");
+    jsonWriteRaw(out, type, strlen(type));
+    jsonWriteLiteral(out, "\n");
+}
+
+// name{label="value"} number
+static void writeSample(JsonWriter *out, const char *name, const char *label, const char *value, long number) {
+    jsonWriteRaw(out, name, strlen(name));
+    if (label) {
+        jsonWriteLiteral(out, "{");
+        jsonWriteRaw(out, label, strlen(label));
+        jsonWriteLiteral(out, "=\"");
+        jsonWriteRaw(out, value, strlen(value));
+        jsonWriteLiteral(out, "\"}");
+    }
+    jsonWriteLiteral(out, " ");
+    jsonWriteInt(out, number);
+    jsonWriteLiteral(out, "\n");
+}
+
+// Sizes of the in-memory stores, read directly rather than probed
+static void writeStoreGauges(JsonWriter *out) {
+    writeHeader(out, "fraud_transactions_stored", "gauge", "Transactions held in memory");
+    writeSample(out, "fraud_transactions_stored", NULL, NULL, txnCount - txnColumns.firstRow);
+    writeHeader(out, "fraud_transactions_sealed", "gauge", "Transactions sealed to history segments");
+    writeSample(out, "fraud_transactions_sealed", NULL, NULL, sealedRowCount());
+    writeHeader(out, "fraud_accounts", "gauge", "Accounts loaded");
+    writeSample(out, "fraud_accounts", NULL, NULL, accountStore.count);
+}
+
+// Alert outbox backpressure, counted by the outbox itself
+static void writeOutboxMetrics(JsonWriter *out) {
+    AlertOutboxStats outbox;
+    readAlertOutboxStats(&outbox);
+
+    writeHeader(out, "fraud_alert_queue_depth", "gauge", "Alert events waiting to be written to the outbox");
+    writeSample(out, "fraud_alert_queue_depth", NULL, NULL, outbox.depth);
+    writeHeader(out, "fraud_alert_events_total", "counter", "Alert events, by what happened to them");
+    writeSample(out, "fraud_alert_events_total", "outcome", "published", (long)outbox.published);
+    writeSample(out, "fraud_alert_events_total", "outcome", "dropped", (long)outbox.dropped);
+    writeSample(out, "fraud_alert_events_total", "outcome", "coalesced", (long)outbox.coalesced);
+    writeSample(out, "fraud_alert_events_total", "outcome", "written", (long)outbox.written);
+    writeSample(out, "fraud_alert_events_total", "outcome", "lost", (long)outbox.writeErrors);
+    writeHeader(out, "fraud_alert_outbox_batches_total", "counter", "Batched appends to the alert outbox");
+    writeSample(out, "fraud_alert_outbox_batches_total", NULL, NULL, (long)outbox.batches);
+}
+
+#ifndef FRAUD_NO_METRICS
+
+static const char *stageNames[STAGE_COUNT] = {
+    "request", "accountLookup", "checkFraud", "ruleContext", "ruleAmount", "ruleVelocity",
+    "ruleLocation", "ruleTravel", "ruleProfile", "scoring", "persist", "serialize", "journalCommit"
+};
+
+static const char *gaugeNames[GAUGE_COUNT] = {
+    "fraud_serve_batch_requests", "fraud_journal_pending_bytes", "fraud_batch_queue_depth"
+};
+
+static const char *gaugeHelp[GAUGE_COUNT] = {
+    "Requests answered by the last serve read batch",
+    "Journal bytes queued for the next group commit",
+    "Input chunks waiting for batch scoring workers"
+};
+
+#define STRINGIFY(x) #x
+#define INTERVAL_TEXT(x) STRINGIFY(x)
+
+static void writeDouble(JsonWriter *out, double value) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "%.9g", value);
+    jsonWriteRaw(out, buffer, (size_t)length);
+}
+
+__thread MetricsShard *metricsShard = NULL;
+int64_t metricsGauges[GAUGE_COUNT];
+
+static MetricsShard *shardList = NULL;
+static pthread_mutex_t shardLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t baseTicks;
+static double baseSeconds;
+
+MetricsShard *metricsAttachThread() {
+    MetricsShard *shard = calloc(1, sizeof(MetricsShard));
+    if (!shard) return NULL;
+
+    pthread_mutex_lock(&shardLock);
+    if (!shardList) {
+        baseTicks = metricsTicks();
+        baseSeconds = monotonicSeconds();
+    }
+    shard->next = shardList;
+    __atomic_store_n(&shardList, shard, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&shardLock);
+
+    metricsShard = shard;
+    return shard;
+}
+
+/**
+ * Seconds per tick, measured against the monotonic clock since the first
+ * shard was attached (briefly sampled if that was too recent to tell)
+ */
+static double secondsPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    pthread_mutex_lock(&shardLock);
+    uint64_t startTicks = baseTicks;
+    double startSeconds = baseSeconds;
+    pthread_mutex_unlock(&shardLock);
+
+    if (!startTicks || monotonicSeconds() - startSeconds < 0.05) {
+        startTicks = metricsTicks();
+        startSeconds = monotonicSeconds();
+        struct timespec pause = {0, 20000000};
+        nanosleep(&pause, NULL);
+    }
+    uint64_t ticks = metricsTicks() - startTicks;
+    return ticks ? (monotonicSeconds() - startSeconds) / (double)ticks : 0.0;
+#else
+    return 1e-9;
+#endif
+}
+
+static void mergeShards(MetricsShard *total) {
+    memset(total, 0, sizeof(*total));
+    for (MetricsShard *shard = __atomic_load_n(&shardList, __ATOMIC_ACQUIRE); shard; shard = shard->next) {
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            total->stageCount[stage] += __atomic_load_n(&shard->stageCount[stage], __ATOMIC_RELAXED);
+            total->stageTicks[stage] += __atomic_load_n(&shard->stageTicks[stage], __ATOMIC_RELAXED);
+            for (int bucket = 0; bucket < METRICS_BUCKETS; bucket++) {
+                total->stageBuckets[stage][bucket] +=
+                    __atomic_load_n(&shard->stageBuckets[stage][bucket], __ATOMIC_RELAXED);
+            }
+        }
+        for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+            total->alertCount[code] += __atomic_load_n(&shard->alertCount[code], __ATOMIC_RELAXED);
+        }
+        for (int status = 0; status < TXN_STATUS_COUNT; status++) {
+            total->statusCount[status] += __atomic_load_n(&shard->statusCount[status], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void writeStageHistograms(JsonWriter *out, const MetricsShard *total, double tickSeconds) {
+    writeHeader(out, "fraud_stage_duration_seconds", "histogram",
+                "Time spent per stage; per-transaction stages are sampled 1 in " INTERVAL_TEXT(METRICS_SAMPLE_INTERVAL));
+
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        // Cumulative buckets; the last one is reported as +Inf
+        uint64_t cumulative = 0;
+        for (int bucket = 0; bucket < METRICS_BUCKETS - 1; bucket++) {
+            cumulative += total->stageBuckets[stage][bucket];
+            jsonWriteLiteral(out, "fraud_stage_duration_seconds_bucket{stage=\"");
+            jsonWriteRaw(out, stageNames[stage], strlen(stageNames[stage]));
+            jsonWriteLiteral(out, "\",le=\"");
+            writeDouble(out, (double)(1ULL << bucket) * tickSeconds);
+            jsonWriteLiteral(out, "\"} ");
+            jsonWriteInt(out, (long)cumulative);
+            jsonWriteLiteral(out, "\n");
+        }
+        jsonWriteLiteral(out, "fraud_stage_duration_seconds_bucket{stage=\"");
+        jsonWriteRaw(out, stageNames[stage], strlen(stageNames[stage]));
+        jsonWriteLiteral(out, "\",le=\"+Inf\"} ");
+        jsonWriteInt(out, (long)total->stageCount[stage]);
+        jsonWriteLiteral(out, "\nfraud_stage_duration_seconds_sum{stage=\"");
+        jsonWriteRaw(out, stageNames[stage], strlen(stageNames[stage]));
+        jsonWriteLiteral(out, "\"} ");
+        writeDouble(out, (double)total->stageTicks[stage] * tickSeconds);
+        jsonWriteLiteral(out, "\n");
+        writeSample(out, "fraud_stage_duration_seconds_count", "stage", stageNames[stage],
+                    (long)total->stageCount[stage]);
+    }
+}
+
+void writeMetricsText(JsonWriter *out) {
+    MetricsShard *total = malloc(sizeof(MetricsShard));
+    if (!total) return;
+    mergeShards(total);
+
+    writeStageHistograms(out, total, secondsPerTick());
+
+    writeHeader(out, "fraud_alerts_total", "counter", "Alerts raised by scored transactions");
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        writeSample(out, "fraud_alerts_total", "alert", alertTable[code].key, (long)total->alertCount[code]);
+    }
+
+    writeHeader(out, "fraud_transactions_scored_total", "counter", "Transactions scored, by resulting status");
+    for (int status = 0; status < TXN_STATUS_COUNT; status++) {
+        writeSample(out, "fraud_transactions_scored_total", "status", txnStatusName(status),
+                    (long)total->statusCount[status]);
+    }
+
+    for (int gauge = 0; gauge < GAUGE_COUNT; gauge++) {
+        writeHeader(out, gaugeNames[gauge], "gauge", gaugeHelp[gauge]);
+        writeSample(out, gaugeNames[gauge], NULL, NULL, (long)__atomic_load_n(&metricsGauges[gauge], __ATOMIC_RELAXED));
+    }
+
+    free(total);
+    writeStoreGauges(out);
+    writeOutboxMetrics(out);
+}
+
+#else
+
+void writeMetricsText(JsonWriter *out) {
+    writeStoreGauges(out);
+    writeOutboxMetrics(out);
+}
+
+#endif
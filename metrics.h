@@ -0,0 +1,154 @@
+/**
+ * Metrics for Fraud Detection System
+ * Per-thread stage timers and alert counters, merged when read and
+ * exposed in the Prometheus text format. Build with -DFRAUD_NO_METRICS
+ * to compile every probe away.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <time.h>
+#include "alert_codes.h"
+#include "json_writer.h"
+#include "transaction_log.h"
+
+typedef enum {
+    STAGE_REQUEST = 0,          // one whole TXN request
+    STAGE_ACCOUNT_LOOKUP,
+    STAGE_CHECK_FRAUD,
+    STAGE_RULE_CONTEXT,         // spend counters, blacklist, travel time, profile features
+    STAGE_RULE_AMOUNT,          // value tiers, round and micro amounts
+    STAGE_RULE_VELOCITY,
+    STAGE_RULE_LOCATION,        // unusual hours, suspicious list, blacklist bits
+    STAGE_RULE_TRAVEL,
+    STAGE_RULE_PROFILE,         // account behavior profile features
+    STAGE_SCORING,
+    STAGE_PERSIST,              // in-memory history and journal append
+    STAGE_SERIALIZE,
+    STAGE_JOURNAL_COMMIT,
+    STAGE_COUNT
+} MetricsStage;
+
+typedef enum {
+    GAUGE_SERVE_BATCH_REQUESTS = 0,     // requests answered by the last read() batch
+    GAUGE_JOURNAL_PENDING_BYTES,        // queued for the next group commit
+    GAUGE_BATCH_QUEUE_DEPTH,            // chunks waiting for batch workers
+    GAUGE_COUNT
+} MetricsGauge;
+
+// Bucket b holds durations of [2^(b-1), 2^b) ticks
+#define METRICS_BUCKETS 40
+
+// Per-transaction stages are timed on one call in this many (a power of
+// two); alert and status counters are always exact
+#define METRICS_SAMPLE_INTERVAL 16
+
+typedef struct MetricsShard {
+    uint64_t stageCount[STAGE_COUNT];
+    uint64_t stageTicks[STAGE_COUNT];
+    uint64_t stageBuckets[STAGE_COUNT][METRICS_BUCKETS];
+    uint64_t alertCount[ALERT_CODE_COUNT];
+    uint64_t statusCount[TXN_STATUS_COUNT];
+    struct MetricsShard *next;
+} MetricsShard;
+
+/**
+ * Write every metric in the Prometheus text exposition format
+ */
+void writeMetricsText(JsonWriter *out);
+
+#ifndef FRAUD_NO_METRICS
+
+extern __thread MetricsShard *metricsShard;
+extern int64_t metricsGauges[GAUGE_COUNT];
+
+/**
+ * Give the calling thread its own shard. Shards outlive their threads so
+ * counts from finished workers are still reported.
+ */
+MetricsShard *metricsAttachThread();
+
+// TSC where available: a few ns per read, converted to seconds on dump
+static inline uint64_t metricsTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Only the owning thread writes a shard; readers may race, never tear
+static inline void metricsBump(uint64_t *counter, uint64_t by) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + by, __ATOMIC_RELAXED);
+}
+
+static inline void metricsRecordStage(MetricsStage stage, uint64_t ticks) {
+    MetricsShard *shard = metricsShard ? metricsShard : metricsAttachThread();
+    if (!shard) return;
+
+    int bucket = ticks ? 64 - __builtin_clzll(ticks) : 0;
+    if (bucket >= METRICS_BUCKETS) bucket = METRICS_BUCKETS - 1;
+    metricsBump(&shard->stageCount[stage], 1);
+    metricsBump(&shard->stageTicks[stage], ticks);
+    metricsBump(&shard->stageBuckets[stage][bucket], 1);
+}
+
+static inline void metricsCountTransaction(const Transaction *txn) {
+    MetricsShard *shard = metricsShard ? metricsShard : metricsAttachThread();
+    if (!shard) return;
+
+    for (uint32_t mask = txn->alertMask; mask; mask &= mask - 1) {
+        int code = __builtin_ctz(mask);
+        if (code < ALERT_CODE_COUNT) metricsBump(&shard->alertCount[code], 1);
+    }
+    if (txn->status < TXN_STATUS_COUNT) metricsBump(&shard->statusCount[txn->status], 1);
+}
+
+#define METRICS_START(mark) uint64_t mark = metricsTicks()
+// mark stays 0 on calls that are not sampled, which turns the probes
+// below into a single branch
+#define METRICS_START_SAMPLED(mark) \
+    static __thread uint32_t mark##Calls; \
+    uint64_t mark = ((++mark##Calls & (METRICS_SAMPLE_INTERVAL - 1)) == 0) ? metricsTicks() : 0
+#define METRICS_START_FROM(mark, from) uint64_t mark = (from)
+#define METRICS_STAGE(stage, mark) metricsRecordStage((stage), metricsTicks() - (mark))
+#define METRICS_SPAN(stage, from, to) do { \
+        if (from) metricsRecordStage((stage), (to) - (from)); \
+    } while (0)
+// Close one stage and open the next with a single clock read
+#define METRICS_LAP(stage, mark) do { \
+        if (mark) { \
+            uint64_t lapEnd = metricsTicks(); \
+            metricsRecordStage((stage), lapEnd - (mark)); \
+            (mark) = lapEnd; \
+        } \
+    } while (0)
+#define METRICS_RESTART(mark) do { \
+        if (mark) (mark) = metricsTicks(); \
+    } while (0)
+#define METRICS_COUNT_TRANSACTION(txn) metricsCountTransaction(txn)
+#define METRICS_SET_GAUGE(gauge, value) \
+    __atomic_store_n(&metricsGauges[gauge], (int64_t)(value), __ATOMIC_RELAXED)
+#define METRICS_ADD_GAUGE(gauge, delta) \
+    __atomic_fetch_add(&metricsGauges[gauge], (int64_t)(delta), __ATOMIC_RELAXED)
+
+#else
+
+#define METRICS_START(mark) do {} while (0)
+#define METRICS_START_SAMPLED(mark) do {} while (0)
+#define METRICS_START_FROM(mark, from) do {} while (0)
+#define METRICS_STAGE(stage, mark) do {} while (0)
+#define METRICS_SPAN(stage, from, to) do {} while (0)
+#define METRICS_LAP(stage, mark) do {} while (0)
+#define METRICS_RESTART(mark) do {} while (0)
+#define METRICS_COUNT_TRANSACTION(txn) do {} while (0)
+#define METRICS_SET_GAUGE(gauge, value) do {} while (0)
+#define METRICS_ADD_GAUGE(gauge, delta) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,453 @@
+/**
+ * Rule Engine for Fraud Detection System
+ * Compiles fraud_patterns.json into immutable, versioned rule sets that
+ * checkFraud() evaluates without parsing or string comparison, and swaps
+ * them in while scoring continues
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include "rule_engine.h"
+#include "account_store.h"
+#include "json_stream.h"
+#include "epoch_reclaim.h"
+
+#define FNV_OFFSET_BASIS 0x811C9DC5u
+#define FNV_PRIME 0x01000193u
+
+// Published sets are freed once no reader can still hold them
+static CompiledRules *publishedRules = NULL;
+static EpochDomain rulesDomain = EPOCH_DOMAIN_INITIALIZER;
+static __thread EpochReader *ruleReader = NULL;
+
+static pthread_mutex_t publishLock = PTHREAD_MUTEX_INITIALIZER;
+static int reloadRunning = 0;
+static pthread_mutex_t mtimeLock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec compiledMtime;
+
+// riskScores entries and the alerts each multiplier scales
+static const struct {
+    const char *key;
+    uint32_t alerts;
+} multiplierTable[] = {
+    {"highValueMultiplier", ALERT_BIT(ALERT_HIGH_VALUE) | ALERT_BIT(ALERT_VERY_HIGH_VALUE)},
+    {"rapidTransactionMultiplier", ALERT_BIT(ALERT_RAPID_TRANSACTIONS)},
+    {"impossibleTravelMultiplier", ALERT_BIT(ALERT_IMPOSSIBLE_TRAVEL)},
+    {"locationChangeMultiplier", ALERT_BIT(ALERT_LOCATION_CHANGE)},
+    {"unusualHoursMultiplier", ALERT_BIT(ALERT_UNUSUAL_HOURS)},
+    {"suspiciousLocationMultiplier", ALERT_BIT(ALERT_SUSPICIOUS_LOCATION)},
+    {"roundAmountMultiplier", ALERT_BIT(ALERT_ROUND_AMOUNT)},
+    {"microAmountMultiplier", ALERT_BIT(ALERT_MICRO_AMOUNT)},
+    {"blacklistMultiplier", ALERT_BIT(ALERT_BLACKLISTED_ACCOUNT) | ALERT_BIT(ALERT_BLACKLISTED_LOCATION)},
+    {"spendingLimitMultiplier", ALERT_BIT(ALERT_SPENDING_LIMIT)},
+    {"behaviorMultiplier", ALERT_BIT(ALERT_AMOUNT_ANOMALY) | ALERT_BIT(ALERT_RATE_SPIKE) |
+                           ALERT_BIT(ALERT_UNUSUAL_ACCOUNT_HOUR) | ALERT_BIT(ALERT_NEW_LOCATION)}
+};
+
+#define MULTIPLIER_COUNT ((int)(sizeof(multiplierTable) / sizeof(multiplierTable[0])))
+
+void initDefaultRules(CompiledRules *rules) {
+    memset(rules, 0, sizeof(*rules));
+
+    rules->amountTierThresholds[0] = 100000.0;
+    rules->amountTierAlerts[0] = ALERT_VERY_HIGH_VALUE;
+    rules->amountTierThresholds[1] = 50000.0;
+    rules->amountTierAlerts[1] = ALERT_HIGH_VALUE;
+
+    rules->rapidTransactionCount = 3;
+    rules->rapidTransactionWindow = 60;
+    rules->locationChangeWindow = 7200;
+    rules->impossibleTravelTime = 600;
+
+    rules->roundAmountUnit = 1000.0;
+    rules->microAmountThreshold = 0.0;
+
+    rules->profileMinHistory = 10;
+    rules->amountZScoreThreshold = 3.0;
+    rules->rateSpikeRatio = 5.0;
+    rules->rareHourShare = 0.02;
+
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        rules->weights[code] = alertTable[code].weight;
+    }
+    rules->suspiciousScoreThreshold = 20;
+    rules->version = FNV_OFFSET_BASIS;
+}
+
+static void addSuspiciousLocation(CompiledRules *rules, LocationId location) {
+    uint64_t bit = 1ULL << (location & 63);
+    if (location == LOCATION_NONE || (rules->suspiciousLocations[location >> 6] & bit)) return;
+
+    rules->suspiciousLocations[location >> 6] |= bit;
+    rules->suspiciousLocationCount++;
+}
+
+int scoreAlertMask(const CompiledRules *rules, uint32_t alertMask) {
+    int score = 0;
+
+    while (alertMask) {
+        int code = __builtin_ctz(alertMask);
+        score += rules->weights[code];
+        alertMask &= alertMask - 1;
+    }
+
+    return (score > 100) ? 100 : score;
+}
+
+/**
+ * Parse "HH:MM" into minutes since midnight. Returns -1 if malformed.
+ */
+static int parseClockMinutes(const JsonToken *token) {
+    const char *s = token->text;
+    if (token->type != JSON_TOKEN_STRING || token->length != 5 || s[2] != ':') return -1;
+
+    for (int i = 0; i < 5; i++) {
+        if (i != 2 && (s[i] < '0' || s[i] > '9')) return -1;
+    }
+
+    int hours = (s[0] - '0') * 10 + (s[1] - '0');
+    int minutes = (s[3] - '0') * 10 + (s[4] - '0');
+    if (hours > 23 || minutes > 59) return -1;
+    return hours * 60 + minutes;
+}
+
+/**
+ * Mark [start, end) in the minute bitmap, wrapping past midnight
+ */
+static void setUnusualWindow(CompiledRules *rules, int start, int end) {
+    memset(rules->unusualMinutes, 0, sizeof(rules->unusualMinutes));
+    for (int minute = start; minute != end; minute = (minute + 1) % MINUTES_PER_DAY) {
+        rules->unusualMinutes[minute >> 6] |= 1ULL << (minute & 63);
+    }
+}
+
+static void parseUnusualHours(JsonStream *stream, CompiledRules *rules) {
+    JsonToken key, value;
+    int start = -1, end = -1;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        if (jsonTokenIs(&key, "start")) {
+            start = parseClockMinutes(&value);
+        } else if (jsonTokenIs(&key, "end")) {
+            end = parseClockMinutes(&value);
+        } else {
+            jsonSkipValue(stream, &value);
+        }
+    }
+
+    if (start < 0 || end < 0) {
+        fprintf(stderr, "Warning: unusualHours needs \"HH:MM\" start and end; rule disabled\n");
+        return;
+    }
+    setUnusualWindow(rules, start, end);
+}
+
+static void parseAmountPatterns(JsonStream *stream, CompiledRules *rules) {
+    JsonToken key, value;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        if (jsonTokenIs(&key, "roundAmounts") && value.type == JSON_TOKEN_ARRAY_BEGIN) {
+            JsonToken item;
+            rules->roundAmountCount = 0;
+            while (jsonNext(stream, &item) && item.type != JSON_TOKEN_ARRAY_END) {
+                if (item.type == JSON_TOKEN_NUMBER && rules->roundAmountCount < MAX_ROUND_AMOUNTS) {
+                    rules->roundAmounts[rules->roundAmountCount++] = item.number;
+                } else {
+                    jsonSkipValue(stream, &item);
+                }
+            }
+        } else if (jsonTokenIs(&key, "roundAmountUnit")) {
+            rules->roundAmountUnit = value.number;
+        } else if (jsonTokenIs(&key, "microAmounts")) {
+            rules->microAmountThreshold = value.number;
+        } else {
+            jsonSkipValue(stream, &value);
+        }
+    }
+}
+
+static void parseBehaviorProfile(JsonStream *stream, CompiledRules *rules) {
+    JsonToken key, value;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        if (jsonTokenIs(&key, "minHistory")) {
+            rules->profileMinHistory = (int)value.number;
+        } else if (jsonTokenIs(&key, "amountZScore")) {
+            rules->amountZScoreThreshold = value.number;
+        } else if (jsonTokenIs(&key, "rateSpikeRatio")) {
+            rules->rateSpikeRatio = value.number;
+        } else if (jsonTokenIs(&key, "rareHourShare")) {
+            rules->rareHourShare = value.number;
+        } else {
+            jsonSkipValue(stream, &value);
+        }
+    }
+}
+
+static void parseRuleSection(JsonStream *stream, CompiledRules *rules) {
+    JsonToken key, value;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        if (jsonTokenIs(&key, "highValueThreshold")) {
+            rules->amountTierThresholds[1] = value.number;
+        } else if (jsonTokenIs(&key, "veryHighValueThreshold")) {
+            rules->amountTierThresholds[0] = value.number;
+        } else if (jsonTokenIs(&key, "rapidTransactionCount")) {
+            rules->rapidTransactionCount = (int)value.number;
+        } else if (jsonTokenIs(&key, "rapidTransactionWindow")) {
+            rules->rapidTransactionWindow = (int)value.number;
+        } else if (jsonTokenIs(&key, "impossibleTravelTime")) {
+            rules->impossibleTravelTime = (int)value.number;
+        } else if (jsonTokenIs(&key, "locationChangeWindow")) {
+            rules->locationChangeWindow = (int)value.number;
+        } else if (jsonTokenIs(&key, "suspiciousScoreThreshold")) {
+            rules->suspiciousScoreThreshold = (int)value.number;
+        } else if (jsonTokenIs(&key, "suspiciousLocations") && value.type == JSON_TOKEN_ARRAY_BEGIN) {
+            JsonToken item;
+            while (jsonNext(stream, &item) && item.type != JSON_TOKEN_ARRAY_END) {
+                if (item.type == JSON_TOKEN_STRING) {
+                    addSuspiciousLocation(rules, internLocationN(item.text, item.length));
+                } else {
+                    jsonSkipValue(stream, &item);
+                }
+            }
+        } else if (jsonTokenIs(&key, "unusualHours") && value.type == JSON_TOKEN_OBJECT_BEGIN) {
+            parseUnusualHours(stream, rules);
+        } else if (jsonTokenIs(&key, "amountPatterns") && value.type == JSON_TOKEN_OBJECT_BEGIN) {
+            parseAmountPatterns(stream, rules);
+        } else if (jsonTokenIs(&key, "behaviorProfile") && value.type == JSON_TOKEN_OBJECT_BEGIN) {
+            parseBehaviorProfile(stream, rules);
+        } else {
+            jsonSkipValue(stream, &value);
+        }
+    }
+}
+
+static void parseMultipliers(JsonStream *stream, double *multipliers) {
+    JsonToken key, value;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        int matched = 0;
+        for (int i = 0; i < MULTIPLIER_COUNT && value.type == JSON_TOKEN_NUMBER; i++) {
+            if (!jsonTokenIs(&key, multiplierTable[i].key)) continue;
+            uint32_t alerts = multiplierTable[i].alerts;
+            while (alerts) {
+                multipliers[__builtin_ctz(alerts)] = value.number;
+                alerts &= alerts - 1;
+            }
+            matched = 1;
+            break;
+        }
+        if (!matched) jsonSkipValue(stream, &value);
+    }
+}
+
+static void parseBaseWeights(JsonStream *stream, double *baseWeights) {
+    JsonToken key, value;
+
+    while (jsonNext(stream, &key) && key.type == JSON_TOKEN_KEY) {
+        if (!jsonNext(stream, &value)) break;
+
+        int matched = 0;
+        for (int code = 0; code < ALERT_CODE_COUNT && value.type == JSON_TOKEN_NUMBER; code++) {
+            if (jsonTokenIs(&key, alertTable[code].key)) {
+                baseWeights[code] = value.number;
+                matched = 1;
+                break;
+            }
+        }
+        if (!matched) jsonSkipValue(stream, &value);
+    }
+}
+
+/**
+ * Clamp and normalise values the evaluator relies on
+ */
+// Counts and windows below 1 would fire (or never fire) on every transaction
+static void requirePositive(const char *name, int *value, int fallback) {
+    if (*value > 0) return;
+    fprintf(stderr, "Warning: %s must be positive, using %d\n", name, fallback);
+    *value = fallback;
+}
+
+static void validateRules(CompiledRules *rules) {
+    CompiledRules defaults;
+    initDefaultRules(&defaults);
+    requirePositive("rapidTransactionCount", &rules->rapidTransactionCount, defaults.rapidTransactionCount);
+    requirePositive("rapidTransactionWindow", &rules->rapidTransactionWindow, defaults.rapidTransactionWindow);
+    requirePositive("impossibleTravelTime", &rules->impossibleTravelTime, defaults.impossibleTravelTime);
+    requirePositive("locationChangeWindow", &rules->locationChangeWindow, defaults.locationChangeWindow);
+
+    // The velocity check only remembers RECENT_TXN_CAPACITY transactions per account
+    if (rules->rapidTransactionCount > RECENT_TXN_CAPACITY) {
+        fprintf(stderr, "Warning: rapidTransactionCount capped at %d\n", RECENT_TXN_CAPACITY);
+        rules->rapidTransactionCount = RECENT_TXN_CAPACITY;
+    }
+
+    // A standard deviation needs two earlier amounts
+    if (rules->profileMinHistory == 1) rules->profileMinHistory = 2;
+    if (rules->profileMinHistory < 0) rules->profileMinHistory = 0;
+
+    // Keep the amount tiers highest-first so the first hit is the most severe
+    if (rules->amountTierThresholds[0] < rules->amountTierThresholds[1]) {
+        double threshold = rules->amountTierThresholds[0];
+        uint8_t alert = rules->amountTierAlerts[0];
+        rules->amountTierThresholds[0] = rules->amountTierThresholds[1];
+        rules->amountTierAlerts[0] = rules->amountTierAlerts[1];
+        rules->amountTierThresholds[1] = threshold;
+        rules->amountTierAlerts[1] = alert;
+    }
+}
+
+static uint32_t fingerprint(const char *data, size_t size) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ (uint8_t)data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+int compileFraudRules(const char *path, CompiledRules *rules) {
+    JsonStream stream;
+    JsonToken key, value;
+    double baseWeights[ALERT_CODE_COUNT];
+    double multipliers[ALERT_CODE_COUNT];
+
+    initDefaultRules(rules);
+    if (!jsonOpenFile(&stream, path)) return 0;
+    rules->version = fingerprint(stream.data, stream.size);
+
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        baseWeights[code] = alertTable[code].weight;
+        multipliers[code] = 1.0;
+    }
+
+    if (jsonNext(&stream, &key) && key.type == JSON_TOKEN_OBJECT_BEGIN) {
+        while (jsonNext(&stream, &key) && key.type == JSON_TOKEN_KEY) {
+            if (!jsonNext(&stream, &value)) break;
+
+            if (value.type != JSON_TOKEN_OBJECT_BEGIN) {
+                jsonSkipValue(&stream, &value);
+            } else if (jsonTokenIs(&key, "fraudRules")) {
+                parseRuleSection(&stream, rules);
+            } else if (jsonTokenIs(&key, "riskScores")) {
+                parseMultipliers(&stream, multipliers);
+            } else if (jsonTokenIs(&key, "alertWeights")) {
+                parseBaseWeights(&stream, baseWeights);
+            } else {
+                jsonSkipValue(&stream, &value);
+            }
+        }
+    }
+
+    jsonClose(&stream);
+
+    for (int code = 0; code < ALERT_CODE_COUNT; code++) {
+        rules->weights[code] = (int)(baseWeights[code] * multipliers[code] + 0.5);
+    }
+    validateRules(rules);
+    return 1;
+}
+
+const CompiledRules *acquireRules() {
+    enterEpoch(&rulesDomain, &ruleReader);
+    return __atomic_load_n(&publishedRules, __ATOMIC_SEQ_CST);
+}
+
+void releaseRules() {
+    leaveEpoch(ruleReader);
+}
+
+int publishRules(const CompiledRules *rules) {
+    CompiledRules *fresh = malloc(sizeof(CompiledRules));
+    if (!fresh) return 0;
+    *fresh = *rules;
+
+    pthread_mutex_lock(&publishLock);
+    CompiledRules *previous = __atomic_exchange_n(&publishedRules, fresh, __ATOMIC_SEQ_CST);
+    synchronizeEpoch(&rulesDomain);
+    pthread_mutex_unlock(&publishLock);
+
+    free(previous);
+    return 1;
+}
+
+int reloadFraudRules(const char *path) {
+    CompiledRules rules;
+    struct stat info;
+
+    // Taken before compiling so an edit during the compile is seen next time
+    struct timespec mtime = {0, 0};
+    if (stat(path, &info) == 0) mtime = info.st_mtim;
+    if (!compileFraudRules(path, &rules) || !publishRules(&rules)) return 0;
+
+    pthread_mutex_lock(&mtimeLock);
+    compiledMtime = mtime;
+    pthread_mutex_unlock(&mtimeLock);
+
+    fprintf(stderr, "Fraud rules loaded: HighValue=%.2f, RapidCount=%d, SuspiciousLocations=%d, Version=%08x\n",
+            rules.amountTierThresholds[AMOUNT_TIER_COUNT - 1], rules.rapidTransactionCount,
+            rules.suspiciousLocationCount, rules.version);
+    return 1;
+}
+
+static void *reloadThread(void *arg) {
+    char *path = arg;
+    if (!reloadFraudRules(path)) {
+        fprintf(stderr, "Warning: Fraud rules reload failed, keeping the previous rules\n");
+    }
+    free(path);
+    __atomic_store_n(&reloadRunning, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int reloadFraudRulesInBackground(const char *path) {
+    if (__atomic_exchange_n(&reloadRunning, 1, __ATOMIC_ACQ_REL)) return 0;
+
+    pthread_t thread;
+    pthread_attr_t attributes;
+    char *pathCopy = strdup(path);
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    // SIGHUP is for the serve thread, whose read() it interrupts
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    int started = pathCopy && pthread_create(&thread, &attributes, reloadThread, pathCopy) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    pthread_attr_destroy(&attributes);
+
+    if (!started) {
+        free(pathCopy);
+        __atomic_store_n(&reloadRunning, 0, __ATOMIC_RELEASE);
+        return 0;
+    }
+    return 1;
+}
+
+int fraudRulesFileChanged(const char *path) {
+    struct stat info;
+    if (stat(path, &info) != 0) return 0;
+
+    pthread_mutex_lock(&mtimeLock);
+    int changed = info.st_mtim.tv_sec != compiledMtime.tv_sec || info.st_mtim.tv_nsec != compiledMtime.tv_nsec;
+    pthread_mutex_unlock(&mtimeLock);
+    return changed;
+}
@@ -0,0 +1,126 @@
+/**
+ * Rule Engine for Fraud Detection System
+ * Compiles fraud_patterns.json into immutable, versioned rule sets that
+ * checkFraud() evaluates without parsing or string comparison, and swaps
+ * them in while scoring continues
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stdint.h>
+#include "alert_codes.h"
+#include "location_table.h"
+
+#define AMOUNT_TIER_COUNT 2
+#define MAX_ROUND_AMOUNTS 16
+#define LOCATION_BITMAP_WORDS ((MAX_LOCATIONS + 64) / 64)
+#define MINUTES_PER_DAY 1440
+
+#define DATA_FILE_FRAUD_RULES "data/fraud_patterns.json"
+
+// Transactions scored before rule sets carried a version
+#define RULES_VERSION_UNKNOWN 0
+
+typedef struct {
+    // Fingerprint of the source file, so equal rule files get equal
+    // versions across restarts and nodes; built-in defaults hash as empty
+    uint32_t version;
+
+    // Amount tiers, highest threshold first; the first tier exceeded fires
+    double amountTierThresholds[AMOUNT_TIER_COUNT];
+    uint8_t amountTierAlerts[AMOUNT_TIER_COUNT];
+
+    // Velocity and travel windows (seconds)
+    int rapidTransactionCount;
+    int rapidTransactionWindow;
+    int locationChangeWindow;
+    int impossibleTravelTime;
+
+    // Amount patterns
+    double roundAmountUnit;
+    double roundAmounts[MAX_ROUND_AMOUNTS];
+    int roundAmountCount;
+    double microAmountThreshold;
+
+    // One bit per interned LocationId
+    uint64_t suspiciousLocations[LOCATION_BITMAP_WORDS];
+    int suspiciousLocationCount;
+
+    // One bit per minute of the (UTC) day
+    uint64_t unusualMinutes[(MINUTES_PER_DAY + 63) / 64];
+
+    // Checks against the account's behavior profile, which need at least
+    // profileMinHistory earlier transactions (0 turns them off)
+    int profileMinHistory;
+    double amountZScoreThreshold;
+    double rateSpikeRatio;
+    double rareHourShare;
+
+    // Final per-alert weight (base weight times its risk multiplier)
+    int weights[ALERT_CODE_COUNT];
+    int suspiciousScoreThreshold;
+} CompiledRules;
+
+/**
+ * Reset to the built-in rule set. Its thresholds and windows mirror the
+ * shipped data/fraud_patterns.json; weights are the unscaled alert table
+ * values, and suspicious locations, unusual hours and micro amounts stay
+ * off until a file sets them.
+ */
+void initDefaultRules(CompiledRules *rules);
+
+/**
+ * Compile a fraud_patterns.json file over the defaults. Returns 0 if the
+ * file could not be opened (rules are left at their defaults).
+ */
+int compileFraudRules(const char *path, CompiledRules *rules);
+
+/**
+ * Rule set in effect, held until releaseRules(). Lock-free: the reader
+ * only announces the current epoch, so a publisher knows not to free the
+ * set until the read ends. Reads must not nest; keep them to a scoring
+ * call or a batch chunk. NULL until the first publishRules().
+ */
+const CompiledRules *acquireRules();
+void releaseRules();
+
+/**
+ * Copy rules into a new immutable set and swap it in. New reads see it at
+ * once; the previous set is freed after every read that could still see
+ * it has ended. Must not be called while this thread holds the rules.
+ */
+int publishRules(const CompiledRules *rules);
+
+/**
+ * Compile and publish the file. Returns 0 (keeping the current set) if
+ * the file cannot be opened.
+ */
+int reloadFraudRules(const char *path);
+
+/**
+ * Run reloadFraudRules() on a detached thread. Returns 0 if a reload is
+ * already in progress or the thread fails to start.
+ */
+int reloadFraudRulesInBackground(const char *path);
+
+/**
+ * Nonzero when the file's modification time differs from the one last
+ * compiled by reloadFraudRules()
+ */
+int fraudRulesFileChanged(const char *path);
+
+static inline int isSuspiciousLocation(const CompiledRules *rules, LocationId location) {
+    return (int)((rules->suspiciousLocations[location >> 6] >> (location & 63)) & 1);
+}
+
+static inline int isUnusualMinute(const CompiledRules *rules, int minuteOfDay) {
+    return (int)((rules->unusualMinutes[minuteOfDay >> 6] >> (minuteOfDay & 63)) & 1);
+}
+
+/**
+ * Weighted sum of the raised alerts, capped at 100
+ */
+int scoreAlertMask(const CompiledRules *rules, uint32_t alertMask);
+
+#endif
@@ -0,0 +1,333 @@
+/**
+ * Serve Pipeline for Fraud Detection System
+ * The TXN request path shared by the one-shot CLI, --serve and the
+ * benchmarks: validate, debit and score, store and journal, then answer
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include "serve_pipeline.h"
+#include "account_store.h"
+#include "fraud_engine.h"
+#include "alert_codes.h"
+#include "journal.h"
+#include "location_table.h"
+#include "metrics.h"
+#include "alert_outbox.h"
+
+#define PARALLEL_SEGMENT_MIN 16     // shorter runs of TXN requests are processed inline
+
+void printError(JsonWriter *out, const char *error) {
+    jsonWriteLiteral(out, "{\"success\": false, \"error\": ");
+    jsonWriteString(out, error);
+    jsonWriteLiteral(out, "}\n");
+}
+
+void printJsonResponse(JsonWriter *out, Transaction *txn, double remainingBalance) {
+    jsonWriteLiteral(out, "{\"success\": true, \"transaction\": {");
+    jsonWriteLiteral(out, "\"id\": ");
+    jsonWriteInt(out, txn->txnId);
+    jsonWriteLiteral(out, ", \"accNo\": ");
+    jsonWriteInt(out, txn->accNo);
+    jsonWriteLiteral(out, ", \"amount\": ");
+    jsonWriteFixed2(out, txn->amount);
+    jsonWriteLiteral(out, ", \"location\": ");
+    jsonWriteString(out, locationName(txn->location));
+    jsonWriteLiteral(out, ", \"timestamp\": ");
+    jsonWriteInt(out, (long)txn->timestamp);
+    jsonWriteLiteral(out, ", \"riskScore\": ");
+    jsonWriteInt(out, txn->riskScore);
+    jsonWriteLiteral(out, ", \"ruleVersion\": ");
+    jsonWriteInt(out, txn->ruleVersion);
+    jsonWriteLiteral(out, ", \"status\": ");
+    jsonWriteString(out, txnStatusName(txn->status));
+    jsonWriteLiteral(out, ", \"remainingBalance\": ");
+    jsonWriteFixed2(out, remainingBalance);
+    jsonWriteLiteral(out, ", \"alerts\": [");
+    
+    if (txn->alertMask) {
+        writeAlertList(out, txn->alertMask);
+    } else {
+        jsonWriteString(out, NO_FRAUD_MESSAGE);
+    }
+    
+    jsonWriteLiteral(out, "]}}\n");
+}
+
+int prepareTransaction(JsonWriter *out, int accNo, double amount, const char *location, time_t now,
+                       Transaction *txn, double *remainingBalance) {
+    METRICS_START_SAMPLED(mark);
+
+    if (accNo <= 0) {
+        printError(out, "Invalid account number");
+        return 0;
+    }
+    
+    if (amount <= 0) {
+        printError(out, "Invalid amount");
+        return 0;
+    }
+
+    // Find account and validate
+    Account *acc = findAccount(&accountStore, accNo);
+    METRICS_LAP(STAGE_ACCOUNT_LOOKUP, mark);
+    
+    if (!acc) {
+        printError(out, "Account not found");
+        return 0;
+    }
+    
+    if (acc->balance < amount) {
+        printError(out, "Insufficient balance");
+        return 0;
+    }
+
+    // Create transaction
+    memset(txn, 0, sizeof(*txn));
+    txn->txnId = allocateTxnId();
+    txn->accNo = accNo;
+    txn->amount = amount;
+    txn->location = internLocation(location);
+    txn->timestamp = now;
+    txn->type = TXN_TYPE_PURCHASE;
+    
+    // Update account balance
+    acc->balance -= amount;
+    *remainingBalance = acc->balance;
+    
+    // Check for fraud against whichever rule set is current
+    const CompiledRules *rules = acquireRules();
+    checkFraud(rules, acc, txn);
+    releaseRules();
+    return 1;
+}
+
+void commitTransaction(const Transaction *txn, double remainingBalance) {
+    METRICS_START_SAMPLED(mark);
+    if (!storeTransaction(txn)) {
+        fprintf(stderr, "Warning: could not grow transaction history\n");
+    }
+    journalAppendTransaction(txn, remainingBalance);
+    METRICS_LAP(STAGE_PERSIST, mark);
+
+    // Notification delivery happens elsewhere, from the outbox
+    publishAlert(txn);
+}
+
+int performTransaction(JsonWriter *out, int accNo, double amount, const char *location) {
+    METRICS_START_SAMPLED(started);
+    Transaction txn;
+    double remainingBalance;
+
+    if (!prepareTransaction(out, accNo, amount, location, time(NULL), &txn, &remainingBalance)) return 0;
+    commitTransaction(&txn, remainingBalance);
+    
+    // Print JSON response
+    METRICS_START_FROM(mark, started);
+    METRICS_RESTART(mark);
+    printJsonResponse(out, &txn, remainingBalance);
+    METRICS_LAP(STAGE_SERIALIZE, mark);
+    METRICS_SPAN(STAGE_REQUEST, started, mark);
+    return 1;
+}
+
+int parseTxnArgs(const char *args, int *accNo, double *amount, const char **location) {
+    int offset = 0;
+    if (sscanf(args, "%d %lf %n", accNo, amount, &offset) != 2 || args[offset] == '\0') return 0;
+    *location = args + offset;
+    return 1;
+}
+
+// One TXN request of the segment being processed
+typedef struct {
+    int accNo;
+    double amount;
+    const char *location;       // into the read buffer
+    int accepted;               // txn was debited and scored and must be stored
+    Transaction txn;
+    double remainingBalance;
+    int worker;                 // whose output holds the response
+    size_t responseStart;
+    size_t responseLength;
+} TxnSlot;
+
+typedef struct {
+    pthread_t thread;
+    int *slots;                 // this worker's slot indices, request order
+    int count;
+    JsonWriter out;             // in memory; copied out in request order
+} ServeWorker;
+
+/**
+ * Consecutive TXN requests form a segment. Each account hashes to one
+ * worker, which is the only writer of that account's balance and velocity
+ * state while the segment runs, so accounts proceed in parallel and each
+ * one's requests in order. History and journal appends stay on the serve
+ * thread, which stores the results in request order once all workers are
+ * done. Other commands run between segments, so they never see a half
+ * processed one.
+ */
+typedef struct {
+    TxnSlot slots[MAX_SEGMENT_TXNS];
+    int slotCount;
+    time_t now;                 // one timestamp per segment keeps history time-ordered
+    ServeWorker *workers;       // workers[0] is the serve thread itself
+    int workerCount;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned generation;        // bumped once per parallel segment
+    int running;                // helper threads still on the current segment
+    int stopping;
+} ServePool;
+
+static ServePool servePool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER
+};
+
+static void prepareSlots(ServeWorker *worker) {
+    for (int i = 0; i < worker->count; i++) {
+        TxnSlot *slot = &servePool.slots[worker->slots[i]];
+        slot->responseStart = worker->out.length;
+        slot->accepted = prepareTransaction(&worker->out, slot->accNo, slot->amount, slot->location,
+                                            servePool.now, &slot->txn, &slot->remainingBalance);
+        if (slot->accepted) printJsonResponse(&worker->out, &slot->txn, slot->remainingBalance);
+        slot->responseLength = worker->out.length - slot->responseStart;
+    }
+}
+
+static void *serveWorkerMain(void *arg) {
+    ServeWorker *worker = arg;
+    unsigned seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&servePool.lock);
+        while (servePool.generation == seen && !servePool.stopping) {
+            pthread_cond_wait(&servePool.start, &servePool.lock);
+        }
+        if (servePool.stopping) {
+            pthread_mutex_unlock(&servePool.lock);
+            break;
+        }
+        seen = servePool.generation;
+        pthread_mutex_unlock(&servePool.lock);
+
+        prepareSlots(worker);
+
+        pthread_mutex_lock(&servePool.lock);
+        if (--servePool.running == 0) pthread_cond_signal(&servePool.done);
+        pthread_mutex_unlock(&servePool.lock);
+    }
+    return NULL;
+}
+
+void startServeWorkers(int threadCount) {
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > MAX_SERVE_THREADS) threadCount = MAX_SERVE_THREADS;
+
+    servePool.workerCount = 1;
+    servePool.workers = calloc((size_t)threadCount, sizeof(ServeWorker));
+    if (!servePool.workers) return;
+
+    // Helpers leave SIGHUP to the serve thread, whose read() it interrupts
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+    for (int i = 0; i < threadCount; i++) {
+        ServeWorker *worker = &servePool.workers[i];
+        jsonWriterInit(&worker->out, -1);
+        worker->slots = malloc(MAX_SEGMENT_TXNS * sizeof(int));
+        if (!worker->slots || (i > 0 && pthread_create(&worker->thread, NULL, serveWorkerMain, worker) != 0)) {
+            fprintf(stderr, "Warning: serving with %d of %d threads\n", i > 0 ? i : 1, threadCount);
+            break;
+        }
+        servePool.workerCount = i + 1;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+void stopServeWorkers() {
+    pthread_mutex_lock(&servePool.lock);
+    servePool.stopping = 1;
+    pthread_cond_broadcast(&servePool.start);
+    pthread_mutex_unlock(&servePool.lock);
+
+    for (int i = 0; servePool.workers && i < servePool.workerCount; i++) {
+        if (i > 0) pthread_join(servePool.workers[i].thread, NULL);
+        free(servePool.workers[i].slots);
+        jsonWriterFree(&servePool.workers[i].out);
+    }
+    free(servePool.workers);
+    servePool.workers = NULL;
+}
+
+void runSegment(JsonWriter *out) {
+    int count = servePool.slotCount;
+    servePool.slotCount = 0;
+    if (count == 0) return;
+
+    // Waking the workers costs more than a few requests take
+    if (servePool.workerCount == 1 || count < PARALLEL_SEGMENT_MIN) {
+        for (int i = 0; i < count; i++) {
+            TxnSlot *slot = &servePool.slots[i];
+            performTransaction(out, slot->accNo, slot->amount, slot->location);
+        }
+        return;
+    }
+
+    // Same Fibonacci hash as the account store and batch routing
+    for (int i = 0; i < servePool.workerCount; i++) {
+        servePool.workers[i].count = 0;
+        servePool.workers[i].out.length = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        uint32_t hash = (uint32_t)servePool.slots[i].accNo * 2654435769u;
+        int shard = (int)((hash >> 16) % (uint32_t)servePool.workerCount);
+        ServeWorker *worker = &servePool.workers[shard];
+        worker->slots[worker->count++] = i;
+        servePool.slots[i].worker = shard;
+    }
+    servePool.now = time(NULL);
+
+    pthread_mutex_lock(&servePool.lock);
+    servePool.generation++;
+    servePool.running = servePool.workerCount - 1;
+    pthread_cond_broadcast(&servePool.start);
+    pthread_mutex_unlock(&servePool.lock);
+
+    prepareSlots(&servePool.workers[0]);
+
+    pthread_mutex_lock(&servePool.lock);
+    while (servePool.running > 0) {
+        pthread_cond_wait(&servePool.done, &servePool.lock);
+    }
+    pthread_mutex_unlock(&servePool.lock);
+
+    for (int i = 0; i < count; i++) {
+        TxnSlot *slot = &servePool.slots[i];
+        if (slot->accepted) commitTransaction(&slot->txn, slot->remainingBalance);
+        jsonWriteRaw(out, servePool.workers[slot->worker].out.data + slot->responseStart, slot->responseLength);
+    }
+}
+
+int queueTxnRequest(JsonWriter *out, char *line) {
+    char command[16];
+    int consumed = 0;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    if (sscanf(line, "%15s%n", command, &consumed) != 1 || strcmp(command, "TXN") != 0) return 0;
+
+    if (servePool.slotCount == MAX_SEGMENT_TXNS) runSegment(out);
+    TxnSlot *slot = &servePool.slots[servePool.slotCount];
+    if (!parseTxnArgs(line + consumed, &slot->accNo, &slot->amount, &slot->location)) return 0;
+    servePool.slotCount++;
+    return 1;
+}
@@ -0,0 +1,70 @@
+/**
+ * Serve Pipeline for Fraud Detection System
+ * The TXN request path shared by the one-shot CLI, --serve and the
+ * benchmarks: validate, debit and score, store and journal, then answer
+ */
+
+#ifndef SERVE_PIPELINE_H
+#define SERVE_PIPELINE_H
+
+#include <time.h>
+#include "transaction_log.h"
+#include "json_writer.h"
+
+#define READ_BUFFER_SIZE (64 * 1024)
+#define MAX_SERVE_THREADS 64
+#define MAX_SEGMENT_TXNS (READ_BUFFER_SIZE / 8)     // "TXN 1 1 X\n" is the shortest request
+
+void printError(JsonWriter *out, const char *error);
+
+/**
+ * Responses are written on a single line so the same output works for the
+ * one-shot CLI and for the line-delimited --serve protocol.
+ */
+void printJsonResponse(JsonWriter *out, Transaction *txn, double remainingBalance);
+
+/**
+ * Validate, debit and score one transaction into txn. Touches only its
+ * own account, so different accounts can be prepared concurrently; the
+ * caller stores the result. Rejections write their error response and
+ * return 0.
+ */
+int prepareTransaction(JsonWriter *out, int accNo, double amount, const char *location, time_t now,
+                       Transaction *txn, double *remainingBalance);
+
+/**
+ * Store a prepared transaction, queue it for the next journal commit and
+ * hand its alert to the outbox
+ */
+void commitTransaction(const Transaction *txn, double remainingBalance);
+
+/**
+ * Prepare, commit and answer one transaction. Returns 0 if it was rejected.
+ */
+int performTransaction(JsonWriter *out, int accNo, double amount, const char *location);
+
+/**
+ * TXN <accNo> <amount> <location>; location points into args
+ */
+int parseTxnArgs(const char *args, int *accNo, double *amount, const char **location);
+
+/**
+ * Start threadCount - 1 helper threads; the calling thread is the last
+ * worker. Falls back to fewer workers if threads or memory run out.
+ */
+void startServeWorkers(int threadCount);
+void stopServeWorkers();
+
+/**
+ * Add a well-formed TXN request line to the current segment. Returns 0 for
+ * anything else, which the caller handles after running the segment.
+ */
+int queueTxnRequest(JsonWriter *out, char *line);
+
+/**
+ * Process the queued TXN requests and append their responses to out in
+ * request order. The caller commits the journal before releasing them.
+ */
+void runSegment(JsonWriter *out);
+
+#endif
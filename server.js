@@ -1,5 +1,6 @@
 const express = require('express');
-const { exec } = require('child_process');
+const { spawn } = require('child_process');
+const readline = require('readline');
 const path = require('path');
 const fs = require('fs');
 const twilio = require('twilio');
@@ -39,7 +40,54 @@ app.use((req, res, next) => {
 // Check if C backend exists
 if (!fs.existsSync('./fraudbackend')) {
     console.log('⚠️  C backend not found. Please compile fraudbackend.c first.');
-    console.log('Run: gcc -o fraudbackend fraudbackend.c -lm');
+    console.log('Run: ./compile.sh');
+}
+
+// Persistent C backend (./fraudbackend --serve). One request line in, one
+// JSON line out, answered in order, so pending requests form a FIFO queue.
+let backendProcess = null;
+const pendingRequests = [];
+
+function startBackend() {
+    if (!fs.existsSync('./fraudbackend')) return null;
+
+    const child = spawn('./fraudbackend', ['--serve'], { stdio: ['pipe', 'pipe', 'inherit'] });
+    const lines = readline.createInterface({ input: child.stdout });
+
+    lines.on('line', (line) => {
+        const request = pendingRequests.shift();
+        if (!request) return;
+        try {
+            request.resolve(JSON.parse(line));
+        } catch (parseError) {
+            request.reject(parseError);
+        }
+    });
+
+    child.on('error', (error) => {
+        console.error('❌ C backend failed to start:', error.message);
+    });
+
+    child.on('exit', (code) => {
+        console.log(`⚠️  C backend exited with code ${code}`);
+        backendProcess = null;
+        while (pendingRequests.length > 0) {
+            pendingRequests.shift().reject(new Error('C backend exited'));
+        }
+    });
+
+    console.log('✅ C backend running in persistent mode');
+    return child;
+}
+
+function queryBackend(requestLine) {
+    return new Promise((resolve, reject) => {
+        if (!backendProcess) backendProcess = startBackend();
+        if (!backendProcess) return reject(new Error('C backend not available'));
+
+        pendingRequests.push({ resolve, reject });
+        backendProcess.stdin.write(requestLine + '\n');
+    });
 }
 
 // Serve the main HTML file
@@ -54,43 +102,37 @@ app.post('/api/process-transaction', async (req, res) => {
     console.log(`📊 Processing transaction: Account ${accNo}, Amount $${amount}, Location ${location}`);
     
     try {
-        // Execute the C program
-        const command = `./fraudbackend ${accNo} ${amount} "${location}" "${mobileNumber}" "${emailAddress}"`;
-        
-        exec(command, async (error, stdout, stderr) => {
-            if (error) {
-                console.error('❌ C backend error:', error);
-                console.log('🔄 Falling back to JavaScript simulation...');
-                
-                // Fallback to JavaScript simulation
-                const jsResult = simulateBackend(accNo, amount, location, mobileNumber, emailAddress);
-                
-                // Send alerts based on risk score
-                if (jsResult.transaction.riskScore >= 20) {
-                    await sendAlerts(jsResult.transaction);
-                }
-                
-                return res.json(jsResult);
-            }
-            
-            try {
-                // Parse the JSON output from C program
-                const result = JSON.parse(stdout);
-                console.log('✅ C backend result - Risk Score:', result.transaction.riskScore);
-                
-                // Send alerts based on risk score
-                if (result.transaction.riskScore >= 20) {
-                    await sendAlerts(result.transaction);
-                }
-                
-                res.json(result);
-            } catch (parseError) {
-                console.error('❌ Parse error:', parseError);
-                // Fallback to JavaScript
-                const jsResult = simulateBackend(accNo, amount, location, mobileNumber, emailAddress);
-                res.json(jsResult);
-            }
-        });
+        // Newlines would split the request across protocol lines
+        const safeLocation = String(location).replace(/[\r\n]+/g, ' ').trim();
+        let result;
+        let fromBackend = true;
+
+        try {
+            result = await queryBackend(`TXN ${parseInt(accNo)} ${parseFloat(amount)} ${safeLocation}`);
+        } catch (error) {
+            console.error('❌ C backend error:', error.message);
+            console.log('🔄 Falling back to JavaScript simulation...');
+            result = simulateBackend(accNo, amount, location, mobileNumber, emailAddress);
+            fromBackend = false;
+        }
+
+        if (!result.success) {
+            return res.json(result);
+        }
+
+        console.log('✅ Backend result - Risk Score:', result.transaction.riskScore);
+        result.transaction.phone = mobileNumber;
+        result.transaction.email = emailAddress;
+
+        // Alerts never hold up the response: the C backend queues them in
+        // the outbox for dispatchOutbox(), which needs the contact details;
+        // simulated results have no outbox and are sent in the background
+        saveAlertContact(result.transaction.accNo, { phone: mobileNumber, email: emailAddress });
+        if (!fromBackend && result.transaction.riskScore >= 20) {
+            sendAlerts(result.transaction).catch((error) => console.error('Alert sending error:', error));
+        }
+
+        res.json(result);
     } catch (error) {
         console.error('❌ Transaction processing error:', error);
         res.status(500).json({ 
@@ -230,6 +272,140 @@ async function sendAlerts(transaction) {
     return results;
 }
 
+// Outbox dispatcher: the C backend appends alert events to data/alerts.outbox
+// off its response path. They are delivered from here, one line at a time,
+// and the consumed offset is saved after each line, so delivery resumes
+// after a restart and an event is sent at least once. Lines that are not
+// valid JSON are moved to data/alerts.outbox.dead instead of blocking the
+// lines behind them. Contact details come from each account's latest
+// request and are kept in data/alert_contacts.json; events for accounts
+// with no known contact wait in data/alerts.outbox.pending and are retried
+// on every poll.
+const OUTBOX_FILE = path.join(__dirname, 'data', 'alerts.outbox');
+const OUTBOX_OFFSET_FILE = OUTBOX_FILE + '.offset';
+const OUTBOX_DEAD_FILE = OUTBOX_FILE + '.dead';
+const OUTBOX_PENDING_FILE = OUTBOX_FILE + '.pending';
+const CONTACTS_FILE = path.join(__dirname, 'data', 'alert_contacts.json');
+const OUTBOX_POLL_MS = 1000;
+const alertContacts = loadAlertContacts();  // accNo -> { phone, email }
+let dispatchingOutbox = false;
+
+function loadAlertContacts() {
+    try {
+        const saved = JSON.parse(fs.readFileSync(CONTACTS_FILE, 'utf8'));
+        return new Map(Object.entries(saved).map(([accNo, contact]) => [Number(accNo), contact]));
+    } catch (error) {
+        if (error.code !== 'ENOENT') console.error('❌ Could not load alert contacts:', error.message);
+        return new Map();
+    }
+}
+
+function saveAlertContact(accNo, contact) {
+    const known = alertContacts.get(accNo);
+    if (known && known.phone === contact.phone && known.email === contact.email) return;
+    alertContacts.set(accNo, contact);
+
+    try {
+        const temp = CONTACTS_FILE + '.tmp';
+        fs.writeFileSync(temp, JSON.stringify(Object.fromEntries(alertContacts), null, 2));
+        fs.renameSync(temp, CONTACTS_FILE);
+    } catch (error) {
+        console.error('❌ Could not save alert contacts:', error.message);
+    }
+}
+
+function readOutboxOffset() {
+    try {
+        return parseInt(fs.readFileSync(OUTBOX_OFFSET_FILE, 'utf8'), 10) || 0;
+    } catch (error) {
+        return 0;
+    }
+}
+
+// Returns false when the account has no contact details yet
+async function sendOutboxEvent(event) {
+    const contact = alertContacts.get(event.accNo);
+    if (!contact) return false;
+    await sendAlerts({ ...event, id: event.txnId, phone: contact.phone, email: contact.email });
+    return true;
+}
+
+async function dispatchOutboxLine(line) {
+    let event;
+    try {
+        event = JSON.parse(line);
+    } catch (error) {
+        console.error(`❌ Malformed outbox line moved to ${path.basename(OUTBOX_DEAD_FILE)}: ${error.message}`);
+        fs.appendFileSync(OUTBOX_DEAD_FILE, line + '\n');
+        return;
+    }
+
+    if (!(await sendOutboxEvent(event))) {
+        console.log(`📭 No contact details for account ${event.accNo}, alert for transaction ${event.txnId} kept pending`);
+        fs.appendFileSync(OUTBOX_PENDING_FILE, line + '\n');
+    }
+}
+
+// Retry pending events; those still without contact details stay pending
+async function dispatchPendingAlerts() {
+    if (!fs.existsSync(OUTBOX_PENDING_FILE)) return;
+
+    const lines = fs.readFileSync(OUTBOX_PENDING_FILE, 'utf8').split('\n').filter(Boolean);
+    const waiting = [];
+    let next = 0;
+    try {
+        for (; next < lines.length; next++) {
+            if (!(await sendOutboxEvent(JSON.parse(lines[next])))) waiting.push(lines[next]);
+        }
+    } finally {
+        // A failed send keeps its event and everything after it
+        waiting.push(...lines.slice(next));
+        if (waiting.length !== lines.length) {
+            const temp = OUTBOX_PENDING_FILE + '.tmp';
+            fs.writeFileSync(temp, waiting.map((line) => line + '\n').join(''));
+            fs.renameSync(temp, OUTBOX_PENDING_FILE);
+        }
+    }
+}
+
+async function dispatchOutbox() {
+    if (dispatchingOutbox) return;
+    dispatchingOutbox = true;
+
+    try {
+        await dispatchPendingAlerts();
+        if (!fs.existsSync(OUTBOX_FILE)) return;
+
+        let offset = readOutboxOffset();
+        const size = fs.statSync(OUTBOX_FILE).size;
+        if (size < offset) offset = 0;      // the outbox was replaced
+        if (size === offset) return;
+
+        const buffer = Buffer.alloc(size - offset);
+        const fd = fs.openSync(OUTBOX_FILE, 'r');
+        fs.readSync(fd, buffer, 0, buffer.length, offset);
+        fs.closeSync(fd);
+
+        // Whole lines only; a line still being written is read next time.
+        // A failed send leaves its line unconsumed and stops the batch.
+        let start = 0;
+        let end;
+        while ((end = buffer.indexOf(0x0a, start)) !== -1) {
+            if (end > start) {
+                await dispatchOutboxLine(buffer.toString('utf8', start, end));
+            }
+            start = end + 1;
+            fs.writeFileSync(OUTBOX_OFFSET_FILE, String(offset + start));
+        }
+    } catch (error) {
+        console.error('❌ Outbox dispatch error:', error.message);
+    } finally {
+        dispatchingOutbox = false;
+    }
+}
+
+setInterval(dispatchOutbox, OUTBOX_POLL_MS);
+
 // Manual alert endpoints
 app.post('/api/send-sms', async (req, res) => {
     try {
@@ -388,6 +564,40 @@ app.get('/api/services/config', (req, res) => {
     });
 });
 
+// Prometheus scrape endpoint, backed by the persistent C backend
+app.get('/metrics', async (req, res) => {
+    try {
+        const result = await queryBackend('METRICS');
+        res.type('text/plain; version=0.0.4').send(result.metrics || '');
+    } catch (error) {
+        res.status(503).type('text/plain').send(`# C backend unavailable: ${error.message}\n`);
+    }
+});
+
+// Paginated transaction history: ?accNo=&from=&to=&status=&cursor=&limit=
+app.get('/api/history', async (req, res) => {
+    const fields = { accNo: 'ACCOUNT', from: 'FROM', to: 'TO', cursor: 'CURSOR', limit: 'LIMIT' };
+    let request = 'HISTORY';
+    for (const [param, keyword] of Object.entries(fields)) {
+        if (req.query[param] === undefined) continue;
+        const value = parseInt(req.query[param], 10);
+        if (isNaN(value)) {
+            return res.status(400).json({ success: false, error: `Invalid ${param}` });
+        }
+        request += ` ${keyword} ${value}`;
+    }
+    if (req.query.status === 'clean' || req.query.status === 'suspicious') {
+        request += ` STATUS ${req.query.status}`;
+    }
+
+    try {
+        const result = await queryBackend(request);
+        res.status(result.success === false ? 400 : 200).json(result);
+    } catch (error) {
+        res.status(503).json({ success: false, error: `C backend unavailable: ${error.message}` });
+    }
+});
+
 // Health check endpoint
 app.get('/api/health', (req, res) => {
     res.json({
@@ -0,0 +1,856 @@
+/**
+ * State Snapshot for Fraud Detection System
+ * Versioned, checksummed binary image of the accounts, the in-memory
+ * part of the columnar history and its indexes, loaded by mmap without
+ * per-record parsing. Sealed rows stay in the history segments.
+ *
+ * The same format without rows holds what the history has folded into
+ * the accounts and statistics, saved next to the JSON files.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "snapshot.h"
+#include "account_store.h"
+#include "transaction_log.h"
+#include "statistics.h"
+#include "history_index.h"
+#include "history_segments.h"
+#include "location_table.h"
+#include "util.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define SNAPSHOT_HAVE_SSE42 1
+#endif
+
+#define SNAPSHOT_MAGIC 0x50414E53u    // "SNAP"
+#define SNAPSHOT_VERSION 6
+#define SNAPSHOT_ALIGN 64
+#define SNAPSHOT_BUFFER (256 * 1024)
+
+typedef enum {
+    SECTION_STRINGS = 0,        // NUL-terminated names; offset 0 is ""
+    SECTION_LOCATION_NAMES,     // uint32 string offset per LocationId
+    SECTION_ACCOUNT_TYPES,      // uint32 string offset per account type ID
+    SECTION_ACCOUNTS,           // SnapshotAccount per account, store order
+    SECTION_STATISTICS,         // TxnStatistics
+    SECTION_TXN_IDS,            // one section per TransactionColumns column
+    SECTION_TXN_ACC_NOS,
+    SECTION_TXN_AMOUNTS,
+    SECTION_TXN_TIMESTAMPS,
+    SECTION_TXN_ALERT_MASKS,
+    SECTION_TXN_RISK_SCORES,
+    SECTION_TXN_STATUSES,
+    SECTION_TXN_TYPES,
+    SECTION_TXN_LOCATIONS,
+    SECTION_TXN_RULE_VERSIONS,
+    SECTION_INDEX_ACCOUNTS,     // SnapshotAccountRows per indexed account
+    SECTION_INDEX_ROWS,         // account row lists, then status row lists
+    SECTION_INDEX_BLOCKS,       // TimeBlock per HISTORY_BLOCK_ROWS rows from firstRow's
+    SECTION_COUNT
+} SnapshotSectionId;
+
+typedef enum {
+    SNAPSHOT_KIND_FULL = 0,     // accounts, in-memory rows and indexes
+    SNAPSHOT_KIND_STATE,        // accounts and statistics only, see saveHistoryState()
+} SnapshotKind;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+    uint32_t checksum;          // CRC32C of the section bytes
+    uint32_t reserved;
+} SnapshotSection;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    int64_t createdAt;
+    int32_t kind;               // SnapshotKind
+    int32_t reserved;
+    int64_t newestTime;         // latest timestamp stored
+    int32_t accountCount;
+    int32_t txnCount;
+    int32_t firstRow;           // rows below it are in the history segments
+    int32_t lastTxnId;
+    int32_t timeOrdered;
+    int32_t locationCount;
+    int32_t accountTypeCount;
+    int32_t indexAccountCount;
+    int32_t blockCount;
+    int32_t statusRowCount[TXN_STATUS_COUNT];
+    SnapshotSection sections[SECTION_COUNT];
+    uint32_t checksum;          // CRC32C of the header up to this field
+} SnapshotHeader;
+
+// Account with fixed-width fields and string offsets in place of pointers
+typedef struct {
+    int32_t accNo;
+    uint32_t nameOffset;
+    uint32_t accountTypeOffset;
+    int32_t transactionCount;
+    double balance;
+    double dailyLimit;
+    double monthlyLimit;
+    double dailySpent;
+    double monthlySpent;
+    int64_t lastTxnTime;
+    uint16_t lastLocation;
+    uint16_t reserved;
+    int32_t isActive;
+    int32_t recentHead;
+    int32_t recentCount;
+    int32_t spendDay;
+    int32_t spendMonth;
+    int64_t recentTimestamps[RECENT_TXN_CAPACITY];
+    double recentAmounts[RECENT_TXN_CAPACITY];
+    uint32_t profileCount;
+    uint32_t profileHourTotal;
+    double profileMeanAmount;
+    double profileAmountM2;
+    double profileRateSum;
+    int64_t profileRateTime;
+    int64_t profileSince;
+    uint16_t profileHourCounts[PROFILE_HOURS];
+    uint16_t profileTopLocations[PROFILE_TOP_LOCATIONS];
+    uint32_t profileLocationCounts[PROFILE_TOP_LOCATIONS];
+} SnapshotAccount;
+
+typedef struct {
+    int32_t accNo;
+    int32_t count;
+    int64_t firstRow;           // into SECTION_INDEX_ROWS
+} SnapshotAccountRows;
+
+typedef struct {
+    int fd;
+    uint64_t offset;            // file position, buffered bytes included
+    uint32_t crc;               // running CRC32C of the open section
+    int failed;
+    size_t used;
+    char buffer[SNAPSHOT_BUFFER];
+} SnapshotWriter;
+
+static char *snapshotBase = NULL;
+static size_t snapshotSize = 0;
+static pid_t snapshotChild = -1;
+
+// ==================== CHECKSUM ====================
+
+typedef uint32_t (*CrcKernel)(uint32_t crc, const void *data, size_t length);
+
+static uint32_t crc32cTable[256];
+
+static uint32_t crc32cScalar(uint32_t crc, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        crc = crc32cTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef SNAPSHOT_HAVE_SSE42
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t crc, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    uint64_t state = crc;
+
+    for (; length >= 8; bytes += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        state = _mm_crc32_u64(state, word);
+    }
+    crc = (uint32_t)state;
+    for (; length > 0; bytes++, length--) {
+        crc = _mm_crc32_u8(crc, *bytes);
+    }
+    return crc;
+}
+
+#endif
+
+static CrcKernel selectCrcKernel() {
+    static CrcKernel kernel = NULL;
+    if (!kernel) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0x82F63B78u ^ (c >> 1) : c >> 1;
+            }
+            crc32cTable[i] = c;
+        }
+#ifdef SNAPSHOT_HAVE_SSE42
+        kernel = __builtin_cpu_supports("sse4.2") ? crc32cHardware : crc32cScalar;
+#else
+        kernel = crc32cScalar;
+#endif
+    }
+    return kernel;
+}
+
+static uint32_t crc32c(const void *data, size_t length) {
+    return selectCrcKernel()(0xFFFFFFFFu, data, length) ^ 0xFFFFFFFFu;
+}
+
+uint32_t snapshotChecksum(const void *data, size_t length) {
+    return crc32c(data, length);
+}
+
+// ==================== WRITING ====================
+
+static void flushWriter(SnapshotWriter *w) {
+    if (w->used > 0 && !w->failed && !writeAll(w->fd, w->buffer, w->used)) w->failed = 1;
+    w->used = 0;
+}
+
+static void writeBytes(SnapshotWriter *w, const void *data, size_t length) {
+    w->crc = selectCrcKernel()(w->crc, data, length);
+    w->offset += length;
+
+    // Columns go straight to the file; small records collect in the buffer
+    if (length > SNAPSHOT_BUFFER - w->used) {
+        flushWriter(w);
+        if (length >= SNAPSHOT_BUFFER) {
+            if (!w->failed && !writeAll(w->fd, data, length)) w->failed = 1;
+            return;
+        }
+    }
+    memcpy(w->buffer + w->used, data, length);
+    w->used += length;
+}
+
+static void writeString(SnapshotWriter *w, const char *text) {
+    writeBytes(w, text, strlen(text) + 1);
+}
+
+static void beginSection(SnapshotWriter *w, SnapshotHeader *header, SnapshotSectionId id) {
+    static const char zeros[SNAPSHOT_ALIGN];
+    size_t padding = (SNAPSHOT_ALIGN - w->offset % SNAPSHOT_ALIGN) % SNAPSHOT_ALIGN;
+    writeBytes(w, zeros, padding);
+    header->sections[id].offset = w->offset;
+    w->crc = 0xFFFFFFFFu;
+}
+
+static void endSection(SnapshotWriter *w, SnapshotHeader *header, SnapshotSectionId id) {
+    header->sections[id].length = w->offset - header->sections[id].offset;
+    header->sections[id].checksum = w->crc ^ 0xFFFFFFFFu;
+}
+
+// In-memory rows in row order, unwrapping the ring
+#define WRITE_COLUMN(id, column) do { \
+        beginSection(w, header, id); \
+        for (int run = 0; run < runCount; run++) { \
+            writeBytes(w, txnColumns.column + runs[run].start, (size_t)runs[run].count * sizeof(*txnColumns.column)); \
+        } \
+        endSection(w, header, id); \
+    } while (0)
+
+/**
+ * Strings first, then the tables pointing into them. The offset counter
+ * replays the order the strings were written in.
+ */
+static void writeSections(SnapshotWriter *w, SnapshotHeader *header) {
+    beginSection(w, header, SECTION_STRINGS);
+    writeBytes(w, "", 1);
+    for (int id = 1; id < locationTable.count; id++) writeString(w, locationName((LocationId)id));
+    for (int type = 1; type < accountTypeCount(); type++) writeString(w, accountTypeName(type));
+    for (int i = 0; i < accountStore.count; i++) {
+        writeString(w, accountStore.accounts[i].name);
+        writeString(w, accountStore.accounts[i].accountType);
+    }
+    endSection(w, header, SECTION_STRINGS);
+
+    uint32_t stringOffset = 1;
+    uint32_t empty = 0;
+    beginSection(w, header, SECTION_LOCATION_NAMES);
+    writeBytes(w, &empty, sizeof(empty));
+    for (int id = 1; id < locationTable.count; id++) {
+        writeBytes(w, &stringOffset, sizeof(stringOffset));
+        stringOffset += (uint32_t)strlen(locationName((LocationId)id)) + 1;
+    }
+    endSection(w, header, SECTION_LOCATION_NAMES);
+
+    beginSection(w, header, SECTION_ACCOUNT_TYPES);
+    writeBytes(w, &empty, sizeof(empty));
+    for (int type = 1; type < accountTypeCount(); type++) {
+        writeBytes(w, &stringOffset, sizeof(stringOffset));
+        stringOffset += (uint32_t)strlen(accountTypeName(type)) + 1;
+    }
+    endSection(w, header, SECTION_ACCOUNT_TYPES);
+
+    beginSection(w, header, SECTION_ACCOUNTS);
+    for (int i = 0; i < accountStore.count; i++) {
+        const Account *account = &accountStore.accounts[i];
+        SnapshotAccount record;
+        memset(&record, 0, sizeof(record));
+        record.accNo = account->accNo;
+        record.nameOffset = stringOffset;
+        stringOffset += (uint32_t)strlen(account->name) + 1;
+        record.accountTypeOffset = stringOffset;
+        stringOffset += (uint32_t)strlen(account->accountType) + 1;
+        record.transactionCount = account->transactionCount;
+        record.balance = account->balance;
+        record.dailyLimit = account->dailyLimit;
+        record.monthlyLimit = account->monthlyLimit;
+        record.dailySpent = account->dailySpent;
+        record.monthlySpent = account->monthlySpent;
+        record.lastTxnTime = (int64_t)account->lastTxnTime;
+        record.lastLocation = account->lastLocation;
+        record.isActive = account->isActive;
+        record.recentHead = account->recent.head;
+        record.recentCount = account->recent.count;
+        record.spendDay = account->spendDay;
+        record.spendMonth = account->spendMonth;
+        for (int slot = 0; slot < RECENT_TXN_CAPACITY; slot++) {
+            record.recentTimestamps[slot] = (int64_t)account->recent.timestamps[slot];
+            record.recentAmounts[slot] = account->recent.amounts[slot];
+        }
+        const BehaviorProfile *profile = &account->profile;
+        record.profileCount = profile->count;
+        record.profileHourTotal = profile->hourTotal;
+        record.profileMeanAmount = profile->meanAmount;
+        record.profileAmountM2 = profile->amountM2;
+        record.profileRateSum = profile->rateSum;
+        record.profileRateTime = (int64_t)profile->rateTime;
+        record.profileSince = (int64_t)profile->since;
+        memcpy(record.profileHourCounts, profile->hourCounts, sizeof(record.profileHourCounts));
+        for (int i = 0; i < PROFILE_TOP_LOCATIONS; i++) {
+            record.profileTopLocations[i] = profile->topLocations[i];
+            record.profileLocationCounts[i] = profile->locationCounts[i];
+        }
+        writeBytes(w, &record, sizeof(record));
+    }
+    endSection(w, header, SECTION_ACCOUNTS);
+
+    beginSection(w, header, SECTION_STATISTICS);
+    writeBytes(w, &txnStatistics, sizeof(txnStatistics));
+    endSection(w, header, SECTION_STATISTICS);
+
+    // A state snapshot has every row section and index empty
+    int full = (header->kind == SNAPSHOT_KIND_FULL);
+    SlotRun runs[2];
+    int runCount = full ? hotSlotRuns(txnColumns.firstRow, txnCount, runs) : 0;
+    WRITE_COLUMN(SECTION_TXN_IDS, txnIds);
+    WRITE_COLUMN(SECTION_TXN_ACC_NOS, accNos);
+    WRITE_COLUMN(SECTION_TXN_AMOUNTS, amounts);
+    WRITE_COLUMN(SECTION_TXN_TIMESTAMPS, timestamps);
+    WRITE_COLUMN(SECTION_TXN_ALERT_MASKS, alertMasks);
+    WRITE_COLUMN(SECTION_TXN_RISK_SCORES, riskScores);
+    WRITE_COLUMN(SECTION_TXN_STATUSES, statuses);
+    WRITE_COLUMN(SECTION_TXN_TYPES, types);
+    WRITE_COLUMN(SECTION_TXN_LOCATIONS, locations);
+    WRITE_COLUMN(SECTION_TXN_RULE_VERSIONS, ruleVersions);
+
+    // Account row lists in slot order, then the status lists
+    int64_t firstRow = 0;
+    beginSection(w, header, SECTION_INDEX_ACCOUNTS);
+    for (int slot = 0; full && slot < historyIndex.accountSlots; slot++) {
+        const AccountRows *entry = &historyIndex.accounts[slot];
+        if (entry->accNo == 0) continue;
+        int count = entry->list.count - entry->list.first;
+        SnapshotAccountRows record = {entry->accNo, count, firstRow};
+        writeBytes(w, &record, sizeof(record));
+        firstRow += count;
+        header->indexAccountCount++;
+    }
+    endSection(w, header, SECTION_INDEX_ACCOUNTS);
+
+    beginSection(w, header, SECTION_INDEX_ROWS);
+    for (int slot = 0; full && slot < historyIndex.accountSlots; slot++) {
+        const AccountRows *entry = &historyIndex.accounts[slot];
+        if (entry->accNo == 0) continue;
+        writeBytes(w, entry->list.rows + entry->list.first, (size_t)(entry->list.count - entry->list.first) * sizeof(int));
+    }
+    for (int status = 0; full && status < TXN_STATUS_COUNT; status++) {
+        const RowList *list = &historyIndex.byStatus[status];
+        writeBytes(w, list->rows + list->first, (size_t)(list->count - list->first) * sizeof(int));
+        header->statusRowCount[status] = list->count - list->first;
+    }
+    endSection(w, header, SECTION_INDEX_ROWS);
+
+    beginSection(w, header, SECTION_INDEX_BLOCKS);
+    if (header->blockCount > 0) {
+        int firstBlock = txnColumns.firstRow / HISTORY_BLOCK_ROWS - historyIndex.blockBase;
+        writeBytes(w, historyIndex.blocks + firstBlock, (size_t)header->blockCount * sizeof(TimeBlock));
+    }
+    endSection(w, header, SECTION_INDEX_BLOCKS);
+}
+
+// Time blocks spanning the in-memory rows
+static int hotBlockCount(int firstRow, int count) {
+    return (count > firstRow) ? (count - 1) / HISTORY_BLOCK_ROWS - firstRow / HISTORY_BLOCK_ROWS + 1 : 0;
+}
+
+/**
+ * Everything but the history segments, which the caller has flushed
+ */
+static int writeSnapshot(const char *path, SnapshotKind kind) {
+    double started = monotonicSeconds();
+    char tmpPath[4096];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    SnapshotWriter *w = malloc(sizeof(SnapshotWriter));
+    if (fd < 0 || !w) {
+        fprintf(stderr, "Error: Could not write snapshot %s\n", tmpPath);
+        if (fd >= 0) close(fd);
+        free(w);
+        return 0;
+    }
+    w->fd = fd;
+    w->offset = 0;
+    w->failed = 0;
+    w->used = 0;
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.createdAt = (int64_t)time(NULL);
+    header.kind = kind;
+    header.newestTime = newestTransactionTime();
+    header.accountCount = accountStore.count;
+    header.txnCount = txnCount;
+    header.firstRow = txnColumns.firstRow;
+    header.lastTxnId = lastTxnId;
+    header.timeOrdered = txnColumns.timeOrdered;
+    header.locationCount = locationTable.count;
+    header.accountTypeCount = accountTypeCount();
+    header.blockCount = (kind == SNAPSHOT_KIND_FULL) ? hotBlockCount(txnColumns.firstRow, txnCount) : 0;
+
+    // The header goes in last, once every section has been placed
+    writeBytes(w, &header, sizeof(header));
+    writeSections(w, &header);
+    flushWriter(w);
+    header.fileSize = w->offset;
+    header.checksum = crc32c(&header, offsetof(SnapshotHeader, checksum));
+
+    int ok = !w->failed && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
+    free(w);
+
+    if (!ok || rename(tmpPath, path) != 0) {
+        fprintf(stderr, "Error: Could not write snapshot %s\n", path);
+        remove(tmpPath);
+        return 0;
+    }
+
+    fprintf(stderr, "Saved %s: %d accounts, %d transactions (%.2f MB in %.3f s)\n",
+            (kind == SNAPSHOT_KIND_FULL) ? "snapshot" : "history state", header.accountCount, header.txnCount, header.fileSize / (1024.0 * 1024.0),
+            monotonicSeconds() - started);
+    return 1;
+}
+
+int saveSnapshot(const char *path) {
+    // The snapshot leaves out every sealed row, so they must be on disk first
+    if (!flushHistorySegments()) {
+        fprintf(stderr, "Error: Could not flush history segments, snapshot %s not written\n", path);
+        return 0;
+    }
+    return writeSnapshot(path, SNAPSHOT_KIND_FULL);
+}
+
+int saveHistoryState(const char *path) {
+    return writeSnapshot(path, SNAPSHOT_KIND_STATE);
+}
+
+int startBackgroundSnapshot(const char *path) {
+    pollBackgroundSnapshot();
+    if (snapshotChild > 0) return 0;
+
+    // The child must not touch the segment files the parent keeps appending to
+    if (!flushHistorySegments()) {
+        fprintf(stderr, "Error: Could not flush history segments, snapshot %s not written\n", path);
+        return 0;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: Could not start background snapshot\n");
+        return 0;
+    }
+    if (pid == 0) {
+        // The child's copy-on-write view is frozen at the fork
+        _exit(writeSnapshot(path, SNAPSHOT_KIND_FULL) ? 0 : 1);
+    }
+    snapshotChild = pid;
+    return 1;
+}
+
+static void reapSnapshot(int options) {
+    if (snapshotChild <= 0) return;
+
+    int status;
+    pid_t done = waitpid(snapshotChild, &status, options);
+    if (done == 0) return;
+
+    snapshotChild = -1;
+    if (done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Warning: Background snapshot failed\n");
+    }
+}
+
+void pollBackgroundSnapshot() {
+    reapSnapshot(WNOHANG);
+}
+
+void waitBackgroundSnapshot() {
+    reapSnapshot(0);
+}
+
+// ==================== LOADING ====================
+
+// The header starts the file, so offsets are from it
+static const void *sectionData(const SnapshotHeader *header, SnapshotSectionId id) {
+    return header->sections[id].length ? (const char *)header + header->sections[id].offset : NULL;
+}
+
+static int stringInRange(const SnapshotHeader *header, uint32_t offset) {
+    return offset < header->sections[SECTION_STRINGS].length;
+}
+
+/**
+ * Structure and checksums only; nothing is changed until this passes
+ */
+static int verifySnapshot(const char *base, size_t size) {
+    const SnapshotHeader *header = (const SnapshotHeader *)base;
+    if (size < sizeof(SnapshotHeader) || header->magic != SNAPSHOT_MAGIC ||
+        header->version != SNAPSHOT_VERSION || header->fileSize != size ||
+        (header->kind != SNAPSHOT_KIND_FULL && header->kind != SNAPSHOT_KIND_STATE) ||
+        header->checksum != crc32c(header, offsetof(SnapshotHeader, checksum)) ||
+        header->accountCount < 0 || header->txnCount < 0 || header->locationCount < 1 ||
+        header->firstRow < 0 || header->firstRow > header->txnCount ||
+        header->accountTypeCount < 1 || header->accountTypeCount > MAX_ACCOUNT_TYPES ||
+        header->indexAccountCount < 0) {
+        return 0;
+    }
+
+    int full = (header->kind == SNAPSHOT_KIND_FULL);
+    if (header->blockCount != (full ? hotBlockCount(header->firstRow, header->txnCount) : 0)) return 0;
+    uint64_t rows = full ? (uint64_t)(header->txnCount - header->firstRow) : 0;
+    uint64_t statusRows = 0;
+    for (int status = 0; status < TXN_STATUS_COUNT; status++) {
+        if (header->statusRowCount[status] < 0) return 0;
+        statusRows += (uint64_t)header->statusRowCount[status];
+    }
+
+    uint64_t expected[SECTION_COUNT] = {0};
+    expected[SECTION_LOCATION_NAMES] = (uint64_t)header->locationCount * sizeof(uint32_t);
+    expected[SECTION_ACCOUNT_TYPES] = (uint64_t)header->accountTypeCount * sizeof(uint32_t);
+    expected[SECTION_ACCOUNTS] = (uint64_t)header->accountCount * sizeof(SnapshotAccount);
+    expected[SECTION_STATISTICS] = sizeof(TxnStatistics);
+    expected[SECTION_TXN_IDS] = rows * sizeof(*txnColumns.txnIds);
+    expected[SECTION_TXN_ACC_NOS] = rows * sizeof(*txnColumns.accNos);
+    expected[SECTION_TXN_AMOUNTS] = rows * sizeof(*txnColumns.amounts);
+    expected[SECTION_TXN_TIMESTAMPS] = rows * sizeof(*txnColumns.timestamps);
+    expected[SECTION_TXN_ALERT_MASKS] = rows * sizeof(*txnColumns.alertMasks);
+    expected[SECTION_TXN_RISK_SCORES] = rows * sizeof(*txnColumns.riskScores);
+    expected[SECTION_TXN_STATUSES] = rows * sizeof(*txnColumns.statuses);
+    expected[SECTION_TXN_TYPES] = rows * sizeof(*txnColumns.types);
+    expected[SECTION_TXN_LOCATIONS] = rows * sizeof(*txnColumns.locations);
+    expected[SECTION_TXN_RULE_VERSIONS] = rows * sizeof(*txnColumns.ruleVersions);
+    expected[SECTION_INDEX_ACCOUNTS] = (uint64_t)header->indexAccountCount * sizeof(SnapshotAccountRows);
+    expected[SECTION_INDEX_BLOCKS] = (uint64_t)header->blockCount * sizeof(TimeBlock);
+
+    for (int id = 0; id < SECTION_COUNT; id++) {
+        const SnapshotSection *section = &header->sections[id];
+        if (section->offset % SNAPSHOT_ALIGN != 0 || section->offset < sizeof(SnapshotHeader) ||
+            section->offset > size || section->length > size - section->offset) {
+            return 0;
+        }
+        // Strings and index rows are sized by their contents, checked below
+        if (id != SECTION_STRINGS && id != SECTION_INDEX_ROWS && section->length != expected[id]) return 0;
+        if (crc32c(base + section->offset, section->length) != section->checksum) return 0;
+    }
+
+    const SnapshotSection *strings = &header->sections[SECTION_STRINGS];
+    if (strings->length == 0 || base[strings->offset + strings->length - 1] != '\0') return 0;
+
+    const uint32_t *locationNames = (const uint32_t *)(base + header->sections[SECTION_LOCATION_NAMES].offset);
+    for (int id = 0; id < header->locationCount; id++) {
+        if (!stringInRange(header, locationNames[id])) return 0;
+    }
+    const uint32_t *typeNames = (const uint32_t *)(base + header->sections[SECTION_ACCOUNT_TYPES].offset);
+    for (int type = 0; type < header->accountTypeCount; type++) {
+        if (!stringInRange(header, typeNames[type])) return 0;
+    }
+    const SnapshotAccount *accounts = (const SnapshotAccount *)(base + header->sections[SECTION_ACCOUNTS].offset);
+    for (int i = 0; i < header->accountCount; i++) {
+        if (!stringInRange(header, accounts[i].nameOffset) ||
+            !stringInRange(header, accounts[i].accountTypeOffset)) {
+            return 0;
+        }
+    }
+
+    uint64_t accountRows = 0;
+    const SnapshotAccountRows *entries = (const SnapshotAccountRows *)(base + header->sections[SECTION_INDEX_ACCOUNTS].offset);
+    for (int i = 0; i < header->indexAccountCount; i++) {
+        if (entries[i].count < 0 || entries[i].firstRow != (int64_t)accountRows) return 0;
+        accountRows += (uint64_t)entries[i].count;
+    }
+    return header->sections[SECTION_INDEX_ROWS].length == (accountRows + statusRows) * sizeof(int);
+}
+
+// Statistics are kept per type ID, so the IDs must come back unchanged
+static int accountTypesMatch(const SnapshotHeader *header) {
+    const char *strings = sectionData(header, SECTION_STRINGS);
+    const uint32_t *typeNames = sectionData(header, SECTION_ACCOUNT_TYPES);
+    for (int type = 1; type < header->accountTypeCount; type++) {
+        if (internAccountType(strings + typeNames[type]) != type) return 0;
+    }
+    return 1;
+}
+
+/**
+ * This run's LocationId for each of the snapshot's, by name. NULL if out
+ * of memory.
+ */
+static LocationId *mapLocations(const SnapshotHeader *header, int *locationsMoved) {
+    const char *strings = sectionData(header, SECTION_STRINGS);
+    LocationId *locationMap = malloc((size_t)header->locationCount * sizeof(LocationId));
+    if (!locationMap) return NULL;
+    const uint32_t *locationNames = sectionData(header, SECTION_LOCATION_NAMES);
+    *locationsMoved = 0;
+    locationMap[LOCATION_NONE] = LOCATION_NONE;
+    for (int id = 1; id < header->locationCount; id++) {
+        locationMap[id] = internLocation(strings + locationNames[id]);
+        if (locationMap[id] != id) *locationsMoved = 1;
+    }
+    return locationMap;
+}
+
+/**
+ * The fields history folds into an account: spend counters, velocity
+ * ring and behavior profile
+ */
+static void restoreActivity(Account *account, const SnapshotAccount *record,
+                            const LocationId *locationMap, int locationCount) {
+    account->dailySpent = record->dailySpent;
+    account->monthlySpent = record->monthlySpent;
+    account->spendDay = record->spendDay;
+    account->spendMonth = record->spendMonth;
+    account->recent.head = record->recentHead;
+    account->recent.count = record->recentCount;
+    for (int slot = 0; slot < RECENT_TXN_CAPACITY; slot++) {
+        account->recent.timestamps[slot] = (time_t)record->recentTimestamps[slot];
+        account->recent.amounts[slot] = record->recentAmounts[slot];
+    }
+    BehaviorProfile *profile = &account->profile;
+    profile->count = record->profileCount;
+    profile->hourTotal = record->profileHourTotal;
+    profile->meanAmount = record->profileMeanAmount;
+    profile->amountM2 = record->profileAmountM2;
+    profile->rateSum = record->profileRateSum;
+    profile->rateTime = (time_t)record->profileRateTime;
+    profile->since = (time_t)record->profileSince;
+    memcpy(profile->hourCounts, record->profileHourCounts, sizeof(profile->hourCounts));
+    for (int i = 0; i < PROFILE_TOP_LOCATIONS; i++) {
+        LocationId id = record->profileTopLocations[i];
+        profile->topLocations[i] = (id < locationCount) ? locationMap[id] : LOCATION_NONE;
+        profile->locationCounts[i] = record->profileLocationCounts[i];
+    }
+}
+
+/**
+ * Rebuild the stores around the verified mapping. Location IDs are
+ * remapped if locations.json changed since the snapshot was written.
+ */
+static int restoreState(const SnapshotHeader *header) {
+    const char *strings = sectionData(header, SECTION_STRINGS);
+    if (!accountTypesMatch(header)) return 0;
+
+    int locationsMoved;
+    LocationId *locationMap = mapLocations(header, &locationsMoved);
+    if (!locationMap) return 0;
+
+    initAccountStore(&accountStore, header->accountCount);
+    const SnapshotAccount *records = sectionData(header, SECTION_ACCOUNTS);
+    for (int i = 0; i < header->accountCount; i++) {
+        const SnapshotAccount *record = &records[i];
+        Account account = {0};
+        account.accNo = record->accNo;
+        account.name = strings + record->nameOffset;
+        account.balance = record->balance;
+        account.lastLocation = (record->lastLocation < header->locationCount) ? locationMap[record->lastLocation] : LOCATION_NONE;
+        account.lastTxnTime = (time_t)record->lastTxnTime;
+        account.transactionCount = record->transactionCount;
+        account.isActive = record->isActive;
+        account.accountType = strings + record->accountTypeOffset;
+        account.dailyLimit = record->dailyLimit;
+        account.monthlyLimit = record->monthlyLimit;
+        restoreActivity(&account, record, locationMap, header->locationCount);
+        if (!addAccount(&accountStore, &account)) {
+            free(locationMap);
+            return 0;
+        }
+    }
+
+    memcpy(&txnStatistics, sectionData(header, SECTION_STATISTICS), sizeof(txnStatistics));
+
+    // Columns are used in place; only a remapped location column is copied
+    int rows = header->txnCount - header->firstRow;
+    TransactionColumns columns = {0};
+    if (rows > 0) {
+        columns.txnIds = (int *)sectionData(header, SECTION_TXN_IDS);
+        columns.accNos = (int *)sectionData(header, SECTION_TXN_ACC_NOS);
+        columns.amounts = (double *)sectionData(header, SECTION_TXN_AMOUNTS);
+        columns.timestamps = (int64_t *)sectionData(header, SECTION_TXN_TIMESTAMPS);
+        columns.alertMasks = (uint32_t *)sectionData(header, SECTION_TXN_ALERT_MASKS);
+        columns.riskScores = (uint8_t *)sectionData(header, SECTION_TXN_RISK_SCORES);
+        columns.statuses = (uint8_t *)sectionData(header, SECTION_TXN_STATUSES);
+        columns.types = (uint8_t *)sectionData(header, SECTION_TXN_TYPES);
+        columns.locations = (LocationId *)sectionData(header, SECTION_TXN_LOCATIONS);
+        columns.ruleVersions = (uint32_t *)sectionData(header, SECTION_TXN_RULE_VERSIONS);
+    }
+    if (rows > 0 && locationsMoved) {
+        LocationId *remapped = malloc((size_t)rows * sizeof(LocationId));
+        if (!remapped) {
+            free(locationMap);
+            return 0;
+        }
+        for (int row = 0; row < rows; row++) {
+            LocationId id = columns.locations[row];
+            remapped[row] = (id < header->locationCount) ? locationMap[id] : LOCATION_NONE;
+        }
+        columns.locations = remapped;
+    }
+    free(locationMap);
+    columns.timeOrdered = header->timeOrdered;
+    adoptTransactionColumns(&columns, header->firstRow, rows, header->lastTxnId);
+
+    clearHistoryIndex();
+    int *indexRows = (int *)sectionData(header, SECTION_INDEX_ROWS);
+    const SnapshotAccountRows *entries = sectionData(header, SECTION_INDEX_ACCOUNTS);
+    long accountRows = 0;
+    for (int i = 0; i < header->indexAccountCount; i++) {
+        const SnapshotAccountRows *entry = &entries[i];
+        if (entry->count > 0 && !adoptAccountRows(entry->accNo, indexRows + entry->firstRow, entry->count)) return 0;
+        accountRows += entry->count;
+    }
+    int *statusRows = indexRows ? indexRows + accountRows : NULL;
+    for (int status = 0; status < TXN_STATUS_COUNT; status++) {
+        int count = header->statusRowCount[status];
+        historyIndex.byStatus[status].rows = count ? statusRows : NULL;
+        historyIndex.byStatus[status].first = 0;
+        historyIndex.byStatus[status].count = count;
+        historyIndex.byStatus[status].capacity = count;
+        if (count) statusRows += count;
+    }
+    historyIndex.blocks = (TimeBlock *)sectionData(header, SECTION_INDEX_BLOCKS);
+    historyIndex.blockCapacity = header->blockCount;
+    historyIndex.blockBase = header->firstRow / HISTORY_BLOCK_ROWS;
+    return 1;
+}
+
+int loadSnapshot(const char *path) {
+    if (snapshotBase) return 0;
+
+    double started = monotonicSeconds();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        fprintf(stderr, "Warning: Snapshot %s is truncated, ignoring it\n", path);
+        close(fd);
+        return 0;
+    }
+
+    // Private and writable: later appends land in copy-on-write pages,
+    // never in the file
+    size_t size = (size_t)st.st_size;
+    char *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Warning: Could not map snapshot %s\n", path);
+        return 0;
+    }
+
+    if (!verifySnapshot(base, size)) {
+        fprintf(stderr, "Warning: Snapshot %s is corrupt or from another version, ignoring it\n", path);
+        munmap(base, size);
+        return 0;
+    }
+
+    // The mapping stays for the life of the process: names, columns and
+    // index lists point into it
+    snapshotBase = base;
+    snapshotSize = size;
+    const SnapshotHeader *header = (const SnapshotHeader *)base;
+    if (header->kind != SNAPSHOT_KIND_FULL || !restoreState(header)) {
+        fprintf(stderr, "Warning: Could not restore snapshot %s, falling back to JSON\n", path);
+        freeAccountStore(&accountStore);
+        clearTransactions();
+        memset(&txnStatistics, 0, sizeof(txnStatistics));
+        return 0;
+    }
+
+    fprintf(stderr, "Loaded snapshot: %d accounts, %d transactions (%.2f MB in %.3f s)\n",
+            accountStore.count, txnCount, size / (1024.0 * 1024.0), monotonicSeconds() - started);
+    return 1;
+}
+
+int loadHistoryState(const char *path, int firstRow) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    char *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SnapshotHeader)) {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return 0;
+
+    // Only a state saved with these very rows may stand in for replaying them
+    size_t size = (size_t)st.st_size;
+    const SnapshotHeader *header = (const SnapshotHeader *)base;
+    int ok = verifySnapshot(base, size) && header->kind == SNAPSHOT_KIND_STATE &&
+             header->firstRow == firstRow && header->txnCount == txnCount && accountTypesMatch(header);
+    int locationsMoved;
+    LocationId *locationMap = ok ? mapLocations(header, &locationsMoved) : NULL;
+    if (!locationMap) {
+        munmap(base, size);
+        return 0;
+    }
+
+    const SnapshotAccount *records = sectionData(header, SECTION_ACCOUNTS);
+    for (int i = 0; i < header->accountCount; i++) {
+        Account *account = findAccount(&accountStore, records[i].accNo);
+        if (account) restoreActivity(account, &records[i], locationMap, header->locationCount);
+    }
+    memcpy(&txnStatistics, sectionData(header, SECTION_STATISTICS), sizeof(txnStatistics));
+    restoreHistoryOrder(header->lastTxnId, header->timeOrdered, header->newestTime);
+
+    free(locationMap);
+    munmap(base, size);
+    return 1;
+}
+
+static int snapshotOwns(const void *data) {
+    const char *p = data;
+    return snapshotBase && p >= snapshotBase && p < snapshotBase + snapshotSize;
+}
+
+void *snapshotRealloc(void *data, size_t used, size_t size) {
+    if (!snapshotOwns(data)) return realloc(data, size);
+
+    void *copy = malloc(size);
+    if (copy) memcpy(copy, data, used < size ? used : size);
+    return copy;
+}
+
+void snapshotFree(void *data) {
+    if (!snapshotOwns(data)) free(data);
+}
@@ -0,0 +1,76 @@
+/**
+ * State Snapshot for Fraud Detection System
+ * Versioned, checksummed binary image of the accounts, the columnar
+ * history and its indexes, loaded by mmap without per-record parsing
+ *
+ * File layout: SnapshotHeader, then 64-byte aligned sections, each with
+ * its own CRC32C in the header. Columns and index lists are used in place
+ * from the private mapping and copied out the first time they grow.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DATA_FILE_SNAPSHOT "data/state.snapshot"
+
+/**
+ * Write the current state to path.tmp, fsync and rename it over path
+ */
+int saveSnapshot(const char *path);
+
+/**
+ * Fork and write the snapshot from the child, which sees the state as of
+ * the fork no matter what the parent changes meanwhile. Returns 0 if a
+ * snapshot is already being written or the fork failed.
+ */
+int startBackgroundSnapshot(const char *path);
+
+/**
+ * Reap a finished background snapshot without blocking, or wait for the
+ * running one; failures are reported on stderr
+ */
+void pollBackgroundSnapshot();
+void waitBackgroundSnapshot();
+
+/**
+ * Replace the (empty) stores with the snapshot at path. Every checksum is
+ * verified before anything is touched; returns 0 on any mismatch so the
+ * caller can fall back to the JSON files. At most once per process.
+ */
+int loadSnapshot(const char *path);
+
+/**
+ * Write what the history has folded into the accounts and statistics
+ * (spend counters, velocity rings, profiles, txnStatistics, lastTxnId and
+ * the time order) as a snapshot without rows. Saved with the JSON files,
+ * whose loader would otherwise replay the whole sealed history.
+ */
+int saveHistoryState(const char *path);
+
+/**
+ * Apply a state from saveHistoryState() over what loading the JSON files
+ * folded in, if it was saved with the same rows (firstRow and txnCount).
+ * Returns 0, changing nothing, for any other or damaged state.
+ */
+int loadHistoryState(const char *path, int firstRow);
+
+/**
+ * realloc() that also accepts memory inside the loaded snapshot, copying
+ * the first `used` bytes out of the mapping instead of resizing in place
+ */
+void *snapshotRealloc(void *data, size_t used, size_t size);
+
+/**
+ * CRC32C of data, with the SSE4.2 instruction when the CPU has it
+ */
+uint32_t snapshotChecksum(const void *data, size_t length);
+
+/**
+ * free() that leaves memory inside the loaded snapshot alone
+ */
+void snapshotFree(void *data);
+
+#endif
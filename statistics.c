@@ -0,0 +1,75 @@
+/**
+ * Statistics for Fraud Detection System
+ * Running totals and time-bucketed aggregates, updated on every insert
+ */
+
+#include <string.h>
+#include "statistics.h"
+
+TxnStatistics txnStatistics;
+
+static inline void addToTotals(StatTotals *totals, const Transaction *txn, int suspicious) {
+    totals->count++;
+    totals->amount += txn->amount;
+    totals->riskScoreSum += txn->riskScore;
+    if (suspicious) {
+        totals->suspicious++;
+        totals->suspiciousAmount += txn->amount;
+    }
+}
+
+static void addToRing(StatBucket *ring, int bucketCount, int width, const Transaction *txn, int suspicious) {
+    if (txn->timestamp <= 0) return;
+
+    time_t start = txn->timestamp - txn->timestamp % width;
+    StatBucket *bucket = &ring[(start / width) % bucketCount];
+
+    if (bucket->start != start) {
+        // An older transaction landing on a slot already reused for newer
+        // data is outside the ring's span
+        if (bucket->start > start) return;
+        memset(bucket, 0, sizeof(*bucket));
+        bucket->start = start;
+    }
+
+    addToTotals(&bucket->totals, txn, suspicious);
+    int bin = txn->riskScore / 10;
+    bucket->riskHistogram[bin < RISK_HISTOGRAM_BINS ? bin : RISK_HISTOGRAM_BINS - 1]++;
+}
+
+void recordTransactionStats(TxnStatistics *stats, const Transaction *txn, int accountTypeId) {
+    int suspicious = (txn->status == TXN_STATUS_SUSPICIOUS);
+
+    addToTotals(&stats->overall, txn, suspicious);
+    if (accountTypeId >= 0 && accountTypeId < MAX_ACCOUNT_TYPES) {
+        addToTotals(&stats->byAccountType[accountTypeId], txn, suspicious);
+    }
+    addToRing(stats->minutes, STATS_MINUTE_BUCKETS, 60, txn, suspicious);
+    addToRing(stats->hours, STATS_HOUR_BUCKETS, 3600, txn, suspicious);
+}
+
+StatTotals statsWindow(const TxnStatistics *stats, time_t now, int seconds, uint32_t *histogram) {
+    StatTotals window;
+    memset(&window, 0, sizeof(window));
+    if (histogram) memset(histogram, 0, RISK_HISTOGRAM_BINS * sizeof(uint32_t));
+
+    const StatBucket *ring = (seconds <= STATS_MINUTE_BUCKETS * 60) ? stats->minutes : stats->hours;
+    int bucketCount = (ring == stats->minutes) ? STATS_MINUTE_BUCKETS : STATS_HOUR_BUCKETS;
+
+    for (int i = 0; i < bucketCount; i++) {
+        const StatBucket *bucket = &ring[i];
+        if (bucket->start == 0 || bucket->start <= now - seconds || bucket->start > now) continue;
+
+        window.count += bucket->totals.count;
+        window.suspicious += bucket->totals.suspicious;
+        window.amount += bucket->totals.amount;
+        window.suspiciousAmount += bucket->totals.suspiciousAmount;
+        window.riskScoreSum += bucket->totals.riskScoreSum;
+        if (histogram) {
+            for (int bin = 0; bin < RISK_HISTOGRAM_BINS; bin++) {
+                histogram[bin] += bucket->riskHistogram[bin];
+            }
+        }
+    }
+    return window;
+}
@@ -0,0 +1,54 @@
+/**
+ * Statistics for Fraud Detection System
+ * Running totals and time-bucketed aggregates, updated on every insert
+ */
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <stdint.h>
+#include <time.h>
+#include "account_store.h"
+#include "transaction_log.h"
+
+#define STATS_MINUTE_BUCKETS 60         // last hour, one bucket per minute
+#define STATS_HOUR_BUCKETS 48           // last two days, one bucket per hour
+#define RISK_HISTOGRAM_BINS 11          // 0-9, 10-19, ..., 90-99, 100
+
+typedef struct {
+    long count;
+    long suspicious;
+    double amount;
+    double suspiciousAmount;
+    long riskScoreSum;
+} StatTotals;
+
+typedef struct {
+    time_t start;                       // aligned bucket start, 0 = never used
+    StatTotals totals;
+    uint32_t riskHistogram[RISK_HISTOGRAM_BINS];
+} StatBucket;
+
+typedef struct {
+    StatTotals overall;
+    StatTotals byAccountType[MAX_ACCOUNT_TYPES];
+    StatBucket minutes[STATS_MINUTE_BUCKETS];
+    StatBucket hours[STATS_HOUR_BUCKETS];
+} TxnStatistics;
+
+extern TxnStatistics txnStatistics;
+
+/**
+ * Fold one stored transaction into the totals and its time buckets.
+ * Transactions older than a ring's span only reach the totals.
+ */
+void recordTransactionStats(TxnStatistics *stats, const Transaction *txn, int accountTypeId);
+
+/**
+ * Sum the buckets covering [now - seconds, now]: minute buckets for up to
+ * an hour, hour buckets beyond. histogram (may be NULL) receives the
+ * combined risk-score distribution.
+ */
+StatTotals statsWindow(const TxnStatistics *stats, time_t now, int seconds, uint32_t *histogram);
+
+#endif
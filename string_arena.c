@@ -0,0 +1,44 @@
+/**
+ * String Arena for Fraud Detection System
+ * Bump allocator for long-lived strings (names, account types)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "string_arena.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+StringArena stringArena;
+
+const char *arenaStrndup(StringArena *arena, const char *text, size_t length) {
+    ArenaBlock *block = arena->head;
+
+    if (!block || block->used + length + 1 > block->size) {
+        size_t size = (length + 1 > ARENA_BLOCK_SIZE) ? length + 1 : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + size);
+        if (!block) return "";
+        block->next = arena->head;
+        block->used = 0;
+        block->size = size;
+        arena->head = block;
+        arena->totalBytes += size;
+    }
+
+    char *copy = block->data + block->used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    block->used += length + 1;
+    return copy;
+}
+
+void freeStringArena(StringArena *arena) {
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->totalBytes = 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * String Arena for Fraud Detection System
+ * Bump allocator for long-lived strings (names, account types)
+ */
+
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;
+    size_t totalBytes;
+} StringArena;
+
+extern StringArena stringArena;
+
+/**
+ * Copy length bytes plus a terminator into the arena. Strings live until
+ * freeStringArena(); returns "" if memory runs out.
+ */
+const char *arenaStrndup(StringArena *arena, const char *text, size_t length);
+void freeStringArena(StringArena *arena);
+
+#endif
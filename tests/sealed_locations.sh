@@ -0,0 +1,57 @@
+#!/bin/bash
+# Sealed history must keep its location names when a later run interns
+# locations in a different order: seal rows at new locations, compact,
+# drop the snapshot so the next run starts from JSON with a location the
+# first run never saw, and read the sealed rows back.
+#
+# Run from the repository root after ./compile.sh
+
+set -e
+
+BIN="$(pwd)/fraudbackend"
+if [ ! -x "$BIN" ]; then
+    echo "❌ Build first: ./compile.sh"
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir -p "$WORK/data"
+cp data/accounts.json data/blacklist.json data/locations.json "$WORK/data/"
+echo '{"transactions": []}' > "$WORK/data/transactions.json"
+# Keep only the minimum hot history so the first rows are sealed
+python3 - data/fraud_patterns.json "$WORK/data/fraud_patterns.json" <<'EOF'
+import json, sys
+patterns = json.load(open(sys.argv[1]))
+patterns["retention"] = {"hotRows": 8192, "hotSeconds": 0}
+json.dump(patterns, open(sys.argv[2], "w"), indent=2)
+EOF
+
+cd "$WORK"
+{
+    for i in $(seq 1 5); do echo "TXN 100 10 Zedville"; echo "TXN 101 20 Yonder"; done
+    # Nothing outside the sealed rows may name the new locations
+    echo "TXN 100 10 London"; echo "TXN 101 20 London"
+    for i in $(seq 1 8300); do echo "TXN 102 1 London"; done
+} | "$BIN" --serve > /dev/null
+"$BIN" --compact > /dev/null
+rm -f data/*.snapshot data/*.journal
+"$BIN" 103 5 Xanadu > /dev/null
+
+"$BIN" --history > history.json
+python3 - history.json <<'EOF'
+import json, sys
+rows = json.load(open(sys.argv[1]))["transactions"]
+seen = {}
+for row in rows:
+    seen.setdefault(row["accNo"], set()).add(row["location"])
+expected = {100: {"Zedville", "London"}, 101: {"Yonder", "London"}, 103: {"Xanadu"}}
+for accNo, locations in expected.items():
+    if seen.get(accNo) != locations:
+        print("❌ account %d: expected %s, got %s" % (accNo, sorted(locations), sorted(seen.get(accNo, ()))))
+        sys.exit(1)
+if len(rows) != 8313:
+    print("❌ expected 8313 rows, got %d" % len(rows))
+    sys.exit(1)
+print("✅ sealed locations survive a restart from JSON")
+EOF
@@ -0,0 +1,292 @@
+/**
+ * Transaction Log for Fraud Detection System
+ * Shared transaction record and the in-memory history ring, sealed into
+ * the history segments from its oldest end
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "transaction_log.h"
+#include "account_store.h"
+#include "statistics.h"
+#include "history_index.h"
+#include "history_segments.h"
+#include "snapshot.h"
+
+#define INITIAL_TXN_CAPACITY 128        // a power of two, like every capacity the ring grows to
+
+TransactionColumns txnColumns = {.timeOrdered = 1};
+int txnCount = 0;
+int lastTxnId = 0;
+
+static struct {
+    int hotRows;
+    long hotSeconds;
+} retention;
+
+static int64_t newestTime = INT64_MIN;
+
+static const char *statusNames[TXN_STATUS_COUNT] = {"clean", "suspicious"};
+static const char *typeNames[TXN_TYPE_COUNT] = {"purchase", "transfer", "withdrawal", "other"};
+
+const char *txnStatusName(int status) {
+    return (status >= 0 && status < TXN_STATUS_COUNT) ? statusNames[status] : "clean";
+}
+
+const char *txnTypeName(int type) {
+    return (type >= 0 && type < TXN_TYPE_COUNT) ? typeNames[type] : "other";
+}
+
+TxnStatus parseTxnStatus(const char *name) {
+    return (name && strcmp(name, "suspicious") == 0) ? TXN_STATUS_SUSPICIOUS : TXN_STATUS_CLEAN;
+}
+
+TxnType parseTxnType(const char *name) {
+    for (int type = 0; name && type < TXN_TYPE_OTHER; type++) {
+        if (strcmp(typeNames[type], name) == 0) return (TxnType)type;
+    }
+    return TXN_TYPE_OTHER;
+}
+
+// Columns grown so far keep their larger size if a later one fails;
+// capacity only moves once all of them have room. Columns still in the
+// snapshot mapping are copied out on their first growth.
+#define GROW_COLUMN(column, capacity) do { \
+        void *grown = snapshotRealloc(txnColumns.column, (size_t)txnColumns.capacity * sizeof(*txnColumns.column), \
+                                      (size_t)(capacity) * sizeof(*txnColumns.column)); \
+        if (!grown) return 0; \
+        txnColumns.column = grown; \
+    } while (0)
+
+#define MOVE_SLOT(column) txnColumns.column[to] = txnColumns.column[from]
+
+/**
+ * Grow to capacity, a power of two at least twice the slots in use. A
+ * wrapped ring unwraps: rows whose slot lands in the new upper half move
+ * there, the rest stay put.
+ */
+static int growColumns(int capacity) {
+    GROW_COLUMN(txnIds, capacity);
+    GROW_COLUMN(accNos, capacity);
+    GROW_COLUMN(amounts, capacity);
+    GROW_COLUMN(timestamps, capacity);
+    GROW_COLUMN(alertMasks, capacity);
+    GROW_COLUMN(riskScores, capacity);
+    GROW_COLUMN(statuses, capacity);
+    GROW_COLUMN(types, capacity);
+    GROW_COLUMN(locations, capacity);
+    GROW_COLUMN(ruleVersions, capacity);
+
+    int slotMask = capacity - 1;
+    for (int row = txnColumns.firstRow; row < txnCount; row++) {
+        int from = txnSlot(row);
+        int to = (row - txnColumns.baseRow) & slotMask;
+        if (from == to) continue;
+        MOVE_SLOT(txnIds);
+        MOVE_SLOT(accNos);
+        MOVE_SLOT(amounts);
+        MOVE_SLOT(timestamps);
+        MOVE_SLOT(alertMasks);
+        MOVE_SLOT(riskScores);
+        MOVE_SLOT(statuses);
+        MOVE_SLOT(types);
+        MOVE_SLOT(locations);
+        MOVE_SLOT(ruleVersions);
+    }
+    txnColumns.capacity = capacity;
+    txnColumns.slotMask = slotMask;
+    return 1;
+}
+
+// Adopted snapshot columns are sized exactly; the first growth rounds up
+static int nextCapacity() {
+    int capacity = txnColumns.slotMask + 1;
+    if (capacity <= txnColumns.capacity) capacity *= 2;
+    return (capacity < INITIAL_TXN_CAPACITY) ? INITIAL_TXN_CAPACITY : capacity;
+}
+
+int allocateTxnId() {
+    return __atomic_add_fetch(&lastTxnId, 1, __ATOMIC_RELAXED);
+}
+
+void setHistoryRetention(int hotRows, long hotSeconds) {
+    retention.hotRows = (hotRows <= 0) ? 0 : (hotRows < MIN_HOT_ROWS) ? MIN_HOT_ROWS : hotRows;
+    retention.hotSeconds = (hotSeconds > 0) ? hotSeconds : 0;
+}
+
+/**
+ * Whether the oldest in-memory row has to go to make room for `room` more
+ * rows, with `newest` the latest timestamp stored or about to be
+ */
+static inline int mustEvict(int room, int64_t newest) {
+    int row = txnColumns.firstRow;
+    if (row >= txnCount) return 0;
+    if (row < sealedRowCount()) return 1;
+    if (retention.hotRows > 0 && txnCount - row + room > retention.hotRows) return 1;
+    return retention.hotSeconds > 0 && txnColumns.timestamps[txnSlot(row)] < newest - retention.hotSeconds;
+}
+
+/**
+ * Move the oldest in-memory row to the cold tier (unless an earlier run
+ * already put it there) and free its slot
+ */
+static int evictOldestRow() {
+    int row = txnColumns.firstRow;
+    if (row >= sealedRowCount()) {
+        Transaction txn;
+        readTransaction(row, &txn);
+        if (!sealTransaction(row, &txn)) return 0;
+    }
+    unindexOldestRow(row);
+    txnColumns.firstRow++;
+    return 1;
+}
+
+void applyHistoryRetention() {
+    while (mustEvict(0, newestTime) && evictOldestRow()) {
+    }
+}
+
+static void noteTransaction(const Transaction *txn) {
+    if ((int64_t)txn->timestamp < newestTime) {
+        txnColumns.timeOrdered = 0;
+    } else {
+        newestTime = (int64_t)txn->timestamp;
+    }
+    if (txn->txnId > lastTxnId) lastTxnId = txn->txnId;
+
+    const Account *account = findAccount(&accountStore, txn->accNo);
+    recordTransactionStats(&txnStatistics, txn, account ? account->accountTypeId : 0);
+}
+
+int storeTransaction(const Transaction *txn) {
+    int64_t newest = ((int64_t)txn->timestamp > newestTime) ? (int64_t)txn->timestamp : newestTime;
+    while (mustEvict(1, newest) && evictOldestRow()) {
+    }
+
+    // Replaying rows an earlier run sealed before it stopped: they are
+    // on disk already, and the ring is empty since older rows were dropped
+    int row = txnCount;
+    if (row < sealedRowCount()) {
+        txnCount++;
+        txnColumns.firstRow = txnCount;
+        noteTransaction(txn);
+        return 1;
+    }
+
+    if (row - txnColumns.firstRow >= txnColumns.capacity || txnSlot(row) >= txnColumns.capacity) {
+        if (!growColumns(nextCapacity())) return 0;
+    }
+
+    int slot = txnSlot(row);
+    txnCount++;
+    txnColumns.txnIds[slot] = txn->txnId;
+    txnColumns.accNos[slot] = txn->accNo;
+    txnColumns.amounts[slot] = txn->amount;
+    txnColumns.timestamps[slot] = (int64_t)txn->timestamp;
+    txnColumns.alertMasks[slot] = txn->alertMask;
+    txnColumns.riskScores[slot] = txn->riskScore;
+    txnColumns.statuses[slot] = txn->status;
+    txnColumns.types[slot] = txn->type;
+    txnColumns.locations[slot] = txn->location;
+    txnColumns.ruleVersions[slot] = txn->ruleVersion;
+    if (!indexTransactionRow(row)) {
+        txnCount--;
+        return 0;
+    }
+
+    noteTransaction(txn);
+    return 1;
+}
+
+void recordSealedTransaction(const Transaction *txn) {
+    noteTransaction(txn);
+}
+
+int64_t newestTransactionTime() {
+    return newestTime;
+}
+
+void restoreHistoryOrder(int lastId, int timeOrdered, int64_t newest) {
+    lastTxnId = lastId;
+    txnColumns.timeOrdered = timeOrdered;
+    newestTime = newest;
+}
+
+void readTransaction(int row, Transaction *txn) {
+    if (row < txnColumns.firstRow) {
+        readSealedTransaction(NULL, row, txn);
+        return;
+    }
+
+    int slot = txnSlot(row);
+    txn->txnId = txnColumns.txnIds[slot];
+    txn->accNo = txnColumns.accNos[slot];
+    txn->amount = txnColumns.amounts[slot];
+    txn->timestamp = (time_t)txnColumns.timestamps[slot];
+    txn->alertMask = txnColumns.alertMasks[slot];
+    txn->riskScore = txnColumns.riskScores[slot];
+    txn->status = txnColumns.statuses[slot];
+    txn->type = txnColumns.types[slot];
+    txn->location = txnColumns.locations[slot];
+    txn->ruleVersion = txnColumns.ruleVersions[slot];
+}
+
+int hotSlotRuns(int begin, int end, SlotRun runs[2]) {
+    if (begin >= end) return 0;
+
+    int count = end - begin;
+    int untilWrap = txnColumns.slotMask + 1 - txnSlot(begin);
+    runs[0].start = txnSlot(begin);
+    runs[0].count = (count < untilWrap) ? count : untilWrap;
+    if (runs[0].count == count) return 1;
+
+    runs[1].start = 0;
+    runs[1].count = count - runs[0].count;
+    return 2;
+}
+
+void adoptTransactionColumns(const TransactionColumns *columns, int firstRow, int count, int lastId) {
+    snapshotFree(txnColumns.txnIds);
+    snapshotFree(txnColumns.accNos);
+    snapshotFree(txnColumns.amounts);
+    snapshotFree(txnColumns.timestamps);
+    snapshotFree(txnColumns.alertMasks);
+    snapshotFree(txnColumns.riskScores);
+    snapshotFree(txnColumns.statuses);
+    snapshotFree(txnColumns.types);
+    snapshotFree(txnColumns.locations);
+    snapshotFree(txnColumns.ruleVersions);
+
+    // Rows sit in slots 0 .. count - 1, so any mask that covers them works
+    txnColumns = *columns;
+    txnColumns.capacity = count;
+    txnColumns.firstRow = firstRow;
+    txnColumns.baseRow = firstRow;
+    txnColumns.slotMask = 0;
+    while (txnColumns.slotMask + 1 < count) txnColumns.slotMask = txnColumns.slotMask * 2 + 1;
+    txnCount = firstRow + count;
+    lastTxnId = lastId;
+
+    newestTime = INT64_MIN;
+    for (int slot = 0; slot < count; slot++) {
+        if (txnColumns.timestamps[slot] > newestTime) newestTime = txnColumns.timestamps[slot];
+    }
+}
+
+void startTransactionsAt(int firstRow) {
+    txnCount = firstRow;
+    txnColumns.firstRow = firstRow;
+    txnColumns.baseRow = firstRow;
+}
+
+void clearTransactions() {
+    txnCount = 0;
+    lastTxnId = 0;
+    txnColumns.timeOrdered = 1;
+    txnColumns.firstRow = 0;
+    txnColumns.baseRow = 0;
+    newestTime = INT64_MIN;
+    clearHistoryIndex();
+}
@@ -0,0 +1,163 @@
+/**
+ * Transaction Log for Fraud Detection System
+ * Shared transaction record and the columnar in-memory history: a ring
+ * holding the newest rows (the hot tier), whose oldest rows are sealed
+ * into the history segments (the cold tier) once retention limits are hit
+ *
+ * Rows are numbered from 0 for the first transaction ever stored and keep
+ * their number when they move to the cold tier, so indexes, cursors and
+ * readTransaction() need not care which tier holds a row.
+ */
+
+#ifndef TRANSACTION_LOG_H
+#define TRANSACTION_LOG_H
+
+#include <stdint.h>
+#include <time.h>
+#include "location_table.h"
+
+typedef enum {
+    TXN_STATUS_CLEAN = 0,
+    TXN_STATUS_SUSPICIOUS,
+    TXN_STATUS_COUNT
+} TxnStatus;
+
+typedef enum {
+    TXN_TYPE_PURCHASE = 0,
+    TXN_TYPE_TRANSFER,
+    TXN_TYPE_WITHDRAWAL,
+    TXN_TYPE_OTHER,
+    TXN_TYPE_COUNT
+} TxnType;
+
+typedef struct {
+    int txnId;
+    int accNo;
+    double amount;
+    time_t timestamp;
+    uint32_t alertMask;         // ALERT_BIT(AlertCode) flags, see alert_codes.h
+    uint8_t riskScore;
+    uint8_t status;             // TxnStatus
+    uint8_t type;               // TxnType
+    LocationId location;        // interned in locationTable
+    uint32_t ruleVersion;       // CompiledRules.version that scored it
+} Transaction;
+
+// History stored one column per field, so scans and aggregates read only
+// the fields they filter or sum on. A row is spread across every column at
+// the same slot, see txnSlot().
+typedef struct {
+    int *txnIds;
+    int *accNos;
+    double *amounts;
+    int64_t *timestamps;
+    uint32_t *alertMasks;
+    uint8_t *riskScores;
+    uint8_t *statuses;
+    uint8_t *types;
+    LocationId *locations;
+    uint32_t *ruleVersions;
+    int capacity;
+    int timeOrdered;            // timestamps never decrease, so ranges can bisect
+    int firstRow;               // oldest row in memory; older ones are sealed
+    int baseRow;                // row whose slot is 0
+    int slotMask;               // slots wrap at slotMask + 1, a power of two
+} TransactionColumns;
+
+// Slots holding a range of rows, in row order
+typedef struct {
+    int start;
+    int count;
+} SlotRun;
+
+extern TransactionColumns txnColumns;
+extern int txnCount;            // rows ever stored, in memory or sealed
+extern int lastTxnId;
+
+static inline int txnSlot(int row) {
+    return (row - txnColumns.baseRow) & txnColumns.slotMask;
+}
+
+const char *txnStatusName(int status);
+const char *txnTypeName(int type);
+TxnStatus parseTxnStatus(const char *name);
+TxnType parseTxnType(const char *name);
+
+/**
+ * Reserve the next transaction ID. Lock-free, so concurrent workers can
+ * number transactions before they are stored.
+ */
+int allocateTxnId();
+
+/**
+ * Append a transaction to the history, growing it as needed, and fold it
+ * into txnStatistics. Rows past the retention limits are sealed first, in
+ * O(1) per row. Single writer: not concurrently with other calls or with
+ * allocateTxnId(). Returns 0 if memory could not be allocated.
+ */
+int storeTransaction(const Transaction *txn);
+
+/**
+ * Gather a row back into a Transaction. Cold rows are decoded through the
+ * serve thread's segment reader; hot rows may be read from any thread.
+ */
+void readTransaction(int row, Transaction *txn);
+
+/**
+ * Up to two slot runs covering rows [begin, end), all of them in memory.
+ * Returns the number of runs.
+ */
+int hotSlotRuns(int begin, int end, SlotRun runs[2]);
+
+// Floor for the hot row limit: more rows than one serve read() can carry,
+// so a row is always journaled before it is sealed
+#define MIN_HOT_ROWS 8192
+
+/**
+ * Keep at most hotRows rows (0 = any number, else at least MIN_HOT_ROWS)
+ * in memory, and none more than hotSeconds older than the newest (0 = any
+ * age). Nothing is evicted while the history segments are not open.
+ */
+void setHistoryRetention(int hotRows, long hotSeconds);
+
+/**
+ * Seal rows until the hot tier fits the retention limits, dropping rows
+ * an earlier run already sealed. Loaders call it once they are done.
+ */
+void applyHistoryRetention();
+
+/**
+ * Replace the history with count rows starting at firstRow, held in
+ * columns (the snapshot mapping) and used in place until the first append
+ * grows them. Statistics and the history index are left to the caller.
+ */
+void adoptTransactionColumns(const TransactionColumns *columns, int firstRow, int count, int lastId);
+
+/**
+ * Number the next stored row firstRow; the rows before it are in the
+ * history segments. For loading the JSON file, which holds only the rows
+ * that were in memory when it was written.
+ */
+void startTransactionsAt(int firstRow);
+
+/**
+ * Fold a row without storing it (it is in the history segments, or
+ * already stored and being replayed) into txnStatistics, lastTxnId and
+ * the time order, as storing it would have
+ */
+void recordSealedTransaction(const Transaction *txn);
+
+/**
+ * The latest timestamp folded in, and a way to put back the highest
+ * txnId, time order and latest timestamp saved with the history
+ * (restoreHistoryOrder(0, 1, INT64_MIN) starts over)
+ */
+int64_t newestTransactionTime();
+void restoreHistoryOrder(int lastId, int timeOrdered, int64_t newest);
+
+/**
+ * Forget the in-memory history; the allocation is kept for reuse
+ */
+void clearTransactions();
+
+#endif
@@ -0,0 +1,25 @@
+/**
+ * Utilities for Fraud Detection System
+ */
+
+#include <time.h>
+#include <unistd.h>
+#include "util.h"
+
+double monotonicSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int writeAll(int fd, const void *data, size_t length) {
+    const char *p = data;
+
+    while (length > 0) {
+        ssize_t written = write(fd, p, length);
+        if (written < 0) return 0;
+        p += written;
+        length -= (size_t)written;
+    }
+    return 1;
+}
@@ -0,0 +1,21 @@
+/**
+ * Utilities for Fraud Detection System
+ * Small system helpers shared by the engine modules
+ */
+
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stddef.h>
+
+/**
+ * Seconds on the monotonic clock, for measuring durations
+ */
+double monotonicSeconds();
+
+/**
+ * Write the whole buffer, continuing after short writes. Returns 0 on error.
+ */
+int writeAll(int fd, const void *data, size_t length);
+
+#endif